@@ -0,0 +1,13 @@
+# Benchmark of the field computations of the engine (fails if they allocate)
+
+QT       += core gui widgets
+
+CONFIG += console c++14
+CONFIG -= app_bundle
+
+TARGET = fieldmath-bench
+
+include(../../Source/engine.pri)
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,198 @@
+#include "building.h"
+#include "emitter.h"
+#include "receiver.h"
+#include "simulationhandler.h"
+#include "simulationscene.h"
+#include "walls.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+// Number of iterations (each one computes a LOS and a reflected ray path)
+#define ITERATIONS_COUNT    1000000
+
+// Properties of the emitter and receiver
+#define BENCH_FREQUENCY     27e9    // Hz
+#define BENCH_EIRP          2.0     // Watts
+
+
+// Count of the heap allocations made by the measuring thread (the other threads of
+// Qt are ignored). The Qt containers allocate with malloc(), so malloc() itself is
+// counted with the GNU C library. Elsewhere, only operator new is counted.
+static std::atomic<unsigned long> g_allocations(0);
+static thread_local bool t_counting = false;
+
+#if defined(__GLIBC__)
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *p, size_t size);
+
+void *malloc(size_t size) {
+    if (t_counting)
+        g_allocations++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    if (t_counting)
+        g_allocations++;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *p, size_t size) {
+    if (t_counting)
+        g_allocations++;
+    return __libc_realloc(p, size);
+}
+}
+#else
+void *operator new(std::size_t size) {
+    if (t_counting)
+        g_allocations++;
+
+    void *p = malloc(size);
+    if (p == nullptr)
+        throw std::bad_alloc();
+
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    free(p);
+}
+#endif
+
+
+/**
+ * @brief findWall
+ * @param walls
+ * @param y
+ * @return
+ *
+ * Returns the horizontal wall at the given ordinate (in meters), or nullptr
+ */
+static Wall *findWall(const QList<Wall*> &walls, double y) {
+    foreach (Wall *w, walls) {
+        const QLineF &line = w->getRealLine();
+
+        if (line.y1() == y && line.y2() == y)
+            return w;
+    }
+
+    return nullptr;
+}
+
+int main(int argc, char *argv[])
+{
+    // The scene is never shown, so no display is needed
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication app(argc, argv);
+
+    const qreal scale = SimulationScene::simulationScale();
+
+    SimulationData *sim_data = SimulationHandler::simulationData();
+    sim_data->resetDefaults();
+
+    // Street canyon between two buildings (in meters): the street is from y=10 to y=20
+    SimulationScene *scene = new SimulationScene();
+
+    foreach (const QRectF &rect, QList<QRectF>() << QRectF(0, 0, 100, 10) << QRectF(0, 20, 100, 10)) {
+        Building *b = new Building(QRectF(rect.topLeft() * scale, rect.size() * scale));
+        sim_data->attachBuilding(b);
+        scene->addItem(b);
+    }
+
+    Emitter *e = new Emitter(BENCH_FREQUENCY, BENCH_EIRP, 1.0, AntennaType::HalfWaveDipoleVert);
+    e->setPos(QPointF(20, 15) * scale);
+    sim_data->attachEmitter(e);
+    scene->addItem(e);
+
+    Receiver *r = new Receiver(AntennaType::HalfWaveDipoleVert);
+    r->setPos(QPointF(80, 15) * scale);
+    scene->addItem(r);
+
+    // Build the walls of the engine (the emitter is prepared alone)
+    SimulationHandler handler;
+    handler.prepareEmittersCoverage(scene->simulationBoundingRect(), QList<Emitter*>() << e);
+
+    // Walls of the street, and the images of a path reflected 3 times (south, north, south)
+    Wall *south = findWall(handler.getWallsList(), 10);
+    Wall *north = findWall(handler.getWallsList(), 20);
+
+    if (south == nullptr || north == nullptr) {
+        fprintf(stderr, "error: the walls of the street were not found\n");
+        return EXIT_FAILURE;
+    }
+
+    QList<Wall*> walls = QList<Wall*>() << south << north << south;
+    QList<QPointF> images;
+    QPointF source = e->getRealPos();
+
+    foreach (Wall *w, walls) {
+        source = SimulationHandler::mirror(source, w);
+        images.append(source);
+    }
+
+    // The buffer keeps its capacity when cleared, so it is filled once before the measure
+    RayPathBuffer buffer;
+    handler.computeRayPath(e, r, &buffer);
+    handler.computeRayPath(e, r, &buffer, images, walls);
+
+    if (buffer.records.size() != 2) {
+        fprintf(stderr, "error: the ray paths of the benchmark are not valid\n");
+        return EXIT_FAILURE;
+    }
+
+    double power = 0;
+
+    const unsigned long alloc_start = g_allocations;
+    QElapsedTimer timer;
+    timer.start();
+    t_counting = true;
+
+    // Field pipeline of the engine: ray paths, reflection coefficients, nominal
+    // fields, and the received power (effective height of the receiver)
+    for (int i = 0 ; i < ITERATIONS_COUNT ; i++) {
+        buffer.clear();
+
+        handler.computeRayPath(e, r, &buffer);
+        handler.computeRayPath(e, r, &buffer, images, walls);
+
+        for (int k = 0 ; k < buffer.records.size() ; k++) {
+            power += r->getRayPower(buffer.records.at(k));
+        }
+    }
+
+    t_counting = false;
+    const double ms = timer.nsecsElapsed() / 1e6;
+    const unsigned long allocations = g_allocations - alloc_start;
+    const int paths = 2 * ITERATIONS_COUNT;
+
+    printf("field pipeline: %8.1f ms, %8.2f Mpaths/s, %10lu allocations (checksum %.6e)\n",
+           ms, paths / ms / 1e3, allocations, power);
+
+    handler.resetComputedData();
+    sim_data->reset();
+    delete scene;
+
+    // The field computations must not allocate anything
+    if (allocations != 0) {
+        fprintf(stderr, "error: the field computations made %lu heap allocations\n", allocations);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
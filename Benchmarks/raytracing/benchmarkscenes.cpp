@@ -0,0 +1,152 @@
+#include "benchmarkscenes.h"
+
+#include <random>
+
+// Dimensions of the street canyon
+#define CANYON_STREET_WIDTH     20.0    // Meters
+#define CANYON_BLOCK_LENGTH     50.0    // Meters
+#define CANYON_BLOCK_DEPTH      30.0    // Meters
+#define CANYON_ALLEY_WIDTH      5.0     // Meters
+
+// Dimensions of the Manhattan grid
+#define GRID_BLOCK_SIZE         40.0    // Meters
+#define GRID_STREET_WIDTH       12.0    // Meters
+
+// Dimensions of the Rue de la Loi replica
+#define LOI_LENGTH              1000.0  // Meters
+#define LOI_STREET_WIDTH        22.0    // Meters
+#define LOI_CROSSING_WIDTH      12.0    // Meters
+#define LOI_BLOCK_DEPTH         110.0   // Meters
+
+
+/**
+ * @brief makeStreetCanyon
+ * @param blocks
+ * @return
+ *
+ * A straight street with 'blocks' buildings on each side, separated by narrow alleys.
+ * The emitter is at one end of the street.
+ */
+BenchmarkScene makeStreetCanyon(int blocks) {
+    BenchmarkScene scene;
+    scene.name = "street_canyon";
+
+    const double step = CANYON_BLOCK_LENGTH + CANYON_ALLEY_WIDTH;
+
+    for (int i = 0 ; i < blocks ; i++) {
+        const double x = i * step;
+
+        scene.buildings.append(QRectF(x, -CANYON_BLOCK_DEPTH, CANYON_BLOCK_LENGTH, CANYON_BLOCK_DEPTH));
+        scene.buildings.append(QRectF(x, CANYON_STREET_WIDTH, CANYON_BLOCK_LENGTH, CANYON_BLOCK_DEPTH));
+    }
+
+    scene.emitter = QPointF(5.0, CANYON_STREET_WIDTH / 2.0);
+    scene.bounds  = QRectF(0, 0, blocks * step - CANYON_ALLEY_WIDTH, CANYON_STREET_WIDTH);
+
+    return scene;
+}
+
+/**
+ * @brief makeManhattanGrid
+ * @param blocks
+ * @return
+ *
+ * A square grid of blocks x blocks buildings, separated by streets.
+ * The emitter is at the intersection closest to the center of the grid.
+ */
+BenchmarkScene makeManhattanGrid(int blocks) {
+    BenchmarkScene scene;
+    scene.name = "manhattan_grid";
+
+    const double step = GRID_BLOCK_SIZE + GRID_STREET_WIDTH;
+
+    for (int y = 0 ; y < blocks ; y++) {
+        for (int x = 0 ; x < blocks ; x++) {
+            scene.buildings.append(QRectF(
+                    GRID_STREET_WIDTH + x * step,
+                    GRID_STREET_WIDTH + y * step,
+                    GRID_BLOCK_SIZE,
+                    GRID_BLOCK_SIZE));
+        }
+    }
+
+    const double center = (blocks / 2) * step + GRID_STREET_WIDTH / 2.0;
+
+    scene.emitter = QPointF(center, center);
+    scene.bounds  = QRectF(0, 0, blocks * step + GRID_STREET_WIDTH, blocks * step + GRID_STREET_WIDTH);
+
+    return scene;
+}
+
+/**
+ * @brief makeRueDeLaLoi
+ * @return
+ *
+ * An approximation of the Rue de la Loi/Wetstraat (Brussels): a wide main street
+ * with crossing streets at irregular intervals, as in the scenario of the project.
+ * The emitter is in the main street, close to the Rue de la Science crossing.
+ */
+BenchmarkScene makeRueDeLaLoi() {
+    BenchmarkScene scene;
+    scene.name = "rue_de_la_loi";
+
+    // Position of the crossing streets along the main street
+    const QList<double> crossings = QList<double>() << 120 << 265 << 380 << 520 << 610 << 760 << 890;
+
+    double block_start = 0;
+
+    for (int i = 0 ; i <= crossings.size() ; i++) {
+        const double block_end = (i < crossings.size() ? crossings[i] : LOI_LENGTH);
+
+        // Blocks on the north and south sides of the main street
+        scene.buildings.append(QRectF(
+                block_start, -LOI_BLOCK_DEPTH, block_end - block_start, LOI_BLOCK_DEPTH));
+        scene.buildings.append(QRectF(
+                block_start, LOI_STREET_WIDTH, block_end - block_start, LOI_BLOCK_DEPTH));
+
+        block_start = block_end + LOI_CROSSING_WIDTH;
+    }
+
+    scene.emitter = QPointF(500.0, LOI_STREET_WIDTH / 2.0);
+    scene.bounds  = QRectF(0, -LOI_BLOCK_DEPTH, LOI_LENGTH, 2 * LOI_BLOCK_DEPTH + LOI_STREET_WIDTH);
+
+    return scene;
+}
+
+/**
+ * @brief makeReceiverPositions
+ * @param scene
+ * @param count
+ * @param seed
+ * @return
+ *
+ * This function returns 'count' pseudo-random positions in the streets of the scene.
+ * The positions only depend on the seed, so the benchmarks are reproducible.
+ */
+QList<QPointF> makeReceiverPositions(const BenchmarkScene &scene, int count, unsigned int seed) {
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> dist_x(scene.bounds.left(), scene.bounds.right());
+    std::uniform_real_distribution<double> dist_y(scene.bounds.top(), scene.bounds.bottom());
+
+    QList<QPointF> positions;
+
+    while (positions.size() < count) {
+        const QPointF pos(dist_x(generator), dist_y(generator));
+
+        // Skip the positions inside a building
+        bool in_building = false;
+
+        foreach (const QRectF &b, scene.buildings) {
+            if (b.contains(pos)) {
+                in_building = true;
+                break;
+            }
+        }
+
+        if (!in_building) {
+            positions.append(pos);
+        }
+    }
+
+    return positions;
+}
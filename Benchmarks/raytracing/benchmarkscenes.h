@@ -0,0 +1,23 @@
+#ifndef BENCHMARKSCENES_H
+#define BENCHMARKSCENES_H
+
+#include <QList>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+
+// Description of a benchmark scene (all dimensions in meters)
+struct BenchmarkScene {
+    QString name;
+    QList<QRectF> buildings;
+    QPointF emitter;
+    QRectF bounds;      // Area where the receivers are placed
+};
+
+BenchmarkScene makeStreetCanyon(int blocks);
+BenchmarkScene makeManhattanGrid(int blocks);
+BenchmarkScene makeRueDeLaLoi();
+
+QList<QPointF> makeReceiverPositions(const BenchmarkScene &scene, int count, unsigned int seed);
+
+#endif // BENCHMARKSCENES_H
@@ -0,0 +1,328 @@
+#include "benchmarkscenes.h"
+#include "segmentkernel.h"
+#include "simulationhandler.h"
+#include "simulationscene.h"
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QSysInfo>
+#include <QTextStream>
+#include <QThread>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Properties of the emitter and receivers of all benchmarks
+#define BENCH_FREQUENCY     27e9    // Hz
+#define BENCH_EIRP          2.0     // Watts
+#define BENCH_SEED          5415
+
+
+// One benchmark case: a scene, a number of receivers and a number of reflections
+struct BenchmarkCase {
+    QString sweep;
+    BenchmarkScene scene;
+    int receivers;
+    int reflections;
+};
+
+
+/**
+ * @brief peakRssKb
+ * @return
+ *
+ * Returns the peak resident set size of the process (in kB).
+ * It never decreases, so each case is run in its own process (see runCaseProcess).
+ */
+static qint64 peakRssKb() {
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS pmc;
+    GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc));
+    return pmc.PeakWorkingSetSize / 1024;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(Q_OS_MACOS)
+    return usage.ru_maxrss / 1024;  // Bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+/**
+ * @brief runCase
+ * @param handler
+ * @param bench
+ * @return
+ *
+ * This function runs the simulation of one benchmark case (in point receivers mode)
+ * and returns its measurements.
+ */
+static QJsonObject runCase(SimulationHandler *handler, const BenchmarkCase &bench) {
+    const qreal scale = SimulationScene::simulationScale();
+
+    SimulationData *sim_data = SimulationHandler::simulationData();
+    sim_data->resetDefaults();
+    sim_data->setSimulationType(SimType::PointReceiver);
+    sim_data->setReflectionsCount(bench.reflections);
+
+    // Create the items of the scene (in pixels)
+    SimulationScene *scene = new SimulationScene();
+
+    foreach (const QRectF &rect, bench.scene.buildings) {
+        Building *b = new Building(QRectF(rect.topLeft() * scale, rect.size() * scale));
+        sim_data->attachBuilding(b);
+        scene->addItem(b);
+    }
+
+    Emitter *e = new Emitter(BENCH_FREQUENCY, BENCH_EIRP, 1.0, AntennaType::HalfWaveDipoleVert);
+    e->setPos(bench.scene.emitter * scale);
+    sim_data->attachEmitter(e);
+    scene->addItem(e);
+
+    QList<Receiver*> rcv_list;
+
+    foreach (const QPointF &pos, makeReceiverPositions(bench.scene, bench.receivers, BENCH_SEED)) {
+        Receiver *r = new Receiver(AntennaType::HalfWaveDipoleVert);
+        r->setPos(pos * scale);
+        scene->addItem(r);
+        rcv_list.append(r);
+    }
+
+    // Run the simulation and wait for its end
+    QEventLoop loop;
+    QObject::connect(handler, SIGNAL(simulationFinished()), &loop, SLOT(quit()));
+
+    QElapsedTimer timer;
+    timer.start();
+
+    handler->startSimulationComputation(rcv_list, scene->simulationBoundingRect());
+
+    if (handler->isRunning()) {
+        loop.exec();
+    }
+
+    const double time_s = timer.nsecsElapsed() / 1e9;
+
+    // Count the computed ray paths and their rays (lines)
+    qint64 paths = 0;
+    qint64 rays = 0;
+
+    foreach (Receiver *r, rcv_list) {
+        foreach (const RayRecord &rec, r->getRayRecords()) {
+            paths++;
+            rays += rec.vertex_count - 1;
+        }
+    }
+
+    QJsonObject result;
+    result["sweep"]             = bench.sweep;
+    result["scene"]             = bench.scene.name;
+    result["buildings"]         = bench.scene.buildings.size();
+    result["walls"]             = handler->getWallsCount();
+    result["corners"]           = handler->getCornersCount();
+    result["receivers"]         = bench.receivers;
+    result["reflections"]       = bench.reflections;
+    result["time_s"]            = time_s;
+    result["paths"]             = paths;
+    result["rays"]              = rays;
+    result["paths_per_sec"]     = paths / time_s;
+    result["rays_per_sec"]      = rays / time_s;
+    result["receivers_per_sec"] = bench.receivers / time_s;
+    result["peak_rss_kb"]       = peakRssKb();
+
+    // Release the computed data and the items of the scene
+    handler->resetComputedData();
+    sim_data->reset();
+    delete scene;
+
+    return result;
+}
+
+/**
+ * @brief makeCases
+ * @param quick
+ * @return
+ *
+ * This function returns the list of benchmark cases.
+ * Each sweep varies one parameter (reflections, walls or receivers) of a fixed workload.
+ * The quick list only keeps the small cases (for a fast regression check).
+ */
+static QList<BenchmarkCase> makeCases(bool quick) {
+    QList<BenchmarkCase> cases;
+
+    const int max_reflections = (quick ? 2 : 4);
+    const int receivers = (quick ? 100 : 500);
+
+    const QList<BenchmarkScene> scenes = QList<BenchmarkScene>()
+            << makeStreetCanyon(10)
+            << makeManhattanGrid(5)
+            << makeRueDeLaLoi();
+
+    // Reflections count sweep (on each canonical scene)
+    foreach (const BenchmarkScene &scene, scenes) {
+        for (int refl = 0 ; refl <= max_reflections ; refl++) {
+            cases.append({"reflections", scene, receivers, refl});
+        }
+    }
+
+    // Walls count sweep
+    const QList<int> grid_sizes = (quick ? QList<int>() << 2 << 4 : QList<int>() << 2 << 4 << 8 << 12);
+
+    foreach (int size, grid_sizes) {
+        cases.append({"walls", makeManhattanGrid(size), receivers, 2});
+    }
+
+    // Receivers count sweep
+    const QList<int> rcv_counts = (quick ? QList<int>() << 100 << 1000 : QList<int>() << 100 << 1000 << 10000);
+
+    foreach (int count, rcv_counts) {
+        cases.append({"receivers", makeRueDeLaLoi(), count, 2});
+    }
+
+    return cases;
+}
+
+/**
+ * @brief runCaseProcess
+ * @param index
+ * @param arguments
+ * @param result
+ * @param error
+ * @return
+ *
+ * This function runs the benchmark case of the given index in a new process of this
+ * program (--case option), so that its peak memory is not the one of a previous case.
+ * It returns false (and sets the error message) if the process failed.
+ */
+static bool runCaseProcess(int index, const QStringList &arguments, QJsonObject *result, QString *error) {
+    QProcess process;
+    process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    process.start(QCoreApplication::applicationFilePath(),
+                  QStringList(arguments) << "--case" << QString::number(index));
+
+    if (!process.waitForFinished(-1) ||
+            process.exitStatus() != QProcess::NormalExit ||
+            process.exitCode() != EXIT_SUCCESS) {
+        *error = QString("the case %1 failed (%2)").arg(index).arg(process.errorString());
+        return false;
+    }
+
+    const QJsonDocument doc = QJsonDocument::fromJson(process.readAllStandardOutput());
+
+    if (!doc.isObject()) {
+        *error = QString("invalid output of the case %1").arg(index);
+        return false;
+    }
+
+    *result = doc.object();
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    // The scene is never shown, so no display is needed
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks of the ray-tracing engine on canonical scenes (JSON output).");
+    parser.addHelpOption();
+
+    QCommandLineOption quick_opt("quick", "Only run the small cases.");
+    QCommandLineOption reciprocity_opt("reciprocity", "Trace the reflections from the emitters.");
+    QCommandLineOption output_opt(
+                QStringList() << "o" << "output",
+                "Output JSON file (default: standard output).",
+                "file");
+
+    QCommandLineOption case_opt(
+                "case",
+                "Only run the case of the given index (JSON object output).",
+                "index");
+
+    parser.addOption(quick_opt);
+    parser.addOption(reciprocity_opt);
+    parser.addOption(output_opt);
+    parser.addOption(case_opt);
+    parser.process(a);
+
+    SimulationHandler handler;
+    handler.setReciprocityMode(parser.isSet(reciprocity_opt));
+
+    const QList<BenchmarkCase> cases = makeCases(parser.isSet(quick_opt));
+
+    // Run a single case (in the process started for it by runCaseProcess)
+    if (parser.isSet(case_opt)) {
+        bool ok;
+        const int index = parser.value(case_opt).toInt(&ok);
+
+        if (!ok || index < 0 || index >= cases.size()) {
+            QTextStream(stderr) << "error: invalid case index " << parser.value(case_opt) << endl;
+            return EXIT_FAILURE;
+        }
+
+        QTextStream(stdout) << QJsonDocument(runCase(&handler, cases.at(index))).toJson(QJsonDocument::Compact);
+        return EXIT_SUCCESS;
+    }
+
+    // Run each case in its own process, with the same options
+    QStringList arguments;
+
+    if (parser.isSet(quick_opt)) arguments << "--quick";
+    if (parser.isSet(reciprocity_opt)) arguments << "--reciprocity";
+
+    QJsonArray results;
+
+    for (int i = 0 ; i < cases.size() ; i++) {
+        QJsonObject result;
+        QString error;
+
+        if (!runCaseProcess(i, arguments, &result, &error)) {
+            QTextStream(stderr) << "error: " << error << endl;
+            return EXIT_FAILURE;
+        }
+
+        results.append(result);
+    }
+
+    QJsonObject report;
+    report["threads"]   = QThread::idealThreadCount();
+    report["cpu"]       = QSysInfo::currentCpuArchitecture();
+    report["kernel"]    = SegmentKernel::name();
+    report["reciprocity"] = handler.reciprocityMode();
+    report["os"]        = QSysInfo::prettyProductName();
+    report["seed"]      = BENCH_SEED;
+    report["results"]   = results;
+
+    const QByteArray json = QJsonDocument(report).toJson();
+
+    if (parser.isSet(output_opt)) {
+        QFile file(parser.value(output_opt));
+
+        if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size()) {
+            QTextStream(stderr) << "error: unable to write into " << parser.value(output_opt) << endl;
+            return EXIT_FAILURE;
+        }
+    }
+    else {
+        QTextStream(stdout) << json;
+    }
+
+    return EXIT_SUCCESS;
+}
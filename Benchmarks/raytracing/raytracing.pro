@@ -0,0 +1,19 @@
+# Benchmarks of the ray-tracing engine (JSON output)
+
+QT       += core gui widgets
+
+CONFIG += console c++14
+CONFIG -= app_bundle
+
+TARGET = raytracing-bench
+
+include(../../Source/engine.pri)
+
+SOURCES += \
+    benchmarkscenes.cpp \
+    main.cpp
+
+HEADERS += \
+    benchmarkscenes.h
+
+win32: LIBS += -lpsapi
@@ -0,0 +1,20 @@
+QT       += core gui widgets
+
+CONFIG += console c++14
+CONFIG -= app_bundle
+
+TARGET = 5grt-cli
+
+include(../Source/engine.pri)
+
+SOURCES += \
+    clirunner.cpp \
+    main.cpp
+
+HEADERS += \
+    clirunner.h
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
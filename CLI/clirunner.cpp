@@ -0,0 +1,274 @@
+#include "clirunner.h"
+#include "simulationarea.h"
+#include "analysisline.h"
+
+#include <QEventLoop>
+#include <QFile>
+
+#include <QDebug>
+
+
+CliRunner::CliRunner() : QObject()
+{
+    m_simulation_handler = new SimulationHandler();
+    m_scene = new SimulationScene();
+
+    m_sim_area_item = nullptr;
+    m_analysis_line = nullptr;
+
+    m_last_progress = -1;
+
+    connect(m_simulation_handler, SIGNAL(simulationProgress(double)), this, SLOT(simulationProgress(double)));
+}
+
+CliRunner::~CliRunner()
+{
+    // Release the computed data before deleting the receivers
+    m_simulation_handler->resetComputedData();
+
+    // The simulation area and the analysis line delete their receivers
+    delete m_sim_area_item;
+    delete m_analysis_line;
+
+    // Delete the buildings, emitters and receivers of the project (items of the scene)
+    SimulationHandler::simulationData()->reset();
+    delete m_scene;
+
+    delete m_simulation_handler;
+}
+
+QString CliRunner::errorString() const {
+    return m_error;
+}
+
+/**
+ * @brief CliRunner::setReciprocityMode
+ * @param enabled
+ *
+ * This function traces the reflections from the emitters (same results,
+ * faster with many receivers)
+ */
+void CliRunner::setReciprocityMode(bool enabled) {
+    m_simulation_handler->setReciprocityMode(enabled);
+}
+
+/**
+ * @brief CliRunner::loadProject
+ * @param file_path
+ * @return
+ *
+ * This function reads a project file (as saved by the main window)
+ * and places its items in the simulation scene.
+ */
+bool CliRunner::loadProject(const QString &file_path) {
+    QFile file(file_path);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_error = QString("Unable to open file for reading: %1").arg(file_path);
+        return false;
+    }
+
+    // The view rect and scale are only used by the main window
+    QRectF view_rect;
+    qreal view_scale;
+
+    QDataStream in(&file);
+    in >> view_rect;
+    in >> view_scale;
+    in >> SimulationHandler::simulationData();
+
+    file.close();
+
+    if (in.status() != QDataStream::Ok) {
+        m_error = QString("Invalid project file: %1").arg(file_path);
+        return false;
+    }
+
+    // Place the items in the scene (needed to compute their real positions)
+    foreach (Building* b, SimulationHandler::simulationData()->getBuildingsList()) {
+        m_scene->addItem(b);
+    }
+    foreach (Emitter* e, SimulationHandler::simulationData()->getEmittersList()) {
+        m_scene->addItem(e);
+    }
+    foreach (Receiver* r, SimulationHandler::simulationData()->getReceiverList()) {
+        m_scene->addItem(r);
+    }
+
+    return true;
+}
+
+/**
+ * @brief CliRunner::makeReceivers
+ *
+ * This function returns the receivers to compute for the given simulation type
+ * (the receivers of the project, or the receivers of an area or a line).
+ * The area and the line are given in meters.
+ */
+QList<Receiver*> CliRunner::makeReceivers(
+        SimType::SimType type,
+        AntennaType::AntennaType antenna_type,
+        QRectF real_area,
+        QLineF real_line)
+{
+    const qreal scale = SimulationScene::simulationScale();
+
+    switch (type) {
+    case SimType::PointReceiver:
+        return SimulationHandler::simulationData()->getReceiverList();
+
+    case SimType::AreaReceiver: {
+        QRectF area(real_area.topLeft() * scale, real_area.size() * scale);
+
+        m_sim_area_item = new SimulationArea();
+        m_scene->addItem((SimulationItem*) m_sim_area_item);
+        m_sim_area_item->setArea(antenna_type, area);
+
+        return m_sim_area_item->getReceiversList();
+    }
+    case SimType::Analysis1D: {
+        QLineF line(real_line.p1() * scale, real_line.p2() * scale);
+
+        m_analysis_line = new AnalysisLine(line);
+        m_scene->addItem(m_analysis_line);
+        m_analysis_line->createReceivers(antenna_type);
+
+        return m_analysis_line->getReceiversList();
+    }
+    default:
+        return QList<Receiver*>();
+    }
+}
+
+/**
+ * @brief CliRunner::run
+ * @return
+ *
+ * This function runs a simulation and waits for its end.
+ * It returns false if the simulation can't be started or was cancelled.
+ */
+bool CliRunner::run(
+        SimType::SimType type,
+        AntennaType::AntennaType antenna_type,
+        QRectF real_area,
+        QLineF real_line)
+{
+    // Check the minimal requirements for this simulation type
+    if (type == SimType::CoverageOptim) {
+        m_error = "The coverage optimization is not supported by the command-line runner";
+        return false;
+    }
+    if (SimulationHandler::simulationData()->getEmittersList().size() < 1) {
+        m_error = "The project must contain at least one emitter";
+        return false;
+    }
+    if (type == SimType::PointReceiver && SimulationHandler::simulationData()->getReceiverList().size() < 1) {
+        m_error = "The project must contain at least one receiver for a point simulation";
+        return false;
+    }
+    if (type == SimType::AreaReceiver && real_area.isEmpty()) {
+        m_error = "An area is needed for an area simulation";
+        return false;
+    }
+    if (type == SimType::Analysis1D && real_line.length() == 0) {
+        m_error = "A line is needed for a 1D analysis";
+        return false;
+    }
+
+    SimulationHandler::simulationData()->setSimulationType(type);
+
+    m_receivers_list = makeReceivers(type, antenna_type, real_area, real_line);
+
+    // Same bounding rect as the main window
+    QRectF sim_rect;
+
+    if (type == SimType::AreaReceiver) {
+        sim_rect = m_sim_area_item->getArea();
+    }
+    else {
+        sim_rect = m_scene->simulationBoundingRect();
+    }
+
+    // Wait for the end of the simulation
+    QEventLoop loop;
+    connect(m_simulation_handler, SIGNAL(simulationFinished()), &loop, SLOT(quit()));
+    connect(m_simulation_handler, SIGNAL(simulationCancelled()), &loop, SLOT(quit()));
+
+    m_simulation_handler->startSimulationComputation(m_receivers_list, sim_rect);
+
+    // The simulation may be finished immediately (no receiver)
+    if (m_simulation_handler->isRunning()) {
+        loop.exec();
+    }
+
+    if (!m_simulation_handler->isDone()) {
+        m_error = "The simulation was cancelled";
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief CliRunner::writeResults
+ * @param file_path
+ * @return
+ *
+ * This function writes the results of each computed receiver in a CSV file.
+ * The positions are in meters, the power in dBm, the SNR in dB, the delay spread
+ * in seconds and the Rice factor in dB. The results of an out of model receiver are empty.
+ */
+bool CliRunner::writeResults(const QString &file_path) {
+    QFile file(file_path);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        m_error = QString("Unable to open file for writing: %1").arg(file_path);
+        return false;
+    }
+
+    // Put the results into the file
+    QString csv_content("x,y,power_dbm,snr_db,delay_spread_s,mean_excess_delay_s,rms_delay_spread_s,rice_factor_db,out_of_model\n");
+
+    foreach (Receiver *r, m_receivers_list) {
+        const QPointF pos = r->getRealPos();
+
+        csv_content.append(QString("%1,%2,").arg(pos.x(), 0, 'f', 3).arg(pos.y(), 0, 'f', 3));
+
+        if (r->outOfModel()) {
+            csv_content.append(",,,,,,1\n");
+            continue;
+        }
+
+        csv_content.append(QString("%1,%2,%3,%4,%5,%6,0\n")
+                           .arg(SimulationData::convertPowerTodBm(r->receivedPower()), 0, 'f', 6)
+                           .arg(r->userEndSNR(), 0, 'f', 6)
+                           .arg(r->delaySpread(), 0, 'g', 10)
+                           .arg(r->meanExcessDelay(), 0, 'g', 10)
+                           .arg(r->rmsDelaySpread(), 0, 'g', 10)
+                           .arg(r->riceFactor(), 0, 'f', 6));
+    }
+
+    // Write content to file (all of it, or the file is incomplete)
+    const QByteArray data = csv_content.toUtf8();
+    const bool written = (file.write(data) == data.size() && file.flush());
+
+    // Close the file
+    file.close();
+
+    if (!written) {
+        m_error = QString("Unable to write into the file: %1").arg(file_path);
+        return false;
+    }
+
+    return true;
+}
+
+void CliRunner::simulationProgress(double p) {
+    // Log the progress by steps of 10%
+    const int progress = (int) (p * 10) * 10;
+
+    if (progress != m_last_progress) {
+        m_last_progress = progress;
+        qInfo().noquote() << QString("Progress: %1%").arg(progress);
+    }
+}
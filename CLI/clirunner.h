@@ -0,0 +1,59 @@
+#ifndef CLIRUNNER_H
+#define CLIRUNNER_H
+
+#include <QObject>
+#include <QLineF>
+#include <QRectF>
+
+#include "simulationhandler.h"
+#include "simulationscene.h"
+#include "antennas.h"
+
+class SimulationArea;
+class AnalysisLine;
+
+// Runs a simulation of a saved project without the main window.
+// The items of the project are placed in a simulation scene that is never shown.
+class CliRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    CliRunner();
+    ~CliRunner();
+
+    bool loadProject(const QString &file_path);
+    void setReciprocityMode(bool enabled);
+
+    bool run(SimType::SimType type,
+             AntennaType::AntennaType antenna_type,
+             QRectF real_area = QRectF(),
+             QLineF real_line = QLineF());
+
+    bool writeResults(const QString &file_path);
+
+    QString errorString() const;
+
+private slots:
+    void simulationProgress(double p);
+
+private:
+    QList<Receiver*> makeReceivers(
+            SimType::SimType type,
+            AntennaType::AntennaType antenna_type,
+            QRectF real_area,
+            QLineF real_line);
+
+    SimulationHandler *m_simulation_handler;
+    SimulationScene *m_scene;
+
+    SimulationArea *m_sim_area_item;
+    AnalysisLine *m_analysis_line;
+
+    QList<Receiver*> m_receivers_list;
+    int m_last_progress;
+
+    QString m_error;
+};
+
+#endif // CLIRUNNER_H
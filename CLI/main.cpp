@@ -0,0 +1,190 @@
+#include "clirunner.h"
+#include "profiler.h"
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+
+// Exit codes of the runner
+#define EXIT_BAD_ARGUMENTS      1
+#define EXIT_LOAD_ERROR         2
+#define EXIT_SIMULATION_ERROR   3
+#define EXIT_WRITE_ERROR        4
+
+
+static int fail(int code, const QString &message) {
+    QTextStream(stderr) << "error: " << message << endl;
+    return code;
+}
+
+// Parses a list of 4 comma-separated numbers
+static bool parseNumbers(const QString &str, double values[4]) {
+    const QStringList parts = str.split(',');
+
+    if (parts.size() != 4)
+        return false;
+
+    for (int i = 0 ; i < 4 ; i++) {
+        bool ok;
+        values[i] = parts[i].trimmed().toDouble(&ok);
+
+        if (!ok)
+            return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    // The scene is never shown, so no display is needed
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs a simulation of a 5G RayTracing project without the user interface.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("project", "Project file (.5grt) to simulate.");
+
+    QCommandLineOption type_opt(
+                QStringList() << "t" << "type",
+                "Simulation type: point, area or line (default: type saved in the project).",
+                "type");
+    QCommandLineOption area_opt(
+                "area",
+                "Simulation area for an area simulation, in meters.",
+                "x,y,width,height");
+    QCommandLineOption line_opt(
+                "line",
+                "Analysis line for a 1D simulation, in meters.",
+                "x1,y1,x2,y2");
+    QCommandLineOption antenna_opt(
+                "antenna",
+                "Antenna of the area and line receivers: vertical or horizontal (default: vertical).",
+                "antenna",
+                "vertical");
+    QCommandLineOption output_opt(
+                QStringList() << "o" << "output",
+                "Output CSV file (default: project file with the .csv extension).",
+                "file");
+    QCommandLineOption reciprocity_opt(
+                "reciprocity",
+                "Trace the reflections from the emitters (same results, faster with many receivers).");
+    QCommandLineOption trace_opt(
+                "trace",
+                "Chrome trace (JSON) of the engine stages (only with a profiling build).",
+                "file");
+
+    parser.addOption(type_opt);
+    parser.addOption(area_opt);
+    parser.addOption(line_opt);
+    parser.addOption(antenna_opt);
+    parser.addOption(output_opt);
+    parser.addOption(reciprocity_opt);
+    parser.addOption(trace_opt);
+
+    parser.process(a);
+
+    if (parser.positionalArguments().size() != 1) {
+        return fail(EXIT_BAD_ARGUMENTS, "exactly one project file is expected (see --help)");
+    }
+
+    const QString project_path = parser.positionalArguments().first();
+
+    // Antenna of the generated receivers
+    AntennaType::AntennaType antenna_type;
+
+    if (parser.value(antenna_opt) == "vertical") {
+        antenna_type = AntennaType::HalfWaveDipoleVert;
+    }
+    else if (parser.value(antenna_opt) == "horizontal") {
+        antenna_type = AntennaType::HalfWaveDipoleHoriz;
+    }
+    else {
+        return fail(EXIT_BAD_ARGUMENTS, "unknown antenna: " + parser.value(antenna_opt));
+    }
+
+    // Area and line of the simulation (in meters)
+    double values[4];
+    QRectF area;
+    QLineF line;
+
+    if (parser.isSet(area_opt)) {
+        if (!parseNumbers(parser.value(area_opt), values)) {
+            return fail(EXIT_BAD_ARGUMENTS, "invalid area: " + parser.value(area_opt));
+        }
+
+        area = QRectF(values[0], values[1], values[2], values[3]);
+    }
+    if (parser.isSet(line_opt)) {
+        if (!parseNumbers(parser.value(line_opt), values)) {
+            return fail(EXIT_BAD_ARGUMENTS, "invalid line: " + parser.value(line_opt));
+        }
+
+        line = QLineF(values[0], values[1], values[2], values[3]);
+    }
+
+    if (parser.isSet(trace_opt) && !Profiler::isEnabled()) {
+        return fail(EXIT_BAD_ARGUMENTS, "the profiling is not compiled (build with CONFIG+=profiling)");
+    }
+
+    // Output file
+    QString output_path = parser.value(output_opt);
+
+    if (output_path.isEmpty()) {
+        const QFileInfo info(project_path);
+        output_path = info.dir().filePath(info.completeBaseName() + ".csv");
+    }
+
+    CliRunner runner;
+
+    if (!runner.loadProject(project_path)) {
+        return fail(EXIT_LOAD_ERROR, runner.errorString());
+    }
+
+    // Simulation type (the one of the project by default)
+    SimType::SimType sim_type = SimulationHandler::simulationData()->simulationType();
+
+    if (parser.isSet(type_opt)) {
+        const QString type = parser.value(type_opt);
+
+        if (type == "point") {
+            sim_type = SimType::PointReceiver;
+        }
+        else if (type == "area") {
+            sim_type = SimType::AreaReceiver;
+        }
+        else if (type == "line") {
+            sim_type = SimType::Analysis1D;
+        }
+        else {
+            return fail(EXIT_BAD_ARGUMENTS, "unknown simulation type: " + type);
+        }
+    }
+
+    runner.setReciprocityMode(parser.isSet(reciprocity_opt));
+
+    if (!runner.run(sim_type, antenna_type, area, line)) {
+        return fail(EXIT_SIMULATION_ERROR, runner.errorString());
+    }
+
+    if (!runner.writeResults(output_path)) {
+        return fail(EXIT_WRITE_ERROR, runner.errorString());
+    }
+
+    if (parser.isSet(trace_opt)) {
+        QFile trace_file(parser.value(trace_opt));
+        const QByteArray json = Profiler::instance()->chromeTrace();
+
+        if (!trace_file.open(QIODevice::WriteOnly) || trace_file.write(json) != json.size()) {
+            return fail(EXIT_WRITE_ERROR, "unable to write into " + parser.value(trace_opt));
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
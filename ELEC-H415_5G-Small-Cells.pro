@@ -8,62 +8,30 @@ CONFIG += c++14
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+include(Source/engine.pri)
+
 SOURCES += \
     Source/analysisdialog.cpp \
-    Source/analysisline.cpp \
-    Source/antennas.cpp \
-    Source/building.cpp \
     Source/buildingdialog.cpp \
-    Source/computationunit.cpp \
-    Source/constants.cpp \
-    Source/corner.cpp \
-    Source/coverageoptimizer.cpp \
-    Source/datalegenditem.cpp \
-    Source/emitter.cpp \
     Source/emitterdialog.cpp \
     Source/impulsedialog.cpp \
     Source/main.cpp \
     Source/mainwindow.cpp \
     Source/optimizerdialog.cpp \
-    Source/raypath.cpp \
-    Source/receiver.cpp \
+    Source/profilerdialog.cpp \
     Source/receiverdialog.cpp \
-    Source/scaleruleritem.cpp \
-    Source/simsetupdialog.cpp \
-    Source/simulationarea.cpp \
-    Source/simulationdata.cpp \
-    Source/simulationhandler.cpp \
-    Source/simulationitem.cpp \
-    Source/simulationscene.cpp \
-    Source/walls.cpp
+    Source/simsetupdialog.cpp
 
 HEADERS += \
     Source/analysisdialog.h \
-    Source/analysisline.h \
-    Source/antennas.h \
-    Source/building.h \
     Source/buildingdialog.h \
-    Source/computationunit.h \
-    Source/constants.h \
-    Source/corner.h \
-    Source/coverageoptimizer.h \
-    Source/datalegenditem.h \
-    Source/emitter.h \
     Source/emitterdialog.h \
     Source/impulsedialog.h \
     Source/mainwindow.h \
     Source/optimizerdialog.h \
-    Source/raypath.h \
-    Source/receiver.h \
+    Source/profilerdialog.h \
     Source/receiverdialog.h \
-    Source/scaleruleritem.h \
-    Source/simsetupdialog.h \
-    Source/simulationarea.h \
-    Source/simulationdata.h \
-    Source/simulationhandler.h \
-    Source/simulationitem.h \
-    Source/simulationscene.h \
-    Source/walls.h
+    Source/simsetupdialog.h
 
 FORMS += \
     Source/analysisdialog.ui \
@@ -72,6 +40,7 @@ FORMS += \
     Source/impulsedialog.ui \
     Source/mainwindow.ui \
     Source/optimizerdialog.ui \
+    Source/profilerdialog.ui \
     Source/receiverdialog.ui \
     Source/simsetupdialog.ui
 
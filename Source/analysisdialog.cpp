@@ -41,6 +41,8 @@ AnalysisDialog::AnalysisDialog(QList<Receiver *> rcv_list, QWidget *parent) :
     ui->resultTypeComboBox->addItem("Received power",   ResultType::Power);
     ui->resultTypeComboBox->addItem("SNR at UE",        ResultType::SNR);
     ui->resultTypeComboBox->addItem("Delay spread",     ResultType::DelaySpread);
+    ui->resultTypeComboBox->addItem("Mean excess delay", ResultType::MeanExcessDelay);
+    ui->resultTypeComboBox->addItem("RMS delay spread", ResultType::RmsDelaySpread);
     ui->resultTypeComboBox->addItem("Rice factor",      ResultType::RiceFactor);
     ui->resultTypeComboBox->setCurrentIndex(0);
 
@@ -57,6 +59,8 @@ AnalysisDialog::~AnalysisDialog()
     delete m_power_plot;
     delete m_snr_plot;
     delete m_delay_plot;
+    delete m_mean_delay_plot;
+    delete m_rms_delay_plot;
     delete m_rice_plot;
     delete ui;
 }
@@ -85,6 +89,8 @@ void AnalysisDialog::preparePlotsData() {
     QLineSeries *power_series   = new QLineSeries();
     QLineSeries *snr_series     = new QLineSeries();
     QLineSeries *delay_series   = new QLineSeries();
+    QLineSeries *mean_delay_series = new QLineSeries();
+    QLineSeries *rms_delay_series  = new QLineSeries();
     QLineSeries *rice_series    = new QLineSeries();
 
     // Get the maximal delay spread
@@ -93,7 +99,7 @@ void AnalysisDialog::preparePlotsData() {
     // Look for the max delay spread
     foreach (Receiver *r, m_receivers_list) {
         // Get the delay spread for this receiver
-        tmp_delay = r->delaySpread();
+        tmp_delay = r->metrics().delay_spread;
 
         if (!isnan(tmp_delay) && !isinf(tmp_delay) && tmp_delay > max_delay_val) {
             max_delay_val = tmp_delay;
@@ -107,7 +113,7 @@ void AnalysisDialog::preparePlotsData() {
 
     // Temporary variables for the loop
     double d;
-    double power_val, snr_val, delay_val, rice_val;
+    double power_val, snr_val, delay_val, mean_delay_val, rms_delay_val, rice_val;
 
     for (int i = 1 ; i < m_receivers_list.size() ; i++) {
         // Pointer to the receiver at distance d
@@ -117,10 +123,14 @@ void AnalysisDialog::preparePlotsData() {
         d = i;
 
         // Get and parse the corresponding values
-        power_val   = SimulationData::convertPowerTodBm(r->receivedPower());
-        snr_val     = r->userEndSNR();
-        delay_val   = r->delaySpread() / delay_scale;
-        rice_val    = r->riceFactor();
+        const ReceiverMetrics &m = r->metrics();
+
+        power_val   = SimulationData::convertPowerTodBm(m.received_power);
+        snr_val     = m.user_end_SNR;
+        delay_val   = m.delay_spread / delay_scale;
+        mean_delay_val = m.mean_excess_delay / delay_scale;
+        rms_delay_val  = m.rms_delay_spread / delay_scale;
+        rice_val    = m.rice_factor;
 
         if (!isnan(power_val) && !isinf(power_val)) {
             // Append this data to the plot
@@ -134,6 +144,14 @@ void AnalysisDialog::preparePlotsData() {
             // Append this data to the plot
             *delay_series << QPointF(d, delay_val);
         }
+        if (!isnan(mean_delay_val) && !isinf(mean_delay_val)) {
+            // Append this data to the plot
+            *mean_delay_series << QPointF(d, mean_delay_val);
+        }
+        if (!isnan(rms_delay_val) && !isinf(rms_delay_val)) {
+            // Append this data to the plot
+            *rms_delay_series << QPointF(d, rms_delay_val);
+        }
         if (!isnan(rice_val) && !isinf(rice_val)) {
             // Append this data to the plot
             *rice_series << QPointF(d, rice_val);
@@ -144,64 +162,88 @@ void AnalysisDialog::preparePlotsData() {
     m_power_series  = power_series;
     m_snr_series    = snr_series;
     m_delay_series  = delay_series;
+    m_mean_delay_series = mean_delay_series;
+    m_rms_delay_series  = rms_delay_series;
     m_rice_series   = rice_series;
 
     // Create the plots
     m_power_plot    = new QChart();
     m_snr_plot      = new QChart();
     m_delay_plot    = new QChart();
+    m_mean_delay_plot = new QChart();
+    m_rms_delay_plot  = new QChart();
     m_rice_plot     = new QChart();
 
     // Hide legend
     m_power_plot->legend()->hide();
     m_snr_plot  ->legend()->hide();
     m_delay_plot->legend()->hide();
+    m_mean_delay_plot->legend()->hide();
+    m_rms_delay_plot ->legend()->hide();
     m_rice_plot ->legend()->hide();
 
     // Add prepared data to plots
     m_power_plot->addSeries(power_series);
     m_snr_plot  ->addSeries(snr_series);
     m_delay_plot->addSeries(delay_series);
+    m_mean_delay_plot->addSeries(mean_delay_series);
+    m_rms_delay_plot ->addSeries(rms_delay_series);
     m_rice_plot ->addSeries(rice_series);
 
     QLogValueAxis *power_axisX  = createDistanceAxis();
     QLogValueAxis *snr_axisX    = createDistanceAxis();
     QLogValueAxis *delay_axisX  = createDistanceAxis();
+    QLogValueAxis *mean_delay_axisX = createDistanceAxis();
+    QLogValueAxis *rms_delay_axisX  = createDistanceAxis();
     QLogValueAxis *rice_axisX   = createDistanceAxis();
 
     m_power_plot->addAxis(power_axisX,  Qt::AlignBottom);
     m_snr_plot  ->addAxis(snr_axisX,    Qt::AlignBottom);
     m_delay_plot->addAxis(delay_axisX,  Qt::AlignBottom);
+    m_mean_delay_plot->addAxis(mean_delay_axisX, Qt::AlignBottom);
+    m_rms_delay_plot ->addAxis(rms_delay_axisX,  Qt::AlignBottom);
     m_rice_plot ->addAxis(rice_axisX,   Qt::AlignBottom);
 
     power_series->attachAxis(power_axisX);
     snr_series  ->attachAxis(snr_axisX);
     delay_series->attachAxis(delay_axisX);
+    mean_delay_series->attachAxis(mean_delay_axisX);
+    rms_delay_series ->attachAxis(rms_delay_axisX);
     rice_series ->attachAxis(rice_axisX);
 
     QValueAxis *power_axisY = createValueAxis("Received power [dBm]");
     QValueAxis *snr_axisY   = createValueAxis("SNE at UE [dB]");
     QValueAxis *delay_axisY = createValueAxis("Delay spread [" + delay_units + "]");
+    QValueAxis *mean_delay_axisY = createValueAxis("Mean excess delay [" + delay_units + "]");
+    QValueAxis *rms_delay_axisY  = createValueAxis("RMS delay spread [" + delay_units + "]");
     QValueAxis *rice_axisY  = createValueAxis("Rice factor [dB]");
 
     m_power_plot->addAxis(power_axisY,  Qt::AlignLeft);
     m_snr_plot  ->addAxis(snr_axisY,    Qt::AlignLeft);
     m_delay_plot->addAxis(delay_axisY,  Qt::AlignLeft);
+    m_mean_delay_plot->addAxis(mean_delay_axisY, Qt::AlignLeft);
+    m_rms_delay_plot ->addAxis(rms_delay_axisY,  Qt::AlignLeft);
     m_rice_plot ->addAxis(rice_axisY,   Qt::AlignLeft);
 
     power_series->attachAxis(power_axisY);
     snr_series  ->attachAxis(snr_axisY);
     delay_series->attachAxis(delay_axisY);
+    mean_delay_series->attachAxis(mean_delay_axisY);
+    rms_delay_series ->attachAxis(rms_delay_axisY);
     rice_series ->attachAxis(rice_axisY);
 
     power_axisY->applyNiceNumbers();
     snr_axisY  ->applyNiceNumbers();
     delay_axisY->applyNiceNumbers();
+    mean_delay_axisY->applyNiceNumbers();
+    rms_delay_axisY ->applyNiceNumbers();
     rice_axisY ->applyNiceNumbers();
 
     m_power_plot->setTitle("Received power as a function of the distance");
     m_snr_plot  ->setTitle("SNR as a function of the distance");
     m_delay_plot->setTitle("Delay spread as a function of the distance");
+    m_mean_delay_plot->setTitle("Mean excess delay as a function of the distance");
+    m_rms_delay_plot ->setTitle("RMS delay spread as a function of the distance");
     m_rice_plot ->setTitle("Rice factor as a function of the distance");
 
     // Set title font (large and bold)
@@ -211,6 +253,8 @@ void AnalysisDialog::preparePlotsData() {
     m_power_plot->setTitleFont(font);
     m_snr_plot  ->setTitleFont(font);
     m_delay_plot->setTitleFont(font);
+    m_mean_delay_plot->setTitleFont(font);
+    m_rms_delay_plot ->setTitleFont(font);
     m_rice_plot ->setTitleFont(font);
 }
 
@@ -231,6 +275,14 @@ void AnalysisDialog::selectedTypeChanged() {
         ui->chartView->setChart(m_delay_plot);
         break;
     }
+    case ResultType::MeanExcessDelay: {
+        ui->chartView->setChart(m_mean_delay_plot);
+        break;
+    }
+    case ResultType::RmsDelaySpread: {
+        ui->chartView->setChart(m_rms_delay_plot);
+        break;
+    }
     case ResultType::RiceFactor: {
         ui->chartView->setChart(m_rice_plot);
         break;
@@ -315,6 +367,14 @@ void AnalysisDialog::exportPlotData(QString file_path) {
         current_series = m_delay_series;
         break;
     }
+    case ResultType::MeanExcessDelay: {
+        current_series = m_mean_delay_series;
+        break;
+    }
+    case ResultType::RmsDelaySpread: {
+        current_series = m_rms_delay_series;
+        break;
+    }
     case ResultType::RiceFactor: {
         current_series = m_rice_series;
         break;
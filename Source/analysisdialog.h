@@ -40,11 +40,15 @@ private:
     QtCharts::QChart *m_power_plot;
     QtCharts::QChart *m_snr_plot;
     QtCharts::QChart *m_delay_plot;
+    QtCharts::QChart *m_mean_delay_plot;
+    QtCharts::QChart *m_rms_delay_plot;
     QtCharts::QChart *m_rice_plot;
 
     QtCharts::QLineSeries *m_power_series;
     QtCharts::QLineSeries *m_snr_series;
     QtCharts::QLineSeries *m_delay_series;
+    QtCharts::QLineSeries *m_mean_delay_series;
+    QtCharts::QLineSeries *m_rms_delay_series;
     QtCharts::QLineSeries *m_rice_series;
 };
 
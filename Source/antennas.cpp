@@ -164,7 +164,7 @@ double HalfWaveDipoleVert::getGainMax() const {
  * Returns the effective height of the dipole at the given incidents angles.
  * The 'frequency' defines the design of the antenna (wave length)
  */
-vector<complex> HalfWaveDipoleVert::getEffectiveHeight(
+Vec3c HalfWaveDipoleVert::getEffectiveHeight(
         double theta,
         double phi,
         double frequency) const
@@ -193,7 +193,7 @@ vector<complex> HalfWaveDipoleVert::getEffectiveHeight(
  * Returns the vector describing the polarization.
  * The first component is the parallel, the second is the orthogonal.
  */
-vector<complex> HalfWaveDipoleVert::getPolarization() const {
+Vec2c HalfWaveDipoleVert::getPolarization() const {
     return {0, 1};
 }
 
@@ -280,7 +280,7 @@ double HalfWaveDipoleHoriz::getGainMax() const {
  *
  * WARNING: the y axis is upside down in the graphics scene !
  */
-vector<complex> HalfWaveDipoleHoriz::getEffectiveHeight(
+Vec3c HalfWaveDipoleHoriz::getEffectiveHeight(
         double theta,
         double phi,
         double frequency) const
@@ -312,7 +312,7 @@ vector<complex> HalfWaveDipoleHoriz::getEffectiveHeight(
  * Returns the vector describing the polarization.
  * The first component is the parallel, the second is the orthogonal.
  */
-vector<complex> HalfWaveDipoleHoriz::getPolarization() const {
+Vec2c HalfWaveDipoleHoriz::getPolarization() const {
     return {1, 0};
 }
 
@@ -39,10 +39,10 @@ public:
     virtual QString getAntennaLabel() const = 0;
 
     virtual double getResistance() const = 0;
-    virtual vector<complex> getEffectiveHeight(double theta, double phi, double frequency) const = 0;
+    virtual Vec3c getEffectiveHeight(double theta, double phi, double frequency) const = 0;
     virtual double getGain(double theta, double phi) const = 0;
     virtual double getGainMax() const = 0;
-    virtual vector<complex> getPolarization() const = 0;
+    virtual Vec2c getPolarization() const = 0;
 
 private:
     double m_rotation_angle;
@@ -59,10 +59,10 @@ public:
     QString getAntennaLabel() const override;
 
     double getResistance() const override;
-    vector<complex> getEffectiveHeight(double theta, double phi, double frequency) const override;
+    Vec3c getEffectiveHeight(double theta, double phi, double frequency) const override;
     double getGain(double theta, double phi) const override;
     double getGainMax() const override;
-    vector<complex> getPolarization() const override;
+    Vec2c getPolarization() const override;
 
 };
 
@@ -77,10 +77,10 @@ public:
     QString getAntennaLabel() const override;
 
     double getResistance() const override;
-    vector<complex> getEffectiveHeight(double theta, double phi, double frequency) const override;
+    Vec3c getEffectiveHeight(double theta, double phi, double frequency) const override;
     double getGain(double theta, double phi) const override;
     double getGainMax() const override;
-    vector<complex> getPolarization() const override;
+    Vec2c getPolarization() const override;
 
 };
 
@@ -0,0 +1,347 @@
+#include "candidategenerator.h"
+#include "constants.h"
+#include "corner.h"
+#include "walls.h"
+
+#include <QFile>
+#include <QRegExp>
+#include <QStringList>
+#include <QTextStream>
+
+#define CORNER_OFFSET_DIST      2       // Meters
+#define FACADE_OFFSET_DIST      1       // Meters (from the facade, outside the building)
+#define DEFAULT_SAMPLING_SPACING 10     // Meters
+
+// Minimum distance between two candidates (the receivers are one meter apart)
+#define MIN_CANDIDATES_DIST     1       // Meters
+
+// Size of the cells of the buildings index
+#define BUILDINGS_CELL_SIZE     10      // Meters
+
+
+CandidateGenerator::CandidateGenerator()
+{
+    m_corners_enabled = true;
+    m_facades_enabled = false;
+    m_sampling_spacing = DEFAULT_SAMPLING_SPACING;
+}
+
+void CandidateGenerator::setCornersEnabled(bool enabled) {
+    m_corners_enabled = enabled;
+}
+
+bool CandidateGenerator::cornersEnabled() const {
+    return m_corners_enabled;
+}
+
+void CandidateGenerator::setFacadesEnabled(bool enabled) {
+    m_facades_enabled = enabled;
+}
+
+bool CandidateGenerator::facadesEnabled() const {
+    return m_facades_enabled;
+}
+
+/**
+ * @brief CandidateGenerator::setSamplingSpacing
+ * @param spacing
+ *
+ * Sets the distance between the candidates along the facades and the mount lines (meters)
+ */
+void CandidateGenerator::setSamplingSpacing(double spacing) {
+    m_sampling_spacing = spacing;
+}
+
+double CandidateGenerator::samplingSpacing() const {
+    return m_sampling_spacing;
+}
+
+void CandidateGenerator::setMountLines(const QList<QLineF> &lines) {
+    m_mount_lines = lines;
+}
+
+QList<QLineF> CandidateGenerator::getMountLines() const {
+    return m_mount_lines;
+}
+
+void CandidateGenerator::setPoles(const QList<QPointF> &poles) {
+    m_poles = poles;
+}
+
+QList<QPointF> CandidateGenerator::getPoles() const {
+    return m_poles;
+}
+
+/**
+ * @brief CandidateGenerator::setPlacementArea
+ * @param area
+ * @param buildings
+ *
+ * Sets the area where the emitters can be placed and the rectangles of the
+ * buildings (in meters). A null area doesn't restrict the candidates.
+ */
+void CandidateGenerator::setPlacementArea(const QRectF &area, const QList<QRectF> &buildings) {
+    m_placement_area = area;
+    m_buildings = buildings;
+
+    // Index the buildings by cells: a point of the building is added in each cell
+    // it overlaps, so a building that contains a position has a point in its cell
+    m_buildings_hash.clear(BUILDINGS_CELL_SIZE);
+    m_buildings_hash_rects.clear();
+
+    for (int i = 0 ; i < m_buildings.size() ; i++) {
+        const QRectF &rect = m_buildings.at(i);
+
+        const int first_cx = floor(rect.left() / BUILDINGS_CELL_SIZE);
+        const int last_cx  = floor(rect.right() / BUILDINGS_CELL_SIZE);
+        const int first_cy = floor(rect.top() / BUILDINGS_CELL_SIZE);
+        const int last_cy  = floor(rect.bottom() / BUILDINGS_CELL_SIZE);
+
+        for (int cx = first_cx ; cx <= last_cx ; cx++) {
+            for (int cy = first_cy ; cy <= last_cy ; cy++) {
+                // Point of the building closest to the center of the cell (inside the cell)
+                const QPointF center((cx + 0.5) * BUILDINGS_CELL_SIZE, (cy + 0.5) * BUILDINGS_CELL_SIZE);
+
+                m_buildings_hash.insert(QPointF(qBound(rect.left(), center.x(), rect.right()),
+                                                qBound(rect.top(), center.y(), rect.bottom())));
+                m_buildings_hash_rects.append(i);
+            }
+        }
+    }
+}
+
+/**
+ * @brief CandidateGenerator::isPlaceable
+ * @param pos
+ * @return
+ *
+ * Returns true if an emitter can be placed at the given position (in meters):
+ * inside the placement area and outside the buildings
+ */
+bool CandidateGenerator::isPlaceable(const QPointF &pos) const {
+    if (!m_placement_area.isNull() && !m_placement_area.contains(pos))
+        return false;
+
+    // Only the buildings that have a point close to the position are tested
+    // (the radius is larger than the diagonal of a cell)
+    QVector<int> points;
+    m_buildings_hash.findInRadius(pos, 1.5 * BUILDINGS_CELL_SIZE, &points);
+
+    foreach (int i, points) {
+        if (m_buildings.at(m_buildings_hash_rects.at(i)).contains(pos))
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief CandidateGenerator::loadSitesFile
+ * @param file_path
+ * @param error
+ * @return
+ *
+ * This function reads the poles and the mount lines from a CSV file (in meters).
+ * Each line contains a pole (x,y) or a mount line (x1,y1,x2,y2). The empty lines
+ * and the lines starting with # are ignored.
+ * It returns false (and sets the error message) if the file can't be read.
+ */
+bool CandidateGenerator::loadSitesFile(const QString &file_path, QString *error) {
+    QFile file(file_path);
+
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (error) *error = "Unable to open the file";
+        return false;
+    }
+
+    QList<QPointF> poles;
+    QList<QLineF> lines;
+
+    QTextStream in(&file);
+    int line_number = 0;
+
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        line_number++;
+
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+
+        const QStringList fields = line.split(QRegExp("[,;\\s]+"), QString::SkipEmptyParts);
+        QVector<double> values;
+
+        foreach (const QString &field, fields) {
+            bool ok;
+            values.append(field.toDouble(&ok));
+
+            if (!ok) {
+                if (error) *error = QString("Invalid value at line %1").arg(line_number);
+                return false;
+            }
+        }
+
+        if (values.size() == 2) {
+            poles.append(QPointF(values[0], values[1]));
+        }
+        else if (values.size() == 4) {
+            lines.append(QLineF(values[0], values[1], values[2], values[3]));
+        }
+        else {
+            if (error) *error = QString("Expected 2 or 4 values at line %1").arg(line_number);
+            return false;
+        }
+    }
+
+    m_poles = poles;
+    m_mount_lines = lines;
+
+    return true;
+}
+
+/**
+ * @brief CandidateGenerator::countPlaceableSites
+ * @param rejected
+ * @return
+ *
+ * This function returns the count of the placeable positions of the poles and
+ * the mount lines, and sets the count of the rejected ones (see isPlaceable)
+ */
+int CandidateGenerator::countPlaceableSites(int *rejected) const {
+    const QList<QPointF> positions = sitesPositions();
+    int placeable = 0;
+
+    foreach (const QPointF &pos, positions) {
+        if (isPlaceable(pos))
+            placeable++;
+    }
+
+    if (rejected) *rejected = positions.size() - placeable;
+
+    return placeable;
+}
+
+/**
+ * @brief CandidateGenerator::generate
+ * @param walls
+ * @param corners
+ * @param rejected
+ * @return
+ *
+ * This function returns the candidate positions (in meters) from the enabled sources,
+ * in this order: corners, facades, mount lines and poles.
+ * The positions that are not placeable are rejected (their count is set in rejected).
+ * A candidate closer than MIN_CANDIDATES_DIST to a previous one is discarded.
+ */
+QVector<QPointF> CandidateGenerator::generate(const QList<Wall*> &walls, const QList<Corner*> &corners,
+                                              int *rejected) const {
+    QList<QPointF> positions;
+
+    if (m_corners_enabled) {
+        foreach (Corner *c, corners) {
+            positions.append(cornerPosition(c));
+        }
+    }
+
+    if (m_facades_enabled && m_sampling_spacing > 0) {
+        foreach (Wall *w, walls) {
+            const double length = w->getRealLine().length();
+
+            // Sample the facade between its ends (the ends are the corners)
+            for (double d = m_sampling_spacing ; d < length ; d += m_sampling_spacing) {
+                positions.append(facadePosition(w, d));
+            }
+        }
+    }
+
+    positions.append(sitesPositions());
+
+    // Merge the close candidates
+    SpatialHash hash(MIN_CANDIDATES_DIST);
+    QVector<QPointF> candidates;
+    int rejected_count = 0;
+
+    foreach (const QPointF &pos, positions) {
+        if (!isPlaceable(pos)) {
+            rejected_count++;
+            continue;
+        }
+
+        if (hash.containsInRadius(pos, MIN_CANDIDATES_DIST))
+            continue;
+
+        hash.insert(pos);
+        candidates.append(pos);
+    }
+
+    if (rejected) *rejected = rejected_count;
+
+    return candidates;
+}
+
+/**
+ * @brief CandidateGenerator::sitesPositions
+ * @return
+ *
+ * This function returns the positions of the mount lines (sampled) and the poles
+ */
+QList<QPointF> CandidateGenerator::sitesPositions() const {
+    QList<QPointF> positions;
+
+    foreach (const QLineF &line, m_mount_lines) {
+        positions.append(line.p1());
+
+        if (m_sampling_spacing > 0) {
+            for (double d = m_sampling_spacing ; d < line.length() ; d += m_sampling_spacing) {
+                positions.append(line.pointAt(d / line.length()));
+            }
+        }
+
+        positions.append(line.p2());
+    }
+
+    positions.append(m_poles);
+
+    return positions;
+}
+
+/**
+ * @brief CandidateGenerator::cornerPosition
+ * @param c
+ * @return
+ *
+ * This function returns the "placeable" corner position.
+ * It consists of a position at some distance from the given corner, outside the building.
+ */
+QPointF CandidateGenerator::cornerPosition(Corner *c) {
+    // Get the unit vectors of the two walls (length = 1m, direction = inside the building)
+    QLineF unit_v1 = c->getAdjecentRealLines().at(0).unitVector();
+    QLineF unit_v2 = c->getAdjecentRealLines().at(1).unitVector();
+
+    // Place a point at the corner position
+    QPointF pos = c->getRealPos();
+
+    // Move the point at a certain distance in the direction outside the building
+    pos -= CORNER_OFFSET_DIST * QPointF(unit_v1.dx() + unit_v2.dx(), unit_v1.dy() + unit_v2.dy());
+
+    return pos;
+}
+
+/**
+ * @brief CandidateGenerator::facadePosition
+ * @param w
+ * @param distance
+ * @return
+ *
+ * This function returns the position at the given distance from the first end of
+ * the wall, moved outside the building. The walls of the buildings have the inside
+ * of the buildings on their right (see RectanglesUnion::outline).
+ */
+QPointF CandidateGenerator::facadePosition(Wall *w, double distance) {
+    const QLineF line = w->getRealLine();
+    const QLineF unit = line.unitVector();
+
+    // Normal pointing outside the building (on the left of the wall)
+    const QPointF outside(unit.dy(), -unit.dx());
+
+    return line.pointAt(distance / line.length()) + FACADE_OFFSET_DIST * outside;
+}
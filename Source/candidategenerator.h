@@ -0,0 +1,71 @@
+#ifndef CANDIDATEGENERATOR_H
+#define CANDIDATEGENERATOR_H
+
+#include <QLineF>
+#include <QList>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+#include <QVector>
+
+#include "spatialhash.h"
+
+class Wall;
+class Corner;
+
+// Generator of the candidate positions of the emitters for the coverage optimizer
+// (in meters). The candidates can be placed near the corners of the buildings, along
+// their facades, along mount lines (e.g. a row of lamp posts) or on given poles.
+// The candidates closer than one meter to another one are merged, and the ones
+// outside the placement area or inside a building are rejected.
+class CandidateGenerator
+{
+public:
+    CandidateGenerator();
+
+    void setCornersEnabled(bool enabled);
+    bool cornersEnabled() const;
+
+    void setFacadesEnabled(bool enabled);
+    bool facadesEnabled() const;
+
+    void setSamplingSpacing(double spacing);
+    double samplingSpacing() const;
+
+    void setMountLines(const QList<QLineF> &lines);
+    QList<QLineF> getMountLines() const;
+
+    void setPoles(const QList<QPointF> &poles);
+    QList<QPointF> getPoles() const;
+
+    void setPlacementArea(const QRectF &area, const QList<QRectF> &buildings);
+    bool isPlaceable(const QPointF &pos) const;
+
+    bool loadSitesFile(const QString &file_path, QString *error = nullptr);
+    int countPlaceableSites(int *rejected = nullptr) const;
+
+    QVector<QPointF> generate(const QList<Wall*> &walls, const QList<Corner*> &corners,
+                              int *rejected = nullptr) const;
+
+    static QPointF cornerPosition(Corner *c);
+    static QPointF facadePosition(Wall *w, double distance);
+
+private:
+    QList<QPointF> sitesPositions() const;
+
+    bool m_corners_enabled;
+    bool m_facades_enabled;
+    double m_sampling_spacing;
+
+    QList<QLineF> m_mount_lines;
+    QList<QPointF> m_poles;
+
+    QRectF m_placement_area;
+    QList<QRectF> m_buildings;
+
+    // Index of the buildings (points of the buildings, and their building)
+    SpatialHash m_buildings_hash;
+    QVector<int> m_buildings_hash_rects;
+};
+
+#endif // CANDIDATEGENERATOR_H
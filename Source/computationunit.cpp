@@ -1,43 +1,75 @@
 #include "computationunit.h"
 #include "simulationhandler.h"
+#include "workscheduler.h"
+#include "profiler.h"
 
-ComputationUnit::ComputationUnit(SimulationHandler *h, QList<Receiver *> r_lst) :
+ComputationUnit::ComputationUnit(SimulationHandler *h, WorkScheduler *s, int worker_index, RayPathArena *arena) :
     QObject(h), QRunnable()
 {
     // Don't delete the computation unit when finished
     setAutoDelete(false);
 
     m_handler = h;
-    m_receivers_list = r_lst;
+    m_scheduler = s;
+    m_worker_index = worker_index;
+    m_arena = arena;
+
+    m_computed_receivers = 0;
 
     // Mark this CU as stopped
-    m_running = false;
+    m_running = 0;
 }
 
 bool ComputationUnit::isRunning() {
-    return m_running;
+    return m_running.loadAcquire() != 0;
+}
+
+/**
+ * @brief ComputationUnit::computedReceivers
+ * @return
+ *
+ * Returns the number of receivers computed by this unit (can be called from any thread)
+ */
+int ComputationUnit::computedReceivers() const {
+    return m_computed_receivers.loadAcquire();
 }
 
 /**
  * @brief ComputationUnit::run
  *
- * This function is called when a thread is ready to run it
+ * This function is called when a thread is ready to run it.
+ * The unit computes the chunks of receivers given by the scheduler
+ * (its own chunks, then the chunks stolen from the other units).
  */
 void ComputationUnit::run() {
+    // Busy time of this thread
+    PROFILE_SCOPE(ProfileStage::Worker);
+
     // Mark this CU as running
-    m_running = true;
+    m_running = 1;
 
     // Emit computation started signal
     emit computationStarted();
 
-    // For all receivers of the list
-    foreach(Receiver *r, m_receivers_list) {
-        // Compute the reflections recursively
-        m_handler->computeReceiverRays(r);
+    QList<Receiver*> chunk;
+
+    while (!m_handler->isCancelling() && m_scheduler->takeChunk(m_worker_index, &chunk)) {
+        // For all receivers of the chunk
+        foreach(Receiver *r, chunk) {
+            // Stop as soon as possible when cancelling
+            if (m_handler->isCancelling())
+                break;
+
+            // Compute the rays to this receiver
+            m_handler->computeReceiverRays(r, &m_buffer, m_arena);
+            m_computed_receivers.ref();
+        }
+
+        emit computationProgress();
     }
 
     // Mark this CU as stopped
-    m_running = false;
+    m_running = 0;
 
     // Emit computation finished signal
     emit computationFinished();
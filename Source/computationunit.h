@@ -3,31 +3,46 @@
 
 #include <QObject>
 #include <QRunnable>
+#include <QAtomicInt>
 
 #include "simulationdata.h"
+#include "rayrecord.h"
+#include "raypatharena.h"
 
 
 class SimulationHandler;
+class WorkScheduler;
 
 class ComputationUnit : public QObject, public QRunnable
 {
     Q_OBJECT
 
 public:
-    explicit ComputationUnit(SimulationHandler *h, QList<Receiver*> r_lst);
+    explicit ComputationUnit(SimulationHandler *h, WorkScheduler *s, int worker_index, RayPathArena *arena);
 
     bool isRunning();
+    int computedReceivers() const;
     void run() override;
 
 
 signals:
     void computationStarted();
+    void computationProgress();
     void computationFinished();
 
 private:
-    QList<Receiver*> m_receivers_list;
     SimulationHandler *m_handler;
-    bool m_running;
+    WorkScheduler *m_scheduler;
+    int m_worker_index;
+
+    // Ray paths of the current receiver (reused for all the receivers of this unit),
+    // and storage of the ray paths of the computed receivers
+    RayPathBuffer m_buffer;
+    RayPathArena *m_arena;
+
+    // Number of receivers computed by this unit (read by the handler for the progress)
+    QAtomicInt m_computed_receivers;
+    QAtomicInt m_running;
 };
 
 #endif // COMPUTATIONUNIT_H
@@ -31,16 +31,46 @@ static const double K_boltz     = 1.380649e-23;    // [J K−1]
 // Vacuum impedance
 static const double Z_0 = sqrt(MU_0/EPSILON_0);  // [Ohm]
 
+// Fixed-size 3-dimensional complex vector (electric fields, effective heights, coefficients).
+// This type is stack allocated and trivially copyable, so the field computations
+// don't need any heap allocation.
+struct Vec3c {
+    complex v[3];
+
+    complex &operator[](int i) { return v[i]; }
+    const complex &operator[](int i) const { return v[i]; }
+};
+
+// Fixed-size 2-dimensional complex vector (polarization vectors).
+// The first component is the parallel, the second is the orthogonal.
+struct Vec2c {
+    complex v[2];
+
+    complex &operator[](int i) { return v[i]; }
+    const complex &operator[](int i) const { return v[i]; }
+};
+
 // Operator overload for vector component to component multiplication.
-// This is only valid for 3-dimensionnal vectors.
-vector<complex> operator*(const vector<complex> v1, const vector<complex> v2) ;
+inline Vec3c operator*(const Vec3c &v1, const Vec3c &v2) {
+    return {
+        v1[0] * v2[0],
+        v1[1] * v2[1],
+        v1[2] * v2[2]
+    };
+}
 
 // Operator overload for vector component to component multiplication.
-// This is only valid for 3-dimensionnal vectors.
-vector<complex> operator*=(vector<complex> &v1, const vector<complex> v2) ;
+inline Vec3c &operator*=(Vec3c &v1, const Vec3c &v2) {
+    v1[0] *= v2[0];
+    v1[1] *= v2[1];
+    v1[2] *= v2[2];
+    return v1;
+}
 
-// Dot product basic function. Applicable on two 3-dimensional vectors.
-complex dotProduct(const vector<complex> v1, const vector<complex> v2);
+// Dot product basic function.
+inline complex dotProduct(const Vec3c &v1, const Vec3c &v2) {
+    return v1[0]*v2[0] + v1[1]*v2[1] + v1[2]*v2[2];
+}
 
 // The Sinc Function
 double sinc(double x);
@@ -2,10 +2,66 @@
 #include "simulationhandler.h"
 #include "corner.h"
 
-#include <QApplication>
 #include <QDebug>
+#include <QRunnable>
+#include <qnumeric.h>
 
-#define CORNER_OFFSET_DIST  2   // Meters
+#include <algorithm>
+
+// Number of candidate positions whose coverage is computed at once (lazy-greedy mode).
+// The images of the emitters of a batch are kept in memory during its computation.
+#define COVERAGE_BATCH_SIZE 32
+
+
+// Computation of the scores of the candidate positions by a thread of the pool.
+// The tasks share the index of the next position to compute.
+class PositionsScoringTask : public QRunnable
+{
+public:
+    PositionsScoringTask(CoverageOptimizer *optimizer) {
+        m_optimizer = optimizer;
+    }
+
+    void run() override {
+        int i;
+
+        // Each score is only written by the task that took its position
+        while ((i = m_optimizer->m_next_position.fetchAndAddRelaxed(1)) < m_optimizer->m_candidates_pos.size()) {
+            m_optimizer->m_scores[i] = m_optimizer->getPositionScore(m_optimizer->m_candidates_pos.at(i));
+        }
+
+        m_optimizer->scoringTaskFinished();
+    }
+
+private:
+    CoverageOptimizer *m_optimizer;
+};
+
+// Computation of the receivers covered by each candidate emitter of a batch,
+// by a thread of the pool (one candidate at a time)
+class CoverageTask : public QRunnable
+{
+public:
+    CoverageTask(CoverageOptimizer *optimizer) {
+        m_optimizer = optimizer;
+    }
+
+    void run() override {
+        // Ray paths of one receiver (reused for all the receivers)
+        RayPathBuffer buffer;
+        int i;
+
+        // Each bitset is only written by the task that took its candidate
+        while ((i = m_optimizer->m_next_position.fetchAndAddRelaxed(1)) < m_optimizer->m_batch_end) {
+            m_optimizer->computeCoverage(i, &buffer);
+        }
+
+        m_optimizer->coverageTaskFinished();
+    }
+
+private:
+    CoverageOptimizer *m_optimizer;
+};
 
 
 CoverageOptimizer::CoverageOptimizer(
@@ -21,7 +77,14 @@ CoverageOptimizer::CoverageOptimizer(
     m_simulation_handler = sim_handler;
 
     // Initialize attributes
-    m_optimized = false;
+    m_state = OptimizerState::Stopped;
+    m_cancelling = false;
+    m_cover_ratio = 0;
+    m_tested_emitter = nullptr;
+    m_elapsed_time = 0;
+    m_mode = OptimizerMode::Iterative;
+    m_batch_first = 0;
+    m_batch_end = 0;
 
     // Get simulation area
     m_real_sim_rect = m_sim_area->getRealArea();
@@ -32,9 +95,38 @@ CoverageOptimizer::CoverageOptimizer(
     // Make the walls and building list
     m_walls_list = SimulationHandler::simulationData()->makeBuildingWallsFiltered(m_sim_area->getArea());
     m_corners_list = SimulationHandler::simulationData()->makeWallsCorners(m_walls_list);
+
+    // Build the walls grid used for the obstruction tests
+    m_walls_grid.build(m_walls_list);
+
+    // Continue the optimization when the simulation of a tested emitter ends
+    connect(m_simulation_handler, SIGNAL(simulationFinished()), this, SLOT(simulationFinished()));
+    connect(m_simulation_handler, SIGNAL(simulationCancelled()), this, SLOT(simulationCancelled()));
+}
+
+void CoverageOptimizer::setCandidateGenerator(const CandidateGenerator &generator) {
+    m_candidate_generator = generator;
+}
+
+CandidateGenerator CoverageOptimizer::getCandidateGenerator() const {
+    return m_candidate_generator;
 }
 
 CoverageOptimizer::~CoverageOptimizer() {
+    // The scoring tasks use the walls grid
+    m_threadpool.waitForDone();
+
+    // Delete the emitters of the candidate positions (lazy-greedy mode)
+    if (m_state == OptimizerState::Covering) {
+        m_simulation_handler->releaseEmittersCoverage(
+                    m_candidates_emitters.mid(m_batch_first, m_batch_end - m_batch_first));
+    }
+
+    deleteCandidateEmitters();
+
+    // The walls grid refers to the walls
+    m_walls_grid.clear();
+
     foreach (Wall *w, m_walls_list) {
         delete w;
     }
@@ -45,20 +137,25 @@ CoverageOptimizer::~CoverageOptimizer() {
 }
 
 /**
- * @brief CoverageOptimizer::optimizeEmitters
- * @return
+ * @brief CoverageOptimizer::startOptimization
  *
- * This function runs a complete optimization for emitters
- * placement.
+ * This function starts an optimization for emitters placement.
+ * The function returns immediately: the optimization runs iteration by iteration,
+ * and the optimizationFinished() (or optimizationCancelled()) signal is emitted at its end.
  */
-bool CoverageOptimizer::optimizeEmitters(
+void CoverageOptimizer::startOptimization(
         double cover_thrld,
         double fade_margin,
         double emitter_freq,
         double emitter_eirp,
         double emitter_eff,
-        AntennaType::AntennaType emitter_antenna)
+        AntennaType::AntennaType emitter_antenna,
+        OptimizerMode::OptimizerMode mode)
 {
+    // Ignore if an optimization is already running
+    if (isRunning())
+        return;
+
     // Store the parameters
     m_fade_margin = fade_margin;
     m_cover_threshold = cover_thrld;
@@ -66,17 +163,43 @@ bool CoverageOptimizer::optimizeEmitters(
     m_emit_eirp = emitter_eirp;
     m_emit_eff  = emitter_eff;
     m_emit_ant_type = emitter_antenna;
+    m_mode = mode;
 
     // Remove the previously placed emitters (if one)
     m_sim_area->deletePlacedEmitters();
 
     // Initialize attributes
-    m_optimized = false;
-    m_finished = false;
+    m_cancelling = false;
     m_placed_emitters.clear();
+    m_tested_emitter = nullptr;
+
+    // The candidates must be in the simulation area and outside the buildings
+    QList<QRectF> buildings;
+
+    foreach (Building *b, SimulationHandler::simulationData()->getBuildingsList()) {
+        buildings.append(b->getRealRect());
+    }
+
+    m_candidate_generator.setPlacementArea(m_real_sim_rect, buildings);
 
-    // Initially, all corners are availables
-    m_available_corners = m_corners_list;
+    int rejected_sites = 0;
+    QVector<QPointF> sites = m_candidate_generator.generate(m_walls_list, m_corners_list, &rejected_sites);
+
+    // Reject the candidates rounded to a position without receiver (on the border
+    // of the area or of a building), the emitters are placed on the receivers
+    m_sites.clear();
+
+    foreach (const QPointF &pos, sites) {
+        if (getReceiverAt(QPointF(pos - m_real_sim_rect.topLeft()).toPoint()) == nullptr) {
+            rejected_sites++;
+            continue;
+        }
+
+        m_sites.append(pos);
+    }
+
+    // Initially, all the candidate positions are availables
+    m_available_sites = m_sites.toList();
 
     // Reset the computation handler
     m_simulation_handler->resetComputedData();
@@ -86,167 +209,517 @@ bool CoverageOptimizer::optimizeEmitters(
     qDebug() << "Coverage margin:" << m_fade_margin;
     qDebug() << "Receivers:" << m_receivers_map.size();
     qDebug() << "Walls:" << m_walls_list.size();
-    qDebug() << "Corners:" << m_available_corners.size();
+    qDebug() << "Corners:" << m_corners_list.size();
+    qDebug() << "Candidates:" << m_sites.size();
+    qDebug() << "Rejected candidates:" << rejected_sites;
 
     // Restart the elapsed timer counter
     m_elapsed_time = 0;
-    QElapsedTimer tmr;
-    tmr.start();
+    m_timer.start();
 
-    // If there is no corner in the map -> return an empty emitters list
-    if (m_corners_list.size() == 0) {
-        return true;
-    }
+    // Run the first step from the event loop (the caller can connect
+    // the signals before the optimization ends)
+    m_state = OptimizerState::Waiting;
 
-    // Iterate until the coverage is optimal
-    while (!m_finished) {
-        runOptimizationIteration();
+    if (m_mode == OptimizerMode::LazyGreedy) {
+        QMetaObject::invokeMethod(this, "startCoverage", Qt::QueuedConnection);
     }
+    else {
+        QMetaObject::invokeMethod(this, "runOptimizationIteration", Qt::QueuedConnection);
+    }
+}
 
-    // Store the elapsed time
-    m_elapsed_time = tmr.nsecsElapsed() / 1.0e9;
+/**
+ * @brief CoverageOptimizer::stopOptimization
+ *
+ * This function cancels the optimization. The current step ends first
+ * (the simulation is stopped), then optimizationCancelled() is emitted.
+ */
+void CoverageOptimizer::stopOptimization() {
+    // Ignore if no optimization is running
+    if (!isRunning())
+        return;
 
-    qDebug() << "OPTIMIZATION FINISHED";
-    qDebug() << "Total processing time:" << m_elapsed_time << "s";
+    m_cancelling = true;
+
+    if (m_state == OptimizerState::Simulating) {
+        m_simulation_handler->stopSimulationComputation();
+    }
+}
 
-    return m_optimized;
+bool CoverageOptimizer::isRunning() const {
+    return m_state != OptimizerState::Stopped;
+}
+
+bool CoverageOptimizer::isCancelling() const {
+    return isRunning() && m_cancelling;
 }
 
 /**
  * @brief CoverageOptimizer::runOptimizationIteration
  *
- * This function runs an optimization iteration.
- * This consists in placing on emitter on a non-covered corner, close to the
+ * This slot starts an optimization iteration.
+ * This consists in placing on emitter on a candidate position, close to the
  * first non-covered area found.
  */
 void CoverageOptimizer::runOptimizationIteration() {
-    // -> Kor each corner (not excluded), compute a score:
+    // -> Kor each candidate position (not excluded), compute a score:
     //        sum 1/(1+dist) over all the uncovered receivers of the map
-    //    where dist is the distance between the corner and each receiver.
+    //    where dist is the distance between the position and each receiver.
     //
-    // -> Keep the corner with highest score, place it in the
-    //    exluded corners list, and place an emitter on it.
+    // -> Keep the position with highest score, place it in the
+    //    exluded positions list, and place an emitter on it.
     //
     // -> If this emitter improved the coverage -> keep it
     //    Else -> discard it and its rays.
     //
     // -> Continue until the coverage is over the threshold or until there
-    //    is no more available corners.
+    //    is no more available positions.
 
-    // Compute the initial coverage ratio
-    double cover_ratio = totalCoverageRatio(m_fade_margin);
+    if (m_cancelling) {
+        finishOptimization(false);
+        return;
+    }
 
-    qDebug() << "Init coverage:" << cover_ratio << "/" << m_cover_threshold;
+    // If there is no candidate position -> return an empty emitters list
+    if (m_sites.isEmpty()) {
+        finishOptimization(true);
+        return;
+    }
 
-    // Buffer to get the maximum score
-    double max_score     = 0;
+    // Compute the initial coverage ratio
+    m_cover_ratio = totalCoverageRatio(m_fade_margin);
 
-    // Pointer to the corner position with maximum score
-    Corner *max_score_corner;
+    qDebug() << "Init coverage:" << m_cover_ratio << "/" << m_cover_threshold;
 
-    // Placeable corner position with maximum score
-    QPointF max_score_pos;
+    emit optimizationProgress(min(1.0, m_cover_ratio / m_cover_threshold));
 
-    // Search the corner with highest score on a position
-    foreach (Corner *c, m_available_corners) {
-        // Get the placeable position at this corner
-        QPointF c_place_pos = getPlaceableCornerPosition(c);
+    // Candidate positions where an emitter can be placed
+    findCandidates();
 
-        // Get the relative position of this corner
-        QPoint c_place_rel = QPointF(c_place_pos - m_real_sim_rect.topLeft()).toPoint();
+    // Get the score of each candidate position (computed in parallel)
+    startScoring();
+}
 
-        // Receiver at this positions
-        Receiver *r = m_receivers_map.value(c_place_rel);
+/**
+ * @brief CoverageOptimizer::findCandidates
+ *
+ * This function finds the available candidate positions where an emitter can be
+ * placed (the sites are on a receiver, see startOptimization)
+ */
+void CoverageOptimizer::findCandidates() {
+    m_candidates_pos = m_available_sites.toVector();
+}
 
-        // Check if there is a receiver at this position
-        if (!r) {
-            // This shouldn't happen
-            qDebug() << "RCVPOS ERROR";
-            continue;
+/**
+ * @brief CoverageOptimizer::startScoring
+ *
+ * This function starts the computation of the scores of the candidate positions
+ * by the threads of the pool. The uncovered receivers are found once for all the
+ * positions. The scoringFinished() slot is called when all the scores are computed.
+ */
+void CoverageOptimizer::startScoring() {
+    // Positions of the uncovered receivers
+    m_uncovered_positions.clear();
+
+    foreach (Receiver *r, m_receivers_map) {
+        if (!r->isCovered(m_fade_margin)) {
+            m_uncovered_positions.append(r->getRealPos());
         }
+    }
+
+    m_scores.fill(0.0, m_candidates_pos.size());
+    m_next_position = 0;
+
+    m_state = OptimizerState::Scoring;
 
-        // Get the score for this corner
-        double score = getPositionScore(c_place_pos);
+    // No need of more tasks than positions
+    const int tasks_count = min(m_threadpool.maxThreadCount(), m_candidates_pos.size());
+
+    if (tasks_count == 0) {
+        scoringFinished();
+        return;
+    }
+
+    // Set the counter before starting the tasks (the first ones can end very quickly)
+    m_running_tasks = tasks_count;
+
+    for (int i = 0 ; i < tasks_count ; i++) {
+        m_threadpool.start(new PositionsScoringTask(this));
+    }
+}
+
+/**
+ * @brief CoverageOptimizer::scoringTaskFinished
+ *
+ * This function is called by each scoring task at its end (from its thread).
+ * The last task notifies the optimizer in its own thread.
+ */
+void CoverageOptimizer::scoringTaskFinished() {
+    if (!m_running_tasks.deref()) {
+        QMetaObject::invokeMethod(this, "scoringFinished", Qt::QueuedConnection);
+    }
+}
+
+/**
+ * @brief CoverageOptimizer::scoringFinished
+ *
+ * This slot is called when the scores of the candidate positions are computed.
+ * It places an emitter on the best position, and starts its simulation.
+ */
+void CoverageOptimizer::scoringFinished() {
+    // The queued call may be received after the end of the run() of the last task
+    m_threadpool.waitForDone();
 
-        // Keep the best corner
-        if (max_score < score) {
-            max_score        = score;
-            max_score_pos    = c_place_pos;
-            max_score_corner = c;
+    if (m_cancelling) {
+        finishOptimization(false);
+        return;
+    }
+
+    // Buffer to get the maximum score
+    double max_score     = 0;
+
+    // Candidate position with maximum score
+    QPointF max_score_pos;
+
+    // Search the candidate with highest score
+    for (int i = 0 ; i < m_candidates_pos.size() ; i++) {
+        // Keep the best candidate
+        if (max_score < m_scores[i]) {
+            max_score        = m_scores[i];
+            max_score_pos    = m_candidates_pos[i];
         }
     }
 
     qDebug() << "Best score:" << max_score << "@" << max_score_pos;
 
-
-    // If no free corner was found -> stop
+    // If no free candidate was found -> stop
     if (max_score == 0) {
-        m_optimized = true;
-        m_finished = true;
+        finishOptimization(true);
         return;
     }
 
     // Set the best placement position found as occupied
-    m_available_corners.removeAll(max_score_corner);
+    m_available_sites.removeAll(max_score_pos);
 
     qDebug() << "Emitter pos:" << max_score_pos;
 
     // Create a new test emitter
-    Emitter *emit_test = new Emitter(m_emit_freq, m_emit_eirp, 1.0, m_emit_ant_type);
-    emit_test->setPos(max_score_pos * SimulationScene::simulationScale());
-    m_sim_area->addPlacedEmitter(emit_test);
+    m_tested_emitter = new Emitter(m_emit_freq, m_emit_eirp, 1.0, m_emit_ant_type);
+    m_tested_emitter->setPos(max_score_pos * SimulationScene::simulationScale());
+    m_sim_area->addPlacedEmitter(m_tested_emitter);
+
+    emit layoutUpdated();
+
+    // Start the simulation for this emitter only, without resetting the previous results.
+    // The iteration continues in the simulationFinished() slot.
+    m_state = OptimizerState::Simulating;
 
-    // Start the simulation for this emitter only, without resetting the previous results
     m_simulation_handler->startSimulationComputation(
                 m_sim_area->getReceiversList(),
                 m_sim_area->getArea(),
                 false,
-                QList<Emitter*>() << emit_test);
-
-    // Elapsed timer to refresh the map regularily
-    QElapsedTimer tmr;
-    tmr.start();
-
-    // Wait until the computation is done
-    while (!m_simulation_handler->isDone()) {
-        // If the simulation is not running anymore -> it was canceled
-        if (!m_simulation_handler->isRunning() && !m_simulation_handler->isDone()) {
-            m_finished = true;
-            qDebug() << "OPTIMIZATION CANCELED";
-            return;
+                QList<Emitter*>() << m_tested_emitter);
+}
+
+/**
+ * @brief CoverageOptimizer::startCoverage
+ *
+ * This slot starts the lazy-greedy optimization: an emitter is created at each
+ * candidate position, and the receivers it covers alone are computed by batches
+ * of candidates in the threads of the pool.
+ */
+void CoverageOptimizer::startCoverage() {
+    if (m_cancelling) {
+        finishOptimization(false);
+        return;
+    }
+
+    // Candidate positions where an emitter can be placed
+    findCandidates();
+
+    qDebug() << "Candidates:" << m_candidates_pos.size();
+
+    // Create the emitter of each candidate (not placed in the simulation area)
+    deleteCandidateEmitters();
+
+    foreach (const QPointF &pos, m_candidates_pos) {
+        Emitter *em = new Emitter(m_emit_freq, m_emit_eirp, 1.0, m_emit_ant_type);
+        em->setPos(pos * SimulationScene::simulationScale());
+        m_candidates_emitters.append(em);
+    }
+
+    m_coverage_receivers = m_sim_area->getReceiversList();
+    m_coverage = QVector<QBitArray>(m_candidates_pos.size());
+
+    // Hash the receivers to test only the ones in the pruning radius of each candidate
+    const double pruning_radius = SimulationHandler::simulationData()->getPruningRadius();
+    m_coverage_receivers_hash.clear(pruning_radius);
+
+    if (qIsFinite(pruning_radius)) {
+        foreach (Receiver *r, m_coverage_receivers) {
+            m_coverage_receivers_hash.insert(r->getRealPos());
         }
+    }
+
+    m_batch_first = 0;
+    m_batch_end = 0;
+
+    startCoverageBatch();
+}
+
+/**
+ * @brief CoverageOptimizer::startCoverageBatch
+ *
+ * This function starts the coverage computation of the next batch of candidates
+ * (or selects the emitters if all the candidates are computed).
+ * The coverageBatchFinished() slot is called when the batch is computed.
+ */
+void CoverageOptimizer::startCoverageBatch() {
+    if (m_batch_end >= m_candidates_emitters.size()) {
+        selectCoveringEmitters();
+        return;
+    }
 
-        qApp->processEvents();
+    m_batch_first = m_batch_end;
+    m_batch_end = min(m_batch_first + COVERAGE_BATCH_SIZE, m_candidates_emitters.size());
+
+    // Compute the images and the visible corners of the emitters of the batch
+    m_simulation_handler->prepareEmittersCoverage(
+                m_sim_area->getArea(),
+                m_candidates_emitters.mid(m_batch_first, m_batch_end - m_batch_first));
 
-        // Update all receivers at each second
-        if (tmr.elapsed() > 1000.0) {
-            foreach (Receiver *r, m_receivers_map) {
-                r->update();
+    m_state = OptimizerState::Covering;
+    m_next_position = m_batch_first;
+
+    // No need of more tasks than candidates
+    const int tasks_count = min(m_threadpool.maxThreadCount(), m_batch_end - m_batch_first);
+
+    // Set the counter before starting the tasks (the first ones can end very quickly)
+    m_running_tasks = tasks_count;
+
+    for (int i = 0 ; i < tasks_count ; i++) {
+        m_threadpool.start(new CoverageTask(this));
+    }
+}
+
+/**
+ * @brief CoverageOptimizer::computeCoverage
+ * @param candidate
+ * @param buffer
+ *
+ * This function computes the bitset of the receivers covered by the emitter
+ * of the candidate alone (can be called from any thread)
+ */
+void CoverageOptimizer::computeCoverage(int candidate, RayPathBuffer *buffer) {
+    Emitter *em = m_candidates_emitters.at(candidate);
+    QBitArray covered(m_coverage_receivers.size());
+
+    // The receivers out of the pruning radius can't be covered
+    if (!m_coverage_receivers_hash.isEmpty()) {
+        QVector<int> receivers;
+        m_coverage_receivers_hash.findInRadius(
+                    em->getRealPos(),
+                    SimulationHandler::simulationData()->getPruningRadius(),
+                    &receivers);
+
+        foreach (int i, receivers) {
+            if (m_simulation_handler->isCoveredByEmitter(em, m_coverage_receivers.at(i), m_fade_margin, buffer)) {
+                covered.setBit(i);
+            }
+        }
+    }
+    else {
+        for (int i = 0 ; i < m_coverage_receivers.size() ; i++) {
+            if (m_simulation_handler->isCoveredByEmitter(em, m_coverage_receivers.at(i), m_fade_margin, buffer)) {
+                covered.setBit(i);
             }
+        }
+    }
+
+    m_coverage[candidate] = covered;
+}
+
+/**
+ * @brief CoverageOptimizer::coverageTaskFinished
+ *
+ * This function is called by each coverage task at its end (from its thread).
+ * The last task notifies the optimizer in its own thread.
+ */
+void CoverageOptimizer::coverageTaskFinished() {
+    if (!m_running_tasks.deref()) {
+        QMetaObject::invokeMethod(this, "coverageBatchFinished", Qt::QueuedConnection);
+    }
+}
+
+/**
+ * @brief CoverageOptimizer::coverageBatchFinished
+ *
+ * This slot is called when the coverage of a batch of candidates is computed
+ */
+void CoverageOptimizer::coverageBatchFinished() {
+    // The queued call may be received after the end of the run() of the last task
+    m_threadpool.waitForDone();
+
+    m_simulation_handler->releaseEmittersCoverage(
+                m_candidates_emitters.mid(m_batch_first, m_batch_end - m_batch_first));
+
+    m_state = OptimizerState::Waiting;
 
-            // Reset the timer counter
-            tmr.restart();
+    if (m_cancelling) {
+        deleteCandidateEmitters();
+        finishOptimization(false);
+        return;
+    }
+
+    emit optimizationProgress((double) m_batch_end / (double) m_candidates_emitters.size());
+
+    startCoverageBatch();
+}
+
+/**
+ * @brief CoverageOptimizer::selectCoveringEmitters
+ *
+ * This function chooses the emitters with a lazy-greedy set cover over the coverage
+ * bitsets of the candidates: the candidate that covers the most uncovered receivers
+ * is placed, until the coverage threshold is reached.
+ * The gain of a candidate can only decrease when other candidates are placed, so the
+ * candidates are kept in a heap with their last computed gain, and only the gain of
+ * the top of the heap is computed again.
+ * The final layout is then simulated.
+ */
+void CoverageOptimizer::selectCoveringEmitters() {
+    const int receivers_count = m_coverage_receivers.size();
+
+    QBitArray uncovered(receivers_count, true);
+    int covered_count = 0;
+
+    // Heap of the candidates, by their last computed gain
+    QVector<QPair<int,int>> heap;
+    heap.reserve(m_coverage.size());
+
+    for (int i = 0 ; i < m_coverage.size() ; i++) {
+        heap.append(QPair<int,int>(m_coverage[i].count(true), i));
+    }
+
+    std::make_heap(heap.begin(), heap.end());
+
+    QList<Emitter*> selected;
+
+    while (!heap.isEmpty() && covered_count < m_cover_threshold * receivers_count) {
+        std::pop_heap(heap.begin(), heap.end());
+        const int candidate = heap.last().second;
+        heap.removeLast();
+
+        // Gain of this candidate with the emitters placed so far
+        const QBitArray gain_set = m_coverage[candidate] & uncovered;
+        const int gain = gain_set.count(true);
+
+        // No more receiver to cover with this candidate
+        if (gain == 0)
+            continue;
+
+        // Another candidate may be better: put it back with its new gain
+        if (!heap.isEmpty() && gain < heap.first().first) {
+            heap.append(QPair<int,int>(gain, candidate));
+            std::push_heap(heap.begin(), heap.end());
+            continue;
         }
+
+        // Place this candidate
+        uncovered &= ~gain_set;
+        covered_count += gain;
+
+        selected.append(m_candidates_emitters[candidate]);
+        m_available_sites.removeAll(m_candidates_pos[candidate]);
+
+        qDebug() << "Emitter pos:" << m_candidates_pos[candidate] << "gain:" << gain;
     }
 
+    qDebug() << "Estimated coverage:" << (receivers_count > 0 ? qreal(covered_count) / receivers_count : 0)
+             << "/" << m_cover_threshold;
+
+    // Place the selected emitters, and delete the other ones
+    foreach (Emitter *em, selected) {
+        m_candidates_emitters.removeOne(em);
+        m_sim_area->addPlacedEmitter(em);
+        m_placed_emitters.append(em);
+    }
+
+    deleteCandidateEmitters();
+    m_coverage.clear();
+
+    if (m_placed_emitters.isEmpty()) {
+        finishOptimization(true);
+        return;
+    }
+
+    emit layoutUpdated();
+
+    // Simulate the final layout only.
+    // The optimization ends in the simulationFinished() slot.
+    m_state = OptimizerState::Simulating;
+
+    m_simulation_handler->startSimulationComputation(
+                m_sim_area->getReceiversList(),
+                m_sim_area->getArea(),
+                true,
+                m_placed_emitters);
+}
+
+/**
+ * @brief CoverageOptimizer::deleteCandidateEmitters
+ *
+ * This function deletes the emitters of the candidates (lazy-greedy mode)
+ * that are not placed
+ */
+void CoverageOptimizer::deleteCandidateEmitters() {
+    foreach (Emitter *em, m_candidates_emitters) {
+        delete em;
+    }
+
+    m_candidates_emitters.clear();
+}
+
+/**
+ * @brief CoverageOptimizer::simulationFinished
+ *
+ * This slot is called when a simulation of the handler is finished.
+ * It keeps the tested emitter if it improved the coverage, and continues the optimization.
+ */
+void CoverageOptimizer::simulationFinished() {
+    // Ignore the simulations not started by the optimizer
+    if (m_state != OptimizerState::Simulating)
+        return;
+
+    // Lazy-greedy mode: the final layout is simulated
+    if (m_mode == OptimizerMode::LazyGreedy) {
+        qDebug() << "Final coverage:" << totalCoverageRatio(m_fade_margin) << "/" << m_cover_threshold;
+
+        emit layoutUpdated();
+        finishOptimization(true);
+        return;
+    }
+
+    Emitter *emit_test = m_tested_emitter;
+    m_tested_emitter = nullptr;
+
     // Compute the new coverage ratio
     double new_coverage_ratio = totalCoverageRatio(m_fade_margin);
 
     qDebug() << "New coverage:" << new_coverage_ratio << "/" << m_cover_threshold;
 
     // Check if the coverage ratio has been improved
-    if (new_coverage_ratio > cover_ratio) {
+    if (new_coverage_ratio > m_cover_ratio) {
         // If this emitter improved the coverage
         //  -> Keep it in the placed emitters list;
         m_placed_emitters.append(emit_test);
     }
     else {
-        // Else discard it and delete it and add this corner to banned list
+        // Else discard it and delete it and add this position to banned list
 
         // Remove all raypaths from this emitter from all receivers...
-        foreach(Receiver *r, m_receivers_map) {
-            r->discardEmitter(emit_test);
-        }
+        m_simulation_handler->removeEmitter(emit_test);
 
         // Remove it from the simulation area
         m_sim_area->removePlacedEmitter(emit_test);
@@ -255,13 +728,65 @@ void CoverageOptimizer::runOptimizationIteration() {
         delete emit_test;
     }
 
-    qDebug() << "Remaining corners:" << m_available_corners.size() << "/" << m_corners_list.size();
+    // The heat map can be refreshed with the results of the kept emitters
+    emit layoutUpdated();
+
+    qDebug() << "Remaining candidates:" << m_available_sites.size() << "/" << m_sites.size();
 
-    // Finally, check if we have a full coverage or if all the corners have been banned
-    if (new_coverage_ratio >= m_cover_threshold || m_available_corners.size() == 0) {
-        m_optimized = true;
-        m_finished = true;
+    // Finally, check if we have a full coverage or if all the positions have been banned
+    if (new_coverage_ratio >= m_cover_threshold || m_available_sites.size() == 0) {
+        finishOptimization(true);
+        return;
     }
+
+    // Next iteration
+    m_state = OptimizerState::Waiting;
+    runOptimizationIteration();
+}
+
+/**
+ * @brief CoverageOptimizer::simulationCancelled
+ *
+ * This slot is called when a simulation of the handler is cancelled
+ */
+void CoverageOptimizer::simulationCancelled() {
+    // Ignore the simulations not started by the optimizer
+    if (m_state != OptimizerState::Simulating)
+        return;
+
+    // The tested emitter stays in the simulation area (deleted with the placed emitters)
+    m_tested_emitter = nullptr;
+
+    qDebug() << "OPTIMIZATION CANCELED";
+
+    m_cancelling = true;
+    finishOptimization(false);
+}
+
+/**
+ * @brief CoverageOptimizer::finishOptimization
+ * @param optimized
+ *
+ * This function ends the optimization, and emits the finished signal
+ * (or the cancelled signal if the optimization was cancelled)
+ */
+void CoverageOptimizer::finishOptimization(bool optimized) {
+    m_state = OptimizerState::Stopped;
+
+    // Store the elapsed time
+    m_elapsed_time = m_timer.nsecsElapsed() / 1.0e9;
+
+    if (m_cancelling) {
+        m_cancelling = false;
+        emit optimizationCancelled();
+        return;
+    }
+
+    qDebug() << "OPTIMIZATION FINISHED";
+    qDebug() << "Total processing time:" << m_elapsed_time << "s";
+
+    emit optimizationProgress(1.0);
+    emit optimizationFinished(optimized);
 }
 
 /**
@@ -315,12 +840,13 @@ Receiver *CoverageOptimizer::getReceiverAt(QPoint pos) {
 
 /**
  * @brief CoverageOptimizer::getPositionScore
- * @param c
+ * @param pos
  * @return
  *
  * This function computes the score for the given position
+ * (can be called from any thread)
  */
-double CoverageOptimizer::getPositionScore(QPointF pos) {
+double CoverageOptimizer::getPositionScore(QPointF pos) const {
     // Init score to zero
     double score = 0;
 
@@ -328,31 +854,16 @@ double CoverageOptimizer::getPositionScore(QPointF pos) {
     double ampl_factor;
     double dist;
     QLineF direct_line;
-    QLineF::IntersectionType intersect_type;
-
-    // Loop over each receiver and take the uncovered ones into account
-    foreach (Receiver *r, m_receivers_map) {
-        // Check if it is uncovered
-        if (r->isCovered(m_fade_margin))
-            continue;
 
+    // Loop over the uncovered receivers
+    foreach (const QPointF &rcv_pos, m_uncovered_positions) {
         // Get the direct line between given position and receiver
-        direct_line = QLineF(r->getRealPos(), pos);
-
-        // If the direct line is free of obstacle -> amplification factor = 100
-        ampl_factor = 100.0;
-
-        // Search for an obstacle for this line
-        foreach (Wall *w, m_walls_list) {
-            // Get the intersection type
-            intersect_type = direct_line.intersects(w->getRealLine(), nullptr);
+        direct_line = QLineF(rcv_pos, pos);
 
-            // Amplification factor is 1 if the line is obstructed
-            if (intersect_type == QLineF::BoundedIntersection) {
-                ampl_factor = 1.0;
-                break;
-            }
-        }
+        // If the direct line is free of obstacle -> amplification factor = 100.
+        // Amplification factor is 1 if the line is obstructed (only the walls
+        // close to the line are tested).
+        ampl_factor = m_walls_grid.intersects(direct_line, nullptr, nullptr) ? 1.0 : 100.0;
 
         // Get the distance to this receiver
         dist = direct_line.length();
@@ -366,29 +877,6 @@ double CoverageOptimizer::getPositionScore(QPointF pos) {
     return score;
 }
 
-/**
- * @brief CoverageOptimizer::getPlaceableCornerPosition
- * @param c
- * @return
- *
- * This function returns the "placeable" corner position.
- * It consists of a position at some distance from the given corner, outside the building.
- */
-QPointF CoverageOptimizer::getPlaceableCornerPosition(Corner *c) {
-    // Get the unit vectors of the two walls (length = 1m, direction = inside the building)
-    QLineF unit_v1 = c->getAdjecentRealLines().at(0).unitVector();
-    QLineF unit_v2 = c->getAdjecentRealLines().at(1).unitVector();
-
-    // Place a point at the corner position
-    QPointF pos = c->getRealPos();
-
-    // Move the point at a certain distance in the direction outside the building
-    pos -= CORNER_OFFSET_DIST * QPointF(unit_v1.dx() + unit_v2.dx(), unit_v1.dy() + unit_v2.dy());
-
-    return pos;
-}
-
-
 QList<Emitter*> CoverageOptimizer::getPlacedEmitters() {
     return m_placed_emitters;
 }
@@ -1,15 +1,48 @@
 #ifndef COVERAGEOPTIMIZER_H
 #define COVERAGEOPTIMIZER_H
 
+#include <QAtomicInt>
+#include <QBitArray>
+#include <QElapsedTimer>
 #include <QObject>
+#include <QThreadPool>
+#include <QVector>
 
+#include "candidategenerator.h"
 #include "emitter.h"
 #include "simulationarea.h"
+#include "spatialhash.h"
+#include "wallsgrid.h"
 
 class Wall;
 class Corner;
 class SimulationHandler;
+struct RayPathBuffer;
 
+namespace OptimizerMode {
+enum OptimizerMode {
+    Iterative,      // Simulation of each placed emitter, kept if the coverage improved
+    LazyGreedy      // Coverage of each candidate alone precomputed, then greedy set cover
+};
+}
+
+namespace OptimizerState {
+enum OptimizerState {
+    Stopped,
+    Waiting,        // Next iteration queued
+    Scoring,        // Scores of the candidate positions computed by the pool
+    Covering,       // Coverage of a batch of candidate positions computed by the pool
+    Simulating      // Simulation of the tested emitter (or of the final layout) running
+};
+}
+
+// The optimization is driven by the signals of the simulation handler: each
+// iteration scores the candidate positions in the threads of the pool, places an emitter
+// and starts its simulation, and continues when the simulation is finished.
+// The GUI thread is never blocked.
+// In the lazy-greedy mode, the receivers covered by an emitter alone at each candidate
+// position are computed first (one bitset per candidate), the emitters are chosen by a lazy-greedy
+// set cover over these bitsets, and only the final layout is simulated.
 class CoverageOptimizer : public QObject
 {
     Q_OBJECT
@@ -20,13 +53,21 @@ public:
             QObject *parent = nullptr);
     ~CoverageOptimizer();
 
-    bool optimizeEmitters(
+    void setCandidateGenerator(const CandidateGenerator &generator);
+    CandidateGenerator getCandidateGenerator() const;
+
+    void startOptimization(
             double cover_thrld,
             double fade_margin,
             double emitter_freq,
             double emitter_eirp,
             double emitter_eff,
-            AntennaType::AntennaType emitter_antenna);
+            AntennaType::AntennaType emitter_antenna,
+            OptimizerMode::OptimizerMode mode = OptimizerMode::Iterative);
+    void stopOptimization();
+
+    bool isRunning() const;
+    bool isCancelling() const;
 
     QList<Emitter*> getPlacedEmitters();
 
@@ -35,15 +76,40 @@ public:
     double getTotalCoverageMargin();
     double getTimeElapsed();
 
-private:
+signals:
+    void optimizationProgress(double);
+    void layoutUpdated();
+    void optimizationFinished(bool optimized);
+    void optimizationCancelled();
+
+private slots:
     void runOptimizationIteration();
+    void scoringFinished();
+    void startCoverage();
+    void coverageBatchFinished();
+    void simulationFinished();
+    void simulationCancelled();
+
+private:
+    void findCandidates();
+    void startScoring();
+    void scoringTaskFinished();
+    void startCoverageBatch();
+    void coverageTaskFinished();
+    void computeCoverage(int candidate, RayPathBuffer *buffer);
+    void selectCoveringEmitters();
+    void deleteCandidateEmitters();
+    void finishOptimization(bool optimized);
 
     qreal totalCoverageRatio(double margin);
     bool isCoveredAt(QPoint pos);
 
     Receiver *getReceiverAt(QPoint pos);
-    double getPositionScore(QPointF pos);
-    QPointF getPlaceableCornerPosition(Corner *c);
+    double getPositionScore(QPointF pos) const;
+
+    // The scores of the positions are computed by the threads of the pool
+    friend class PositionsScoringTask;
+    friend class CoverageTask;
 
 
     SimulationArea *m_sim_area;
@@ -54,11 +120,12 @@ private:
     double m_emit_eirp;
     double m_emit_eff;
     AntennaType::AntennaType m_emit_ant_type;
+    OptimizerMode::OptimizerMode m_mode;
 
     SimulationHandler *m_simulation_handler;
 
-    bool m_optimized;
-    bool m_finished;
+    OptimizerState::OptimizerState m_state;
+    bool m_cancelling;
     QRectF m_real_sim_rect;
 
     QMap<QPoint,Receiver*> m_receivers_map;
@@ -66,9 +133,38 @@ private:
     QList<Wall*> m_walls_list;
     QList<Corner*> m_corners_list;
 
-    QList<Corner*> m_available_corners;
+    // Candidate positions of the emitters (in meters)
+    CandidateGenerator m_candidate_generator;
+    QVector<QPointF> m_sites;
+
+    // Grid of the walls for the obstruction tests of the scores
+    WallsGrid m_walls_grid;
+    QThreadPool m_threadpool;
+
+    // Data of the current iteration (the scores are written by the pool)
+    double m_cover_ratio;
+    QVector<QPointF> m_candidates_pos;
+
+    // Uncovered receivers (scored from each candidate position)
+    QVector<QPointF> m_uncovered_positions;
+    QVector<double> m_scores;
+    QAtomicInt m_next_position;
+    QAtomicInt m_running_tasks;
+
+    // Lazy-greedy mode: emitter at each candidate position, and receivers it covers alone
+    // (indexes in m_coverage_receivers), computed by batches of candidates
+    QList<Emitter*> m_candidates_emitters;
+    QList<Receiver*> m_coverage_receivers;
+    SpatialHash m_coverage_receivers_hash;
+    QVector<QBitArray> m_coverage;
+    int m_batch_first;
+    int m_batch_end;
+
+    QList<QPointF> m_available_sites;
     QList<Emitter*> m_placed_emitters;
+    Emitter *m_tested_emitter;
 
+    QElapsedTimer m_timer;
     double m_elapsed_time;
 };
 
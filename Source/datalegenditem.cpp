@@ -53,7 +53,9 @@ void DataLegendItem::setDataRange(ResultType::ResultType type, double min, doubl
         units_max = "dB";
         break;
     }
-    case ResultType::DelaySpread: {
+    case ResultType::DelaySpread:
+    case ResultType::MeanExcessDelay:
+    case ResultType::RmsDelaySpread: {
         min = SimulationData::delayToHumanReadable(min, &units_min);
         mid = SimulationData::delayToHumanReadable(mid, &units_mid);
         max = SimulationData::delayToHumanReadable(max, &units_max);
@@ -165,7 +165,7 @@ double Emitter::getResistance() const {
  * Returns the same as getEffectiveHeight(theta, phi), but with the default angle
  * theta to π/2, since the 2D simulation is in the plane θ = π/2
  */
-vector<complex> Emitter::getEffectiveHeight(double phi) const {
+Vec3c Emitter::getEffectiveHeight(double phi) const {
     return m_antenna->getEffectiveHeight(M_PI_2, phi, m_frequency);
 }
 
@@ -199,7 +199,7 @@ double Emitter::getGain(double phi) const {
  *
  * Returns the antenna's polarization vector
  */
-vector<complex> Emitter::getPolarization() const{
+Vec2c Emitter::getPolarization() const{
     return m_antenna->getPolarization();
 }
 
@@ -41,10 +41,10 @@ public:
     double getEfficiency() const;
 
     double getResistance() const;
-    vector<complex> getEffectiveHeight(double phi) const;
+    Vec3c getEffectiveHeight(double phi) const;
     double getGain(double phi) const;
     double getGain(double theta, double phi) const;
-    vector<complex> getPolarization() const;
+    Vec2c getPolarization() const;
 
     void updateTooltip();
 
@@ -0,0 +1,68 @@
+# Simulation engine sources (shared by the application, the command-line runner and the benchmarks).
+# The engine doesn't depend on the main window and the dialogs.
+
+INCLUDEPATH += $$PWD
+
+# Profiling of the engine stages (qmake CONFIG+=profiling), without any cost otherwise
+profiling: DEFINES += PROFILING
+
+SOURCES += \
+    $$PWD/analysisline.cpp \
+    $$PWD/antennas.cpp \
+    $$PWD/building.cpp \
+    $$PWD/candidategenerator.cpp \
+    $$PWD/computationunit.cpp \
+    $$PWD/constants.cpp \
+    $$PWD/corner.cpp \
+    $$PWD/coverageoptimizer.cpp \
+    $$PWD/datalegenditem.cpp \
+    $$PWD/emitter.cpp \
+    $$PWD/imagetree.cpp \
+    $$PWD/profiler.cpp \
+    $$PWD/raypath.cpp \
+    $$PWD/raypatharena.cpp \
+    $$PWD/receiver.cpp \
+    $$PWD/receiversgrid.cpp \
+    $$PWD/rectanglesunion.cpp \
+    $$PWD/scaleruleritem.cpp \
+    $$PWD/segmentkernel.cpp \
+    $$PWD/simulationarea.cpp \
+    $$PWD/simulationdata.cpp \
+    $$PWD/simulationhandler.cpp \
+    $$PWD/simulationitem.cpp \
+    $$PWD/simulationscene.cpp \
+    $$PWD/spatialhash.cpp \
+    $$PWD/walls.cpp \
+    $$PWD/wallsgrid.cpp \
+    $$PWD/workscheduler.cpp
+
+HEADERS += \
+    $$PWD/analysisline.h \
+    $$PWD/antennas.h \
+    $$PWD/building.h \
+    $$PWD/candidategenerator.h \
+    $$PWD/computationunit.h \
+    $$PWD/constants.h \
+    $$PWD/corner.h \
+    $$PWD/coverageoptimizer.h \
+    $$PWD/datalegenditem.h \
+    $$PWD/emitter.h \
+    $$PWD/imagetree.h \
+    $$PWD/profiler.h \
+    $$PWD/raypath.h \
+    $$PWD/raypatharena.h \
+    $$PWD/rayrecord.h \
+    $$PWD/receiver.h \
+    $$PWD/receiversgrid.h \
+    $$PWD/rectanglesunion.h \
+    $$PWD/scaleruleritem.h \
+    $$PWD/segmentkernel.h \
+    $$PWD/simulationarea.h \
+    $$PWD/simulationdata.h \
+    $$PWD/simulationhandler.h \
+    $$PWD/simulationitem.h \
+    $$PWD/simulationscene.h \
+    $$PWD/spatialhash.h \
+    $$PWD/walls.h \
+    $$PWD/wallsgrid.h \
+    $$PWD/workscheduler.h
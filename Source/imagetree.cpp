@@ -0,0 +1,306 @@
+#include "imagetree.h"
+#include "simulationhandler.h"
+#include "walls.h"
+
+#include <algorithm>
+
+// Relative tolerance for the validity region test.
+// The region is slightly enlarged, so a valid ray path is never discarded.
+#define REGION_TOLERANCE 1e-9
+
+// Tolerance of the rectangle test (larger than the tolerance of the points test,
+// so the rounding errors never discard a rectangle with a valid point)
+#define RECT_TOLERANCE (2.0 * REGION_TOLERANCE)
+
+
+// 2-D cross product of the vectors u and v
+static inline double cross(const QPointF &u, const QPointF &v) {
+    return u.x() * v.y() - u.y() * v.x();
+}
+
+// Sum of the absolute coordinates of u (cheap vector norm)
+static inline double normL1(const QPointF &u) {
+    return fabs(u.x()) + fabs(u.y());
+}
+
+
+ImageTree::ImageTree(QPointF source, const QList<Wall*> &walls_list, int max_level)
+{
+    m_source = source;
+
+    // Keep the walls and their real lines (in meters)
+    foreach (Wall *w, walls_list) {
+        m_walls.append(w);
+        m_walls_lines.append(w->getRealLine());
+    }
+
+    // Build the tree from the source (depth-first)
+    if (max_level > 0) {
+        buildChildren(-1, 1, max_level);
+    }
+}
+
+/**
+ * @brief ImageTree::buildChildren
+ * @param parent
+ * @param level
+ * @param max_level
+ *
+ * This function computes the images of the parent node (or of the source if parent is -1)
+ * over all walls, and the subtrees of these images.
+ * The nodes are stored in depth-first order, which is the order the ray paths were computed
+ * by the previous recursive implementation.
+ * The walls that can't be reached from the source are not added to the tree (with their subtrees).
+ */
+void ImageTree::buildChildren(int parent, int level, int max_level) {
+    // The source of this level is the parent image (or the emitter)
+    const QPointF source = (parent < 0 ? m_source : m_nodes[parent].image);
+    const int parent_wall = (parent < 0 ? -1 : m_nodes[parent].wall);
+
+    for (int w = 0 ; w < m_walls.size() ; w++) {
+        // We don't have to compute any reflection from a wall to itself
+        if (w == parent_wall) {
+            continue;
+        }
+
+        // Skip the walls that can't be reached by the rays of this source
+        if (!isWallVisible(parent, source, w)) {
+            continue;
+        }
+
+        ImageNode node;
+        node.image  = SimulationHandler::mirror(source, m_walls[w]);
+        node.wall   = w;
+        node.parent = parent;
+        node.level  = level;
+
+        m_nodes.append(node);
+
+        // Compute the next reflections from this image
+        if (level < max_level) {
+            buildChildren(m_nodes.size() - 1, level + 1, max_level);
+        }
+    }
+}
+
+/**
+ * @brief ImageTree::isWallVisible
+ * @param parent
+ * @param source
+ * @param w
+ * @return
+ *
+ * This function returns false if the rays coming from the source (emitter or image of
+ * the parent node) can't be reflected by the wall w. In this case, no ray path of the subtree
+ * of w can be valid. The wall is not visible if:
+ *  - the source is on the line of the wall, but not on the wall (the wall is seen edge-on),
+ *  - the wall is behind the parent wall (on the same side as the parent image),
+ *  - the wall is outside the wedge lit by the parent image through the parent wall.
+ * All these tests are slightly tolerant, so a valid ray path is never discarded.
+ */
+bool ImageTree::isWallVisible(int parent, const QPointF &source, int w) const {
+    const QLineF &line = m_walls_lines[w];
+    const QPointF wall_dir = line.p2() - line.p1();
+    const QPointF src_rel  = source - line.p1();
+
+    // Check if the wall is seen edge-on from the source
+    if (cross(wall_dir, src_rel) == 0) {
+        // Position of the source along the wall (0 and 1 are the ends of the wall)
+        const double t = (src_rel.x() * wall_dir.x() + src_rel.y() * wall_dir.y()) /
+                         (wall_dir.x() * wall_dir.x() + wall_dir.y() * wall_dir.y());
+
+        if (t < -REGION_TOLERANCE || t > 1.0 + REGION_TOLERANCE) {
+            return false;
+        }
+    }
+
+    // The emitter lights all the walls
+    if (parent < 0)
+        return true;
+
+    const ImageNode &parent_node = m_nodes[parent];
+    const QLineF &parent_line = m_walls_lines[parent_node.wall];
+    const QPointF parent_dir = parent_line.p2() - parent_line.p1();
+
+    // Side of the parent image w.r.t. the parent wall
+    const double side_image = cross(parent_dir, parent_node.image - parent_line.p1());
+
+    // Degenerated case: the image is on the line of the parent wall (nothing to discard)
+    if (side_image == 0)
+        return true;
+
+    // The wall must have a point on the lit side of the parent wall (opposite to the image)
+    const QPointF wall_ends[2] = {line.p1(), line.p2()};
+    bool lit_side = false;
+
+    for (int i = 0 ; i < 2 ; i++) {
+        const QPointF pt_rel = wall_ends[i] - parent_line.p1();
+        const double side_pt = cross(parent_dir, pt_rel) * (side_image > 0 ? -1.0 : 1.0);
+
+        if (side_pt > REGION_TOLERANCE * normL1(parent_dir) * normL1(pt_rel)) {
+            lit_side = true;
+        }
+    }
+
+    if (!lit_side)
+        return false;
+
+    // The wall must not be completely out of one side of the lit wedge
+    QPointF a = parent_line.p1() - parent_node.image;
+    QPointF b = parent_line.p2() - parent_node.image;
+
+    // Orient the wedge counter-clockwise
+    if (cross(a, b) < 0) {
+        std::swap(a, b);
+    }
+
+    const QPointF q1 = line.p1() - parent_node.image;
+    const QPointF q2 = line.p2() - parent_node.image;
+
+    const double tol1 = REGION_TOLERANCE * (normL1(a) + normL1(b)) * normL1(q1);
+    const double tol2 = REGION_TOLERANCE * (normL1(a) + normL1(b)) * normL1(q2);
+
+    if (cross(a, q1) < -tol1 && cross(a, q2) < -tol2)
+        return false;
+
+    if (cross(q1, b) < -tol1 && cross(q2, b) < -tol2)
+        return false;
+
+    return true;
+}
+
+QPointF ImageTree::getSource() const {
+    return m_source;
+}
+
+int ImageTree::size() const {
+    return m_nodes.size();
+}
+
+const ImageNode &ImageTree::getNode(int i) const {
+    return m_nodes[i];
+}
+
+Wall *ImageTree::getNodeWall(int i) const {
+    return m_walls[m_nodes[i].wall];
+}
+
+/**
+ * @brief ImageTree::isInValidityRegion
+ * @param i
+ * @param pt
+ * @return
+ *
+ * This function returns true if the point pt is in the validity region of the node i.
+ * This region is the wedge lit by the image through its wall (behind the wall).
+ * The last reflection of a ray path can only be on the wall if the target point (receiver)
+ * is in this region, so the other ray paths don't need to be computed.
+ */
+bool ImageTree::isInValidityRegion(int i, const QPointF &pt) const {
+    const ImageNode &node = m_nodes[i];
+    const QLineF &line = m_walls_lines[node.wall];
+
+    const QPointF wall_dir = line.p2() - line.p1();
+    const QPointF pt_rel   = pt - line.p1();
+
+    // The point must not be on the same side of the wall as the image
+    const double side_image = cross(wall_dir, node.image - line.p1());
+
+    // Degenerated case: the image is on the line of the wall (nothing to discard)
+    if (side_image == 0) {
+        return true;
+    }
+
+    const double side_pt  = cross(wall_dir, pt_rel);
+    const double side_tol = REGION_TOLERANCE * normL1(wall_dir) * normL1(pt_rel);
+
+    if ((side_image > 0 && side_pt > side_tol) || (side_image < 0 && side_pt < -side_tol)) {
+        return false;
+    }
+
+    // The point must be in the wedge formed by the image and the ends of the wall
+    QPointF a = line.p1() - node.image;
+    QPointF b = line.p2() - node.image;
+    const QPointF q = pt - node.image;
+
+    // Orient the wedge counter-clockwise
+    if (cross(a, b) < 0) {
+        std::swap(a, b);
+    }
+
+    const double wedge_tol = REGION_TOLERANCE * (normL1(a) + normL1(b)) * normL1(q);
+
+    return cross(a, q) >= -wedge_tol && cross(q, b) >= -wedge_tol;
+}
+
+/**
+ * @brief ImageTree::intersectsValidityRegion
+ * @param i
+ * @param rect
+ * @return
+ *
+ * This function returns false if no point of the rectangle can be in the validity region
+ * of the node i (see isInValidityRegion). It is used to find all the receivers of a region
+ * at once (the rectangles are cells of a receivers grid).
+ * The rectangle is out of the region if its four corners are out of the same side of the
+ * region: the tolerant tests of the sides are convex, so this is true for all its points.
+ */
+bool ImageTree::intersectsValidityRegion(int i, const QRectF &rect) const {
+    const ImageNode &node = m_nodes[i];
+    const QLineF &line = m_walls_lines[node.wall];
+
+    const QPointF wall_dir = line.p2() - line.p1();
+
+    const double side_image = cross(wall_dir, node.image - line.p1());
+
+    // Degenerated case: the image is on the line of the wall (nothing to discard)
+    if (side_image == 0) {
+        return true;
+    }
+
+    const QPointF corners[4] = {rect.topLeft(), rect.topRight(), rect.bottomRight(), rect.bottomLeft()};
+
+    // Check if all the corners are on the same side of the wall as the image
+    bool image_side = true;
+
+    for (int k = 0 ; k < 4 && image_side ; k++) {
+        const QPointF pt_rel = corners[k] - line.p1();
+
+        const double side_pt  = cross(wall_dir, pt_rel);
+        const double side_tol = RECT_TOLERANCE * normL1(wall_dir) * normL1(pt_rel);
+
+        if (!((side_image > 0 && side_pt > side_tol) || (side_image < 0 && side_pt < -side_tol))) {
+            image_side = false;
+        }
+    }
+
+    if (image_side) {
+        return false;
+    }
+
+    // Check if all the corners are out of the same side of the wedge
+    QPointF a = line.p1() - node.image;
+    QPointF b = line.p2() - node.image;
+
+    // Orient the wedge counter-clockwise
+    if (cross(a, b) < 0) {
+        std::swap(a, b);
+    }
+
+    bool out_a = true;
+    bool out_b = true;
+
+    for (int k = 0 ; k < 4 ; k++) {
+        const QPointF q = corners[k] - node.image;
+        const double wedge_tol = RECT_TOLERANCE * (normL1(a) + normL1(b)) * normL1(q);
+
+        if (cross(a, q) >= -wedge_tol) {
+            out_a = false;
+        }
+        if (cross(q, b) >= -wedge_tol) {
+            out_b = false;
+        }
+    }
+
+    return !out_a && !out_b;
+}
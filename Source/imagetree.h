@@ -0,0 +1,51 @@
+#ifndef IMAGETREE_H
+#define IMAGETREE_H
+
+#include <QPointF>
+#include <QLineF>
+#include <QRectF>
+#include <QList>
+#include <QVector>
+
+class Wall;
+
+// Node of the image tree: image of the source over a sequence of walls.
+// The walls sequence of a node is given by the walls of its parents.
+struct ImageNode {
+    QPointF image;  // Position of the image (in meters)
+    int wall;       // Index of the wall of the last reflection
+    int parent;     // Index of the parent node (-1 for a first reflection)
+    int level;      // Number of reflections (1 for a first reflection)
+};
+
+// Tree of the images of a source (emitter) over all walls sequences.
+// This tree doesn't depend on the receivers, so it is computed once
+// when the simulation starts and it is shared (read-only) by all threads.
+class ImageTree
+{
+public:
+    ImageTree(QPointF source, const QList<Wall*> &walls_list, int max_level);
+
+    QPointF getSource() const;
+
+    int size() const;
+    const ImageNode &getNode(int i) const;
+    Wall *getNodeWall(int i) const;
+
+    bool isInValidityRegion(int i, const QPointF &pt) const;
+    bool intersectsValidityRegion(int i, const QRectF &rect) const;
+
+private:
+    void buildChildren(int parent, int level, int max_level);
+    bool isWallVisible(int parent, const QPointF &source, int w) const;
+
+    QPointF m_source;
+
+    QVector<Wall*> m_walls;
+    QVector<QLineF> m_walls_lines;
+
+    // Nodes of the tree, in depth-first order
+    QVector<ImageNode> m_nodes;
+};
+
+#endif // IMAGETREE_H
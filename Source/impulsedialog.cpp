@@ -348,7 +348,7 @@ void ImpulseDialog::updateUiComponents() {
 
 QMap<double, complex> ImpulseDialog::computePhysicalImpulse() {
     // Create a triple polarization vector
-    vector<complex> polariz = {
+    Vec3c polariz = {
         m_receiver->getAntenna()->getPolarization()[0],
         m_receiver->getAntenna()->getPolarization()[0],
         m_receiver->getAntenna()->getPolarization()[1]
@@ -358,11 +358,11 @@ QMap<double, complex> ImpulseDialog::computePhysicalImpulse() {
     QHash<double,complex> imp_taps;
 
     // Generate the taps
-    foreach(RayPath *rp, m_receiver->getRayPaths()) {
-        double ampl  = rp->getAmplitude();
-        double phase = arg(dotProduct(rp->getElectricField(), polariz));
+    foreach(const RayRecord &rec, m_receiver->getRayRecords()) {
+        double ampl  = m_receiver->getRayAmplitude(rec);
+        double phase = arg(dotProduct(rec.getElectricField(), polariz));
         complex tap  = ampl*exp(1i*phase);
-        double tau   = rp->getDelay();
+        double tau   = rec.getDelay();
 
         imp_taps.insert(tau, imp_taps.value(tau, 0.0) + tap);
     }
@@ -13,6 +13,8 @@
 #include "impulsedialog.h"
 #include "coverageoptimizer.h"
 #include "optimizerdialog.h"
+#include "profilerdialog.h"
+#include "profiler.h"
 
 #include <QDebug>
 #include <QMessageBox>
@@ -53,6 +55,9 @@ MainWindow::MainWindow(QWidget *parent)
     // This attribute is true when we are dragging the scene view with the mouse
     m_dragging_view = false;
 
+    // This attribute stores the emitter moved by the user after a simulation
+    m_moving_emitter = nullptr;
+
     // The default mode for UI is the EditorMode
     m_ui_mode = UIMode::EditorMode;
 
@@ -96,6 +101,8 @@ MainWindow::MainWindow(QWidget *parent)
     m_result_radio_grp->addButton(ui->radio_result_power,       ResultType::Power);
     m_result_radio_grp->addButton(ui->radio_result_SNR,         ResultType::SNR);
     m_result_radio_grp->addButton(ui->radio_result_delay,       ResultType::DelaySpread);
+    m_result_radio_grp->addButton(ui->radio_result_mean_delay,  ResultType::MeanExcessDelay);
+    m_result_radio_grp->addButton(ui->radio_result_rms_delay,   ResultType::RmsDelaySpread);
     m_result_radio_grp->addButton(ui->radio_result_rice,        ResultType::RiceFactor);
     m_result_radio_grp->addButton(ui->radio_result_coverage,    ResultType::CoverageMap);
 
@@ -110,6 +117,7 @@ MainWindow::MainWindow(QWidget *parent)
     // Initialize simulation area and analysis line to nullptr
     m_sim_area_item = nullptr;
     m_analysis_line = nullptr;
+    m_coverage_optimizer = nullptr;
 
     // Window File menu actions
     connect(ui->actionExit, SIGNAL(triggered()), this, SLOT(close()));
@@ -131,6 +139,10 @@ MainWindow::MainWindow(QWidget *parent)
     connect(ui->actionZoomReset,    SIGNAL(triggered()), this, SLOT(actionZoomReset()));
     connect(ui->actionZoomFit,      SIGNAL(triggered()), this, SLOT(actionZoomBest()));
 
+    // The profiling summary is only available if the profiling is compiled
+    ui->actionProfilingSummary->setVisible(Profiler::isEnabled());
+    connect(ui->actionProfilingSummary, SIGNAL(triggered()), this, SLOT(showProfilingSummary()));
+
     // Right-panel buttons
     // Scene edition buttons group
     connect(ui->button_addBuilding,     SIGNAL(clicked()),      this, SLOT(addBuilding()));
@@ -159,6 +171,8 @@ MainWindow::MainWindow(QWidget *parent)
 
     connect(m_result_radio_grp, SIGNAL(idToggled(int,bool)),
             this, SLOT(resultTypeSelectionChanged(int,bool)));
+    connect(ui->combobox_result_frequency, SIGNAL(currentIndexChanged(int)),
+            this, SLOT(resultFrequencyChanged()));
 
     // Simulation handler signals
     connect(m_simulation_handler, SIGNAL(simulationStarted()), this, SLOT(simulationStarted()));
@@ -634,7 +648,7 @@ void MainWindow::graphicsSceneDoubleClicked(QGraphicsSceneMouseEvent *event) {
     // Else, if we are in simulation mode
     else {
         // Show impulse window only if no computation is running
-        if (!m_simulation_handler->isRunning()) {
+        if (!isSimulationRunning()) {
             // Loop over the items under the mouse position
             foreach(QGraphicsItem *item, m_scene->items(event->scenePos())) {
                 // Try to cast this item
@@ -643,7 +657,16 @@ void MainWindow::graphicsSceneDoubleClicked(QGraphicsSceneMouseEvent *event) {
                 // If one of them is an Receiver -> show impulse responses
                 if (re != nullptr) {
                     showImpulseResponses(re);
-                    break;
+                    return;
+                }
+            }
+
+            // The receivers of the simulation area are not in the scene
+            if (m_sim_area_item != nullptr) {
+                Receiver *re = m_sim_area_item->getReceiverAt(event->scenePos());
+
+                if (re != nullptr) {
+                    showImpulseResponses(re);
                 }
             }
         }
@@ -667,7 +690,20 @@ void MainWindow::graphicsSceneRightReleased(QGraphicsSceneMouseEvent *) {
  * Slot called when the user presses the left button on the graphics scene
  */
 void MainWindow::graphicsSceneLeftPressed(QGraphicsSceneMouseEvent *event) {
-    Q_UNUSED(event);
+    // The emitters can be moved once the simulation is done:
+    // only the rays of the moved emitter are computed again
+    if (m_ui_mode == UIMode::SimulationMode && m_simulation_handler->isDone()) {
+        foreach (QGraphicsItem *item, m_scene->items(event->scenePos())) {
+            Emitter *em = dynamic_cast<Emitter*>(item);
+
+            if (em != nullptr) {
+                m_moving_emitter = em;
+                m_moving_emitter_pos = em->pos();
+                ui->graphicsView->setCursor(Qt::ClosedHandCursor);
+                return;
+            }
+        }
+    }
 
     // If no draw action pending -> start view dragging
     if (m_draw_action == DrawActions::None) {
@@ -691,6 +727,16 @@ void MainWindow::graphicsSceneLeftReleased(QGraphicsSceneMouseEvent *event) {
         ui->graphicsView->setCursor(Qt::ArrowCursor);
     }
 
+    // Update the results for the new position of the moved emitter
+    if (m_moving_emitter) {
+        if (m_moving_emitter->pos() != m_moving_emitter_pos) {
+            m_simulation_handler->updateEmitter(m_moving_emitter);
+        }
+
+        m_moving_emitter = nullptr;
+        ui->graphicsView->setCursor(Qt::ArrowCursor);
+    }
+
     // Actions to do when we are placing an item
     switch (m_draw_action) {
     //////////////////////////////// BUILDING ACTION ////////////////////////////////
@@ -863,6 +909,18 @@ void MainWindow::graphicsSceneMouseMoved(QGraphicsSceneMouseEvent *event) {
         moveSceneView(delta_mouse / view_scale);
     }
 
+    // The moved emitter follows the mouse (aligned as when it was placed)
+    if (m_moving_emitter) {
+        qreal scale = m_scene->simulationScale();
+
+        // If ALT modifier is not pressed
+        if (!(event->modifiers() & Qt::AltModifier)) {
+            scale = m_scene->simulationScale() * BUILDING_GRID_SIZE;
+        }
+
+        m_moving_emitter->setPos(QPoint(pos / scale) * scale);
+    }
+
     // Show mouse tracker only if we are placing something
     setMouseTrackerVisible(m_draw_action != DrawActions::None);
 
@@ -1187,6 +1245,16 @@ void MainWindow::actionZoomBest() {
     bestView();
 }
 
+/**
+ * @brief MainWindow::showProfilingSummary
+ *
+ * Shows the profiling data of the last simulation run (profiling builds only)
+ */
+void MainWindow::showProfilingSummary() {
+    ProfilerDialog prof_dialog(this);
+    prof_dialog.exec();
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 //////////////////////////////////// PANEL SWITCHING FUNCTIONS /////////////////////////////////////
@@ -1248,6 +1316,20 @@ void MainWindow::switchEditSceneMode(bool ask) {
     updateSceneRect();
 }
 
+/**
+ * @brief MainWindow::isSimulationRunning
+ * @return
+ *
+ * Returns true if a simulation or a coverage optimization is running
+ */
+bool MainWindow::isSimulationRunning() {
+    return m_simulation_handler->isRunning() || (m_coverage_optimizer && m_coverage_optimizer->isRunning());
+}
+
+bool MainWindow::isSimulationCancelling() {
+    return m_simulation_handler->isCancelling() || (m_coverage_optimizer && m_coverage_optimizer->isCancelling());
+}
+
 void MainWindow::updateSimulationUI() {
     // Get the simulation type
     SimType::SimType sim_type = SimulationHandler::simulationData()->simulationType();
@@ -1256,7 +1338,7 @@ void MainWindow::updateSimulationUI() {
     ui->combobox_simType->setCurrentIndex(sim_type);
 
     // Show/Hide simulation progress bar
-    ui->progressbar_simulation->setVisible(m_simulation_handler->isRunning());
+    ui->progressbar_simulation->setVisible(isSimulationRunning());
 
     // Show/hide widget groups
     ui->group_show_rays->setVisible(sim_type == SimType::PointReceiver);
@@ -1270,23 +1352,23 @@ void MainWindow::updateSimulationUI() {
     ui->slider_threshold->setEnabled(ui->checkbox_rays->isChecked());
 
     // Enable/disable the UI controls if simulation is running
-    ui->combobox_simType->setDisabled(m_simulation_handler->isRunning());
-    ui->combobox_antennas_type->setDisabled(m_simulation_handler->isRunning());
-    ui->button_simReset->setDisabled(m_simulation_handler->isRunning());
-    ui->button_editScene->setDisabled(m_simulation_handler->isRunning());
-    ui->actionOpen->setDisabled(m_simulation_handler->isRunning());
-    ui->actionSimulation_setup->setDisabled(m_simulation_handler->isRunning());
-    ui->button_simSetup->setDisabled(m_simulation_handler->isRunning());
-    ui->button_analysisLine->setDisabled(m_simulation_handler->isRunning());
-    ui->group_result_type->setDisabled(m_simulation_handler->isRunning());
+    ui->combobox_simType->setDisabled(isSimulationRunning());
+    ui->combobox_antennas_type->setDisabled(isSimulationRunning());
+    ui->button_simReset->setDisabled(isSimulationRunning());
+    ui->button_editScene->setDisabled(isSimulationRunning());
+    ui->actionOpen->setDisabled(isSimulationRunning());
+    ui->actionSimulation_setup->setDisabled(isSimulationRunning());
+    ui->button_simSetup->setDisabled(isSimulationRunning());
+    ui->button_analysisLine->setDisabled(isSimulationRunning());
+    ui->group_result_type->setDisabled(isSimulationRunning());
 
     // Change the control button text
-    ui->button_simControl->setEnabled(!m_simulation_handler->isCancelling());
+    ui->button_simControl->setEnabled(!isSimulationCancelling());
 
-    if (m_simulation_handler->isCancelling()) {
+    if (isSimulationCancelling()) {
         ui->button_simControl->setText("Canceling...");
     }
-    else if (m_simulation_handler->isRunning()) {
+    else if (isSimulationRunning()) {
         ui->button_simControl->setText("Cancel simulation");
     }
     else  {
@@ -1295,6 +1377,7 @@ void MainWindow::updateSimulationUI() {
 
     // Update result type buttons
     updateResultTypeRadios();
+    updateResultFrequencies();
 }
 
 void MainWindow::updateSimulationScene() {
@@ -1353,6 +1436,8 @@ void MainWindow::updateResultTypeRadios() {
     // If there are more than one emitter -> no Delay Spread nor Rice Factor
     if (em_count > 1) {
         ui->radio_result_delay->setEnabled(false);
+        ui->radio_result_mean_delay->setEnabled(false);
+        ui->radio_result_rms_delay->setEnabled(false);
         ui->radio_result_rice->setEnabled(false);
 
         // Get the currently selected result type
@@ -1360,6 +1445,8 @@ void MainWindow::updateResultTypeRadios() {
 
         // Select another radio if the currently checked is unavailable
         if (res_type == ResultType::DelaySpread ||
+            res_type == ResultType::MeanExcessDelay ||
+            res_type == ResultType::RmsDelaySpread ||
             res_type == ResultType::RiceFactor)
         {
             ui->radio_result_power->setChecked(true);
@@ -1367,10 +1454,43 @@ void MainWindow::updateResultTypeRadios() {
     }
     else {
         ui->radio_result_delay->setEnabled(true);
+        ui->radio_result_mean_delay->setEnabled(true);
+        ui->radio_result_rms_delay->setEnabled(true);
         ui->radio_result_rice->setEnabled(true);
     }
 }
 
+/**
+ * @brief MainWindow::updateResultFrequencies
+ *
+ * This function fills the frequencies of the shown results: the frequencies
+ * of the emitters, and the frequencies of the sweep (if enabled)
+ */
+void MainWindow::updateResultFrequencies() {
+    const QVector<double> sweep = SimulationHandler::simulationData()->getSweepFrequencies();
+
+    // Keep the selected frequency if it is still in the sweep
+    int sweep_index = Receiver::resultsSweepIndex();
+
+    if (sweep_index >= sweep.size()) {
+        sweep_index = -1;
+    }
+
+    ui->combobox_result_frequency->blockSignals(true);
+    ui->combobox_result_frequency->clear();
+    ui->combobox_result_frequency->addItem("Emitters frequencies", -1);
+
+    for (int i = 0 ; i < sweep.size() ; i++) {
+        ui->combobox_result_frequency->addItem(QString("%1 GHz").arg(sweep[i] * 1e-9, 0, 'f', 3), i);
+    }
+
+    ui->combobox_result_frequency->setCurrentIndex(sweep_index + 1);
+    ui->combobox_result_frequency->setEnabled(!sweep.isEmpty());
+    ui->combobox_result_frequency->blockSignals(false);
+
+    Receiver::setResultsSweepIndex(sweep_index);
+}
+
 void MainWindow::setPointReceiversVisible(bool visible) {
     foreach(Receiver *r, m_simulation_handler->simulationData()->getReceiverList()) {
         r->setVisible(visible);
@@ -1504,9 +1624,17 @@ void MainWindow::drawAnalysisLine() {
 void MainWindow::simulationSetupAction() {
     // Open the setup dialog
     SimSetupDialog setup_dialog(m_simulation_handler->simulationData());
-    setup_dialog.exec();
+    int ans = setup_dialog.exec();
 
     // Note that the setup dialog modifies itself the parameters in simulationData
+
+    // Evaluate the computed ray paths at the new sweep frequencies (if any result)
+    if (ans == QDialog::Accepted && m_simulation_handler->isDone() && !isSimulationRunning()) {
+        m_simulation_handler->evaluateFrequencySweep();
+
+        updateResultFrequencies();
+        showReceiversResult();
+    }
 }
 
 void MainWindow::simulationControlAction() {
@@ -1536,7 +1664,7 @@ void MainWindow::simulationControlAction() {
     }
 
     // If there is no simulation computation currently running
-    if (!m_simulation_handler->isRunning())
+    if (!isSimulationRunning())
     {
         // Start the computation for the current simulation type
         switch (m_simulation_handler->simulationData()->simulationType())
@@ -1586,59 +1714,44 @@ void MainWindow::simulationControlAction() {
 
             // Create and exec the optimizer dialog
             OptimizerDialog optim_dialog(this);
+            optim_dialog.setSimulationArea(m_sim_area_item->getRealArea());
             int ans = optim_dialog.exec();
 
             // Cancel if the dialog was not accepted
             if (ans != QDialog::Accepted)
                 return;
 
-            // Initialize the coverage optimizer
-            CoverageOptimizer optimizer(m_simulation_handler, m_sim_area_item);
+            // Initialize the coverage optimizer.
+            // It runs from the event loop, and notifies the window of its progress.
+            m_coverage_optimizer = new CoverageOptimizer(m_simulation_handler, m_sim_area_item, this);
+
+            connect(m_coverage_optimizer, SIGNAL(optimizationProgress(double)), this, SLOT(optimizationProgress(double)));
+            connect(m_coverage_optimizer, SIGNAL(layoutUpdated()), this, SLOT(optimizationLayoutUpdated()));
+            connect(m_coverage_optimizer, SIGNAL(optimizationFinished(bool)), this, SLOT(optimizationFinished(bool)));
+            connect(m_coverage_optimizer, SIGNAL(optimizationCancelled()), this, SLOT(optimizationCancelled()));
 
             // Show the heat map with an initial range (just to avoid a range of [NaN;NaN]).
             // Its content will be updated by the optimizer.
             showResultHeatMap();
 
             // Start the optimization process with parameters given in optimizer dialog
-            bool optim_done = optimizer.optimizeEmitters(
+            m_coverage_optimizer->setCandidateGenerator(optim_dialog.getCandidateGenerator());
+            m_coverage_optimizer->startOptimization(
                         optim_dialog.getCoverThreshold(),
                         optim_dialog.getCoverMargin(),
                         optim_dialog.getFrequency(),
                         optim_dialog.getEIRP(),
                         optim_dialog.getEfficiency(),
-                        optim_dialog.getAntennaType());
-
-            if (optim_done) {
-                // Show the results
-                showResultHeatMap();
-
-                // Show a summary of the optimization process
-                QString optim_summary =
-                        "<h1>Optimization finished</h1>"
-                        "<p><b>Placed emitters:</b> %3</p>"
-                        "<p><b>Total map coverage:</b> %4&nbsp;\%</p>"
-                        "<p><b>Coverage with margin:</b> %5&nbsp;\%</p>"
-                        "<p><b>Optimization duration:</b> %1&nbsp;%2</p>";
-
-                // Convert the delay to human readable
-                QString units;
-                double duration = SimulationData::delayToHumanReadable(optimizer.getTimeElapsed(), &units);
-
-                optim_summary = optim_summary.arg(duration, 0, 'f', 2).arg(units);
-                optim_summary = optim_summary.arg(optimizer.getNumPlacedEmitters());
-                optim_summary = optim_summary.arg(optimizer.getTotalCoverage()*100, 0, 'f', 2);
-                optim_summary = optim_summary.arg(optimizer.getTotalCoverageMargin()*100, 0, 'f', 2);
-
-                // Show in a message box
-                QMessageBox::information(
-                            this,
-                            "Optimization finished",
-                            optim_summary);
-            }
+                        optim_dialog.getAntennaType(),
+                        optim_dialog.getPlacementMethod());
             break;
         }
         }
     }
+    else if (m_coverage_optimizer && m_coverage_optimizer->isRunning()) {
+        // Cancel the current optimization (and its simulation)
+        m_coverage_optimizer->stopOptimization();
+    }
     else {
         // Cancel the current simulation
         m_simulation_handler->stopSimulationComputation();
@@ -1724,6 +1837,13 @@ void MainWindow::resultTypeSelectionChanged(int, bool checked) {
     showReceiversResult();
 }
 
+void MainWindow::resultFrequencyChanged() {
+    Receiver::setResultsSweepIndex(ui->combobox_result_frequency->currentData().toInt());
+
+    // Update the view
+    showReceiversResult();
+}
+
 
 void MainWindow::simulationStarted() {
     // Update the UI controls
@@ -1738,9 +1858,11 @@ void MainWindow::simulationFinished() {
     updateSimulationUI();
 
     if (SimulationHandler::simulationData()->simulationType() == SimType::PointReceiver) {
-        // Add all computed rays to the scene
-        foreach (RayPath *rp, m_simulation_handler->getRayPathsList()) {
-            m_scene->addItem(rp);
+        // Create the graphics items of the computed rays, and add them to the scene
+        foreach (Receiver *r, SimulationHandler::simulationData()->getReceiverList()) {
+            foreach (RayPath *rp, r->createRayPathItems()) {
+                m_scene->addItem(rp);
+            }
         }
     }
 
@@ -1757,10 +1879,73 @@ void MainWindow::simulationCancelled() {
 }
 
 void MainWindow::simulationProgress(double p) {
+    // The progress bar shows the progress of the optimization (if one)
+    if (m_coverage_optimizer)
+        return;
+
     // Update the progress bar's value
     ui->progressbar_simulation->setValue(p * 100);
 }
 
+void MainWindow::optimizationProgress(double p) {
+    // Update the progress bar's value
+    ui->progressbar_simulation->setValue(p * 100);
+}
+
+void MainWindow::optimizationLayoutUpdated() {
+    // Show the emitters placed so far, and their coverage
+    showResultHeatMap();
+    updateResultTypeRadios();
+}
+
+void MainWindow::optimizationFinished(bool optimized) {
+    // Show the results
+    showResultHeatMap();
+
+    // Show a summary of the optimization process
+    QString optim_summary =
+            "<h1>Optimization finished</h1>"
+            "<p><b>Placed emitters:</b> %3</p>"
+            "<p><b>Total map coverage:</b> %4&nbsp;\%</p>"
+            "<p><b>Coverage with margin:</b> %5&nbsp;\%</p>"
+            "<p><b>Optimization duration:</b> %1&nbsp;%2</p>";
+
+    // Convert the delay to human readable
+    QString units;
+    double duration = SimulationData::delayToHumanReadable(m_coverage_optimizer->getTimeElapsed(), &units);
+
+    optim_summary = optim_summary.arg(duration, 0, 'f', 2).arg(units);
+    optim_summary = optim_summary.arg(m_coverage_optimizer->getNumPlacedEmitters());
+    optim_summary = optim_summary.arg(m_coverage_optimizer->getTotalCoverage()*100, 0, 'f', 2);
+    optim_summary = optim_summary.arg(m_coverage_optimizer->getTotalCoverageMargin()*100, 0, 'f', 2);
+
+    // The optimizer is deleted once its signal is handled
+    m_coverage_optimizer->deleteLater();
+    m_coverage_optimizer = nullptr;
+
+    // Enable the UI controls
+    updateSimulationUI();
+
+    if (optimized) {
+        // Show in a message box
+        QMessageBox::information(
+                    this,
+                    "Optimization finished",
+                    optim_summary);
+    }
+}
+
+void MainWindow::optimizationCancelled() {
+    m_coverage_optimizer->deleteLater();
+    m_coverage_optimizer = nullptr;
+
+    // Update the UI
+    updateSimulationUI();
+
+    // Reset the simulations
+    simulationReset();
+}
+
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -1773,6 +1958,7 @@ void MainWindow::simulationReset() {
 
     if (m_sim_area_item) {
         m_sim_area_item->deletePlacedEmitters();
+        m_sim_area_item->hideResults();
     }
 }
 
@@ -1802,7 +1988,7 @@ void MainWindow::filterRaysThreshold() {
     {
         // Hide the RayPaths with a power lower than the threshold, or checkbox not checked, or
         // UI is not in simulation mode, or simulation type is area
-        if (rp->computePower() > threshold &&
+        if (rp->getPower() > threshold &&
                 ui->checkbox_rays->isChecked() &&
                 m_ui_mode == UIMode::SimulationMode &&
                 m_simulation_handler->simulationData()->simulationType() == SimType::PointReceiver)
@@ -1878,7 +2064,9 @@ void MainWindow::showResultHeatMap() {
             max = 50;
             break;
         }
-        case ResultType::DelaySpread: {
+        case ResultType::DelaySpread:
+        case ResultType::MeanExcessDelay:
+        case ResultType::RmsDelaySpread: {
             min = 0;
             max = 1e-6;
             break;
@@ -1890,12 +2078,8 @@ void MainWindow::showResultHeatMap() {
         }
     }
 
-    // Loop over every receiver and show its results
-    foreach(Receiver *re , m_sim_area_item->getReceiversList())
-    {
-        // Show the results of each receiver
-        re->showResults(res_type, min, max);
-    }
+    // Draw the heat map of the area
+    m_sim_area_item->showResults(res_type, min, max);
 
     m_scene->showDataLegend(res_type, min, max);
 }
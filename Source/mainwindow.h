@@ -12,6 +12,8 @@
 #include "analysisline.h"
 #include "simulationarea.h"
 
+class CoverageOptimizer;
+
 namespace DrawActions {
 enum DrawActions {
     None,
@@ -70,6 +72,8 @@ public slots:
     void actionZoomReset();
     void actionZoomBest();
 
+    void showProfilingSummary();
+
     void clearAllItems();
     void cancelCurrentDrawing();
 
@@ -113,16 +117,25 @@ private slots:
     void raysThresholdChanged(int val);
 
     void resultTypeSelectionChanged(int, bool checked);
+    void resultFrequencyChanged();
 
     void simulationStarted();
     void simulationFinished();
     void simulationCancelled();
     void simulationProgress(double);
 
+    void optimizationProgress(double);
+    void optimizationLayoutUpdated();
+    void optimizationFinished(bool optimized);
+    void optimizationCancelled();
+
 private:
+    bool isSimulationRunning();
+    bool isSimulationCancelling();
     void updateSimulationUI();
     void updateSimulationScene();
     void updateResultTypeRadios();
+    void updateResultFrequencies();
     void setPointReceiversVisible(bool visible);
     void setPointEmittersVisible(bool visible);
     void createSimArea();
@@ -157,9 +170,16 @@ private:
 
     bool m_dragging_view;
 
+    // Emitter moved with the mouse after a simulation (incremental update)
+    Emitter *m_moving_emitter;
+    QPointF m_moving_emitter_pos;
+
     SimulationArea *m_sim_area_item;
     AnalysisLine *m_analysis_line;
 
+    // Coverage optimization running (nullptr if none)
+    CoverageOptimizer *m_coverage_optimizer;
+
     QButtonGroup *m_result_radio_grp;
     QActionGroup *m_map_edit_act_grp;
 };
@@ -4,6 +4,10 @@
 #include "antennas.h"
 #include "simulationdata.h"
 #include "simulationhandler.h"
+#include "mainwindow.h"
+
+#include <QFileDialog>
+#include <QMessageBox>
 
 OptimizerDialog::OptimizerDialog(QWidget *parent) :
     QDialog(parent),
@@ -26,9 +30,14 @@ OptimizerDialog::OptimizerDialog(QWidget *parent) :
         delete ant;
     }
 
+    // Add items to the placement method combobox
+    ui->combobox_placement_method->addItem("Simulation of each emitter", OptimizerMode::Iterative);
+    ui->combobox_placement_method->addItem("Precomputed coverage (fast)", OptimizerMode::LazyGreedy);
+
     connect(ui->spinbox_eirp, SIGNAL(valueChanged(double)), this, SLOT(emitterConfigurationChanged()));
     connect(ui->combobox_antenna_type, SIGNAL(currentIndexChanged(int)), this, SLOT(emitterConfigurationChanged()));
     connect(ui->spinbox_efficiency, SIGNAL(valueChanged(double)), this, SLOT(emitterConfigurationChanged()));
+    connect(ui->button_sites_file, SIGNAL(clicked()), this, SLOT(importSitesFile()));
 
     emitterConfigurationChanged();
 }
@@ -64,6 +73,31 @@ double OptimizerDialog::getCoverMargin() {
     return ui->coverageMarginSpinBox->value();
 }
 
+OptimizerMode::OptimizerMode OptimizerDialog::getPlacementMethod() {
+    return (OptimizerMode::OptimizerMode) ui->combobox_placement_method->currentData().toInt();
+}
+
+/**
+ * @brief OptimizerDialog::getCandidateGenerator
+ * @return
+ *
+ * Returns the generator of the candidate positions, with the imported sites
+ * and the facade sampling selected in the dialog
+ */
+CandidateGenerator OptimizerDialog::getCandidateGenerator() {
+    CandidateGenerator generator = m_candidate_generator;
+
+    // A spacing of 0 means no facade sampling
+    double spacing = ui->facadeSpacingSpinBox->value();
+    generator.setFacadesEnabled(spacing > 0);
+
+    if (spacing > 0) {
+        generator.setSamplingSpacing(spacing);
+    }
+
+    return generator;
+}
+
 
 /**
  * @brief OptimizerDialog::emitterConfigurationChanged
@@ -93,6 +127,62 @@ void OptimizerDialog::emitterConfigurationChanged() {
     ui->label_power_watts->setText(QString("= %1 %2 = %3 dBm").arg(power_watts, 0, 'f', 2).arg(suffix).arg(power_dbm, 0, 'f', 1));
 }
 
+/**
+ * @brief OptimizerDialog::importSitesFile
+ *
+ * This slot asks for a file of poles and mount lines, and loads it
+ * in the candidate generator
+ */
+void OptimizerDialog::importSitesFile() {
+    // Open file selection dialog
+    QString file_path = QFileDialog::getOpenFileName(
+                this,
+                "Import mount sites",
+                MainWindow::lastUsedDirectory().path(),
+                "CSV File (*.csv);;Text file (*.txt)");
+
+    // If the user cancelled the dialog
+    if (file_path.isEmpty()) {
+        return;
+    }
+
+    // Set the last used directory
+    MainWindow::setLastUsedDirectory(QFileInfo(file_path).dir());
+
+    QString error;
+
+    if (!m_candidate_generator.loadSitesFile(file_path, &error)) {
+        QMessageBox::critical(this, "Error", QString("Unable to import the mount sites:\n%1").arg(error));
+        return;
+    }
+
+    // Count the sites outside the simulation area or inside a building
+    int rejected = 0;
+    int placeable = m_candidate_generator.countPlaceableSites(&rejected);
+
+    ui->lineedit_sites_file->setText(
+                QString("%1 (%2 usable sites, %3 rejected)")
+                .arg(QFileInfo(file_path).fileName())
+                .arg(placeable)
+                .arg(rejected));
+}
+
+/**
+ * @brief OptimizerDialog::setSimulationArea
+ * @param real_area
+ *
+ * Sets the simulation area (in meters) where the imported sites must be placed
+ */
+void OptimizerDialog::setSimulationArea(const QRectF &real_area) {
+    QList<QRectF> buildings;
+
+    foreach (Building *b, SimulationHandler::simulationData()->getBuildingsList()) {
+        buildings.append(b->getRealRect());
+    }
+
+    m_candidate_generator.setPlacementArea(real_area, buildings);
+}
+
 
 /**
  * @brief OptimizerDialog::exec
@@ -4,6 +4,8 @@
 #include <QDialog>
 
 #include "antennas.h"
+#include "candidategenerator.h"
+#include "coverageoptimizer.h"
 
 namespace Ui {
 class OptimizerDialog;
@@ -24,15 +26,22 @@ public:
 
     double getCoverThreshold();
     double getCoverMargin();
+    OptimizerMode::OptimizerMode getPlacementMethod();
+    CandidateGenerator getCandidateGenerator();
+
+    void setSimulationArea(const QRectF &real_area);
 
 public slots:
     virtual int exec();
 
 private slots:
     void emitterConfigurationChanged();
+    void importSitesFile();
 
 private:
     Ui::OptimizerDialog *ui;
+
+    CandidateGenerator m_candidate_generator;
 };
 
 #endif // OPTIMIZERDIALOG_H
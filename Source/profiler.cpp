@@ -0,0 +1,348 @@
+#include "profiler.h"
+
+#include <algorithm>
+
+#include <QCoreApplication>
+#include <QStringList>
+#include <QThread>
+
+// Profile of the current thread, and the run for which it was registered
+static thread_local ThreadProfile *tl_profile = nullptr;
+static thread_local int tl_run_id = -1;
+
+
+Profiler::Profiler()
+{
+    m_run_time = 0;
+    m_run_id = 0;
+
+    m_timer.start();
+}
+
+Profiler::~Profiler()
+{
+    clear();
+}
+
+/**
+ * @brief Profiler::instance
+ * @return
+ *
+ * Returns the profiler of the application
+ */
+Profiler *Profiler::instance() {
+    static Profiler profiler;
+    return &profiler;
+}
+
+/**
+ * @brief Profiler::isEnabled
+ * @return
+ *
+ * Returns true if the profiling was compiled (CONFIG += profiling)
+ */
+bool Profiler::isEnabled() {
+#ifdef PROFILING
+    return true;
+#else
+    return false;
+#endif
+}
+
+QString Profiler::stageName(ProfileStage::ProfileStage stage) {
+    switch (stage) {
+    case ProfileStage::Setup:
+        return "Setup";
+    case ProfileStage::ReflectionCandidates:
+        return "buildReflectionCandidates";
+    case ProfileStage::Worker:
+        return "Worker";
+    case ProfileStage::Mirror:
+        return "mirror";
+    case ProfileStage::ComputeRayPath:
+        return "computeRayPath";
+    case ProfileStage::CheckIntersections:
+        return "checkIntersections";
+    case ProfileStage::DiffractedRay:
+        return "computeDiffractedRay";
+    case ProfileStage::GroundReflection:
+        return "computeGroundReflection";
+    case ProfileStage::AddRayPath:
+        return "Receiver::addRayPaths";
+    case ProfileStage::StagesCount:
+        break;
+    }
+
+    return QString();
+}
+
+QString Profiler::counterName(ProfileCounter::ProfileCounter counter) {
+    switch (counter) {
+    case ProfileCounter::WallTests:
+        return "Wall intersection tests";
+    case ProfileCounter::DirectTested:
+        return "Direct paths tested";
+    case ProfileCounter::DirectAccepted:
+        return "Direct paths accepted";
+    case ProfileCounter::ReflectionTested:
+        return "Reflected paths tested";
+    case ProfileCounter::ReflectionAccepted:
+        return "Reflected paths accepted";
+    case ProfileCounter::DiffractionTested:
+        return "Diffracted paths tested";
+    case ProfileCounter::DiffractionAccepted:
+        return "Diffracted paths accepted";
+    case ProfileCounter::GroundTested:
+        return "Ground paths tested";
+    case ProfileCounter::GroundAccepted:
+        return "Ground paths accepted";
+    case ProfileCounter::CountersCount:
+        break;
+    }
+
+    return QString();
+}
+
+void Profiler::clear() {
+    foreach (ThreadProfile *tp, m_threads) {
+        delete tp;
+    }
+
+    m_threads.clear();
+}
+
+/**
+ * @brief Profiler::beginRun
+ *
+ * This function discards the data of the previous run and starts a new one.
+ * It must be called when no computation is running.
+ */
+void Profiler::beginRun() {
+    QMutexLocker locker(&m_mutex);
+
+    clear();
+
+    // The threads register again at their first event of the new run
+    m_run_id++;
+    m_run_time = 0;
+    m_timer.restart();
+}
+
+/**
+ * @brief Profiler::endRun
+ *
+ * This function stops the run. The collected data can then be read
+ * (all the computation units must be done).
+ */
+void Profiler::endRun() {
+    QMutexLocker locker(&m_mutex);
+    m_run_time = m_timer.nsecsElapsed();
+}
+
+qint64 Profiler::now() const {
+    return m_timer.nsecsElapsed();
+}
+
+/**
+ * @brief Profiler::threadProfile
+ * @return
+ *
+ * Returns the profile of the current thread for the current run
+ * (registered at the first call of the run)
+ */
+ThreadProfile *Profiler::threadProfile() {
+    if (tl_profile != nullptr && tl_run_id == m_run_id)
+        return tl_profile;
+
+    QMutexLocker locker(&m_mutex);
+
+    ThreadProfile *tp = new ThreadProfile();
+    tp->dropped_events = 0;
+    std::fill(tp->stage_calls, tp->stage_calls + ProfileStage::StagesCount, 0);
+    std::fill(tp->stage_time, tp->stage_time + ProfileStage::StagesCount, 0);
+    std::fill(tp->counters, tp->counters + ProfileCounter::CountersCount, 0);
+
+    if (QCoreApplication::instance() && QThread::currentThread() == QCoreApplication::instance()->thread()) {
+        tp->name = "Main thread";
+    }
+    else {
+        tp->name = QString("Worker %1").arg(m_threads.size());
+    }
+
+    m_threads.append(tp);
+
+    tl_profile = tp;
+    tl_run_id = m_run_id;
+
+    return tp;
+}
+
+bool Profiler::hasRun() const {
+    return m_run_time > 0;
+}
+
+qint64 Profiler::runTime() const {
+    return m_run_time;
+}
+
+qint64 Profiler::stageCalls(ProfileStage::ProfileStage stage) const {
+    qint64 calls = 0;
+
+    foreach (ThreadProfile *tp, m_threads) {
+        calls += tp->stage_calls[stage];
+    }
+
+    return calls;
+}
+
+/**
+ * @brief Profiler::stageTime
+ * @param stage
+ * @return
+ *
+ * Returns the total time spent in the stage by all threads (in nanoseconds).
+ * The time of a stage includes the time of its nested stages.
+ */
+qint64 Profiler::stageTime(ProfileStage::ProfileStage stage) const {
+    qint64 time = 0;
+
+    foreach (ThreadProfile *tp, m_threads) {
+        time += tp->stage_time[stage];
+    }
+
+    return time;
+}
+
+qint64 Profiler::counter(ProfileCounter::ProfileCounter counter) const {
+    qint64 count = 0;
+
+    foreach (ThreadProfile *tp, m_threads) {
+        count += tp->counters[counter];
+    }
+
+    return count;
+}
+
+int Profiler::threadsCount() const {
+    return m_threads.size();
+}
+
+QString Profiler::threadName(int thread) const {
+    return m_threads[thread]->name;
+}
+
+/**
+ * @brief Profiler::threadBusyTime
+ * @param thread
+ * @return
+ *
+ * Returns the time spent by the thread in the setup and in the computation units
+ * (in nanoseconds)
+ */
+qint64 Profiler::threadBusyTime(int thread) const {
+    return m_threads[thread]->stage_time[ProfileStage::Setup] +
+           m_threads[thread]->stage_time[ProfileStage::Worker];
+}
+
+/**
+ * @brief Profiler::droppedEvents
+ * @return
+ *
+ * Returns the number of events missing in the trace (full buffers of the threads).
+ * These events are still counted in the stages times.
+ */
+qint64 Profiler::droppedEvents() const {
+    qint64 dropped = 0;
+
+    foreach (ThreadProfile *tp, m_threads) {
+        dropped += tp->dropped_events;
+    }
+
+    return dropped;
+}
+
+/**
+ * @brief Profiler::chromeTrace
+ * @return
+ *
+ * This function returns the events of the last run in the Chrome trace-event
+ * JSON format (to load in chrome://tracing or Perfetto).
+ * The counters of the run are added as a counter event at the end of the run.
+ */
+QByteArray Profiler::chromeTrace() const {
+    QByteArray json;
+    json.reserve(1024 * 1024);
+
+    json.append("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+    bool first = true;
+
+    for (int tid = 0 ; tid < m_threads.size() ; tid++) {
+        const ThreadProfile *tp = m_threads[tid];
+
+        if (!first) {
+            json.append(",\n");
+        }
+        first = false;
+
+        // Name of the thread
+        json.append(QString("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%1,\"args\":{\"name\":\"%2\"}}")
+                    .arg(tid).arg(tp->name).toUtf8());
+
+        // Complete events (timestamps in microseconds)
+        foreach (const ProfileEvent &ev, tp->events) {
+            json.append(QString(",\n{\"name\":\"%1\",\"cat\":\"engine\",\"ph\":\"X\",\"ts\":%2,\"dur\":%3,\"pid\":1,\"tid\":%4}")
+                        .arg(stageName(ev.stage))
+                        .arg(ev.start / 1e3, 0, 'f', 3)
+                        .arg(ev.duration / 1e3, 0, 'f', 3)
+                        .arg(tid).toUtf8());
+        }
+    }
+
+    // Counters of the run
+    QStringList counters;
+
+    for (int c = 0 ; c < ProfileCounter::CountersCount ; c++) {
+        counters.append(QString("\"%1\":%2")
+                        .arg(counterName((ProfileCounter::ProfileCounter) c))
+                        .arg(counter((ProfileCounter::ProfileCounter) c)));
+    }
+
+    if (!first) {
+        json.append(",\n");
+    }
+
+    json.append(QString("{\"name\":\"Counters\",\"ph\":\"C\",\"ts\":%1,\"pid\":1,\"tid\":0,\"args\":{%2}}")
+                .arg(m_run_time / 1e3, 0, 'f', 3)
+                .arg(counters.join(",")).toUtf8());
+
+    json.append("\n]}\n");
+
+    return json;
+}
+
+
+ProfileScope::ProfileScope(ProfileStage::ProfileStage stage)
+{
+    m_stage = stage;
+    m_start = Profiler::instance()->now();
+}
+
+ProfileScope::~ProfileScope()
+{
+    Profiler *profiler = Profiler::instance();
+    ThreadProfile *tp = profiler->threadProfile();
+
+    const qint64 duration = profiler->now() - m_start;
+
+    tp->stage_calls[m_stage]++;
+    tp->stage_time[m_stage] += duration;
+
+    // Keep the event for the trace (if the buffer of the thread is not full)
+    if (tp->events.size() < PROFILER_MAX_THREAD_EVENTS) {
+        tp->events.append({m_start, duration, m_stage});
+    }
+    else {
+        tp->dropped_events++;
+    }
+}
@@ -0,0 +1,136 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+// The profiling of the engine is only compiled with "CONFIG += profiling" (qmake),
+// which defines PROFILING. Otherwise the PROFILE_* macros are empty, so the
+// instrumented functions have no overhead.
+
+namespace ProfileStage {
+enum ProfileStage {
+    Setup,              // Walls, corners, walls grid and image trees of a run
+    ReflectionCandidates, // Receivers in the validity regions of the images (reciprocity mode)
+    Worker,             // Busy time of a computation unit
+    Mirror,
+    ComputeRayPath,
+    CheckIntersections,
+    DiffractedRay,
+    GroundReflection,
+    AddRayPath,
+    StagesCount
+};
+}
+
+namespace ProfileCounter {
+enum ProfileCounter {
+    WallTests,          // Ray-wall intersection tests
+    DirectTested,       // Paths tested and accepted by each stage
+    DirectAccepted,     // (the rejected ones are the difference)
+    ReflectionTested,
+    ReflectionAccepted,
+    DiffractionTested,
+    DiffractionAccepted,
+    GroundTested,
+    GroundAccepted,
+    CountersCount
+};
+}
+
+// Maximum number of trace events kept per thread (the next ones are only aggregated)
+#define PROFILER_MAX_THREAD_EVENTS  200000
+
+
+// Timed event of a stage (in nanoseconds since the start of the run)
+struct ProfileEvent {
+    qint64 start;
+    qint64 duration;
+    ProfileStage::ProfileStage stage;
+};
+
+// Data collected by one thread during a run (only written by this thread)
+struct ThreadProfile {
+    QString name;
+    QVector<ProfileEvent> events;
+    qint64 dropped_events;
+    qint64 stage_calls[ProfileStage::StagesCount];
+    qint64 stage_time[ProfileStage::StagesCount];
+    qint64 counters[ProfileCounter::CountersCount];
+};
+
+
+class Profiler
+{
+public:
+    static Profiler *instance();
+    static bool isEnabled();
+
+    static QString stageName(ProfileStage::ProfileStage stage);
+    static QString counterName(ProfileCounter::ProfileCounter counter);
+
+    void beginRun();
+    void endRun();
+
+    qint64 now() const;
+    ThreadProfile *threadProfile();
+
+    bool hasRun() const;
+    qint64 runTime() const;
+    qint64 stageCalls(ProfileStage::ProfileStage stage) const;
+    qint64 stageTime(ProfileStage::ProfileStage stage) const;
+    qint64 counter(ProfileCounter::ProfileCounter counter) const;
+
+    int threadsCount() const;
+    QString threadName(int thread) const;
+    qint64 threadBusyTime(int thread) const;
+    qint64 droppedEvents() const;
+
+    QByteArray chromeTrace() const;
+
+private:
+    Profiler();
+    ~Profiler();
+
+    void clear();
+
+    QElapsedTimer m_timer;
+    qint64 m_run_time;
+    int m_run_id;
+
+    QMutex m_mutex;
+    QList<ThreadProfile*> m_threads;
+};
+
+
+// Measures the time spent in a scope (from its creation to its destruction)
+class ProfileScope
+{
+public:
+    ProfileScope(ProfileStage::ProfileStage stage);
+    ~ProfileScope();
+
+private:
+    ProfileStage::ProfileStage m_stage;
+    qint64 m_start;
+};
+
+
+#ifdef PROFILING
+#define PROFILE_CONCAT_(a, b)       a##b
+#define PROFILE_CONCAT(a, b)        PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(stage)        ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(stage)
+#define PROFILE_COUNT(counter, n)   (Profiler::instance()->threadProfile()->counters[counter] += (n))
+#define PROFILE_BEGIN_RUN()         Profiler::instance()->beginRun()
+#define PROFILE_END_RUN()           Profiler::instance()->endRun()
+#else
+#define PROFILE_SCOPE(stage)
+#define PROFILE_COUNT(counter, n)
+#define PROFILE_BEGIN_RUN()
+#define PROFILE_END_RUN()
+#endif
+
+#endif // PROFILER_H
@@ -0,0 +1,140 @@
+#include "profilerdialog.h"
+#include "ui_profilerdialog.h"
+
+#include "profiler.h"
+#include "mainwindow.h"
+
+#include <QFileDialog>
+#include <QMessageBox>
+
+
+ProfilerDialog::ProfilerDialog(QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::ProfilerDialog)
+{
+    ui->setupUi(this);
+
+    // Remove the help button
+    setWindowFlag(Qt::WindowContextHelpButtonHint, false);
+
+    connect(ui->button_export, SIGNAL(clicked()), this, SLOT(exportTrace()));
+    connect(ui->button_close,  SIGNAL(clicked()), this, SLOT(close()));
+
+    fillTables();
+}
+
+ProfilerDialog::~ProfilerDialog()
+{
+    delete ui;
+}
+
+/**
+ * @brief ProfilerDialog::fillTables
+ *
+ * This function shows the data of the last profiled simulation run
+ */
+void ProfilerDialog::fillTables() {
+    Profiler *profiler = Profiler::instance();
+
+    if (!Profiler::isEnabled()) {
+        ui->label_run->setText("The profiling is not compiled (build with CONFIG += profiling)");
+        ui->button_export->setEnabled(false);
+        return;
+    }
+
+    if (!profiler->hasRun()) {
+        ui->button_export->setEnabled(false);
+        return;
+    }
+
+    const double run_time = profiler->runTime() / 1e6;
+
+    ui->label_run->setText(QString("<b>Run time:</b> %1&nbsp;ms<br/>"
+                                   "<b>Wall intersection tests:</b> %2<br/>"
+                                   "<b>Events missing in the trace:</b> %3")
+                           .arg(run_time, 0, 'f', 2)
+                           .arg(profiler->counter(ProfileCounter::WallTests))
+                           .arg(profiler->droppedEvents()));
+
+    // Calls and times of the stages
+    ui->table_stages->setRowCount(ProfileStage::StagesCount);
+
+    for (int i = 0 ; i < ProfileStage::StagesCount ; i++) {
+        ProfileStage::ProfileStage stage = (ProfileStage::ProfileStage) i;
+
+        const qint64 calls = profiler->stageCalls(stage);
+        const double time = profiler->stageTime(stage);
+        const double mean = (calls > 0 ? time / calls : 0);
+
+        ui->table_stages->setItem(i, 0, new QTableWidgetItem(Profiler::stageName(stage)));
+        ui->table_stages->setItem(i, 1, new QTableWidgetItem(QString::number(calls)));
+        ui->table_stages->setItem(i, 2, new QTableWidgetItem(QString::number(time / 1e6, 'f', 2)));
+        ui->table_stages->setItem(i, 3, new QTableWidgetItem(QString::number(mean / 1e3, 'f', 3)));
+    }
+
+    // Accepted and rejected ray paths of each stage
+    struct PathStage {
+        QString name;
+        ProfileCounter::ProfileCounter tested;
+        ProfileCounter::ProfileCounter accepted;
+    };
+
+    const QList<PathStage> path_stages = {
+        {"Direct",      ProfileCounter::DirectTested,       ProfileCounter::DirectAccepted},
+        {"Reflection",  ProfileCounter::ReflectionTested,   ProfileCounter::ReflectionAccepted},
+        {"Diffraction", ProfileCounter::DiffractionTested,  ProfileCounter::DiffractionAccepted},
+        {"Ground",      ProfileCounter::GroundTested,       ProfileCounter::GroundAccepted}
+    };
+
+    ui->table_paths->setRowCount(path_stages.size());
+
+    for (int i = 0 ; i < path_stages.size() ; i++) {
+        const qint64 tested = profiler->counter(path_stages[i].tested);
+        const qint64 accepted = profiler->counter(path_stages[i].accepted);
+
+        ui->table_paths->setItem(i, 0, new QTableWidgetItem(path_stages[i].name));
+        ui->table_paths->setItem(i, 1, new QTableWidgetItem(QString::number(tested)));
+        ui->table_paths->setItem(i, 2, new QTableWidgetItem(QString::number(accepted)));
+        ui->table_paths->setItem(i, 3, new QTableWidgetItem(QString::number(tested - accepted)));
+    }
+
+    // Busy time of the threads
+    ui->table_threads->setRowCount(profiler->threadsCount());
+
+    for (int i = 0 ; i < profiler->threadsCount() ; i++) {
+        const double busy_time = profiler->threadBusyTime(i) / 1e6;
+
+        ui->table_threads->setItem(i, 0, new QTableWidgetItem(profiler->threadName(i)));
+        ui->table_threads->setItem(i, 1, new QTableWidgetItem(QString::number(busy_time, 'f', 2)));
+        ui->table_threads->setItem(i, 2, new QTableWidgetItem(QString("%1 %").arg(100.0 * busy_time / run_time, 0, 'f', 1)));
+    }
+
+    ui->table_stages->resizeColumnsToContents();
+    ui->table_paths->resizeColumnsToContents();
+    ui->table_threads->resizeColumnsToContents();
+}
+
+void ProfilerDialog::exportTrace() {
+    // Open file selection dialog
+    QString file_path = QFileDialog::getSaveFileName(
+                this,
+                "Export the profiling trace",
+                MainWindow::lastUsedDirectory().path(),
+                "Chrome trace (*.json)");
+
+    // If the user cancelled the dialog
+    if (file_path.isEmpty()) {
+        return;
+    }
+
+    // Set the last used directory
+    MainWindow::setLastUsedDirectory(QFileInfo(file_path).dir());
+
+    QFile trace_file(file_path);
+    const QByteArray json = Profiler::instance()->chromeTrace();
+
+    if (!trace_file.open(QIODevice::WriteOnly) || trace_file.write(json) != json.size()) {
+        QMessageBox::critical(this, "Error", "Unable to write into the selected file");
+        return;
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef PROFILERDIALOG_H
+#define PROFILERDIALOG_H
+
+#include <QDialog>
+
+namespace Ui {
+class ProfilerDialog;
+}
+
+class ProfilerDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit ProfilerDialog(QWidget *parent = nullptr);
+    ~ProfilerDialog();
+
+private slots:
+    void exportTrace();
+
+private:
+    void fillTables();
+
+    Ui::ProfilerDialog *ui;
+};
+
+#endif // PROFILERDIALOG_H
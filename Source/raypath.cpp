@@ -10,23 +10,17 @@ RayPath::RayPath(
         Emitter *em,
         Receiver *rv,
         QList<QLineF> rays,
-        vector<complex> En,
-        double dn,
-        double theta,
+        double power,
         bool is_gnd)
     : SimulationItem()
 {
     m_emitter = em;
     m_receiver = rv;
     m_rays = rays;
-    m_electric_field = En;
-    m_theta = theta;
-    m_totat_length = dn;
+    m_ray_power = power;
 
     m_is_ground = is_gnd;
 
-    m_ray_power = NAN;
-
     // Under the buildings
     setZValue(500);
 }
@@ -43,63 +37,20 @@ QList<QLineF> RayPath::getRays() const {
     return m_rays;
 }
 
-vector<complex> RayPath::getElectricField() const {
-    return m_electric_field;
-}
-
-double RayPath::getVerticalAngle() const {
-    return m_theta;
-}
-
-double RayPath::getTotalLength() const {
-    return m_totat_length;
-}
-
-double RayPath::getDelay() const {
-    return m_totat_length / LIGHT_SPEED;
-}
-
-double RayPath::getAmplitude() {
-    return sqrt(computePower() / m_emitter->getPower());
-}
-
-bool RayPath::isGround() const {
-    return m_is_ground;
-}
-
-bool RayPath::isLOS() const {
-    return m_rays.size() == 1 && !m_is_ground;
-}
-
 /**
- * @brief RayPath::computePower
+ * @brief RayPath::getPower
  * @return
  *
- * This function computes the power of this ray path
- * (equation 3.51, applyed to one ray)
- *
+ * This function returns the power of this ray path at the receiver
  */
-double RayPath::computePower() {
-    // Don't recompute if it was previously computed
-    if (!isnan(m_ray_power))
-        return m_ray_power;
-
-    // Incidence angle of the ray to the receiver (first ray in the list)
-    double phi = m_receiver->getIncidentRayAngle(m_rays.first());
-
-    // Get the frequency from the emitter
-    double frequency = m_emitter->getFrequency();
-
-    // Get the antenna's resistance and effective height
-    double Ra = m_receiver->getResistance();
-    vector<complex> he = m_receiver->getEffectiveHeight(m_theta, phi, frequency);
-
-    // norm() = square of modulus
-    m_ray_power = norm(dotProduct(he, m_electric_field)) / (8.0 * Ra);
-
+double RayPath::getPower() const {
     return m_ray_power;
 }
 
+bool RayPath::isGround() const {
+    return m_is_ground;
+}
+
 
 QLineF RayPath::getScaledLine(QLineF r) const {
     const qreal sim_scale = simulationScene()->simulationScale();
@@ -132,7 +83,7 @@ QPainterPath RayPath::shape() const {
 
 void RayPath::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *) {
     // Get the pen color (function of the power)
-    const double dbm_power = SimulationData::convertPowerTodBm(computePower());
+    const double dbm_power = SimulationData::convertPowerTodBm(getPower());
     //TODO: clean this colour computation...
     const QColor pen_color(SimulationData::ratioToColor(1.0 - (dbm_power+60)/-100.0));
 
@@ -7,30 +7,24 @@
 class Emitter;
 class Receiver;
 
+// Graphics item of a ray path.
+// These items are only created for the receivers shown in point mode,
+// the simulation engine stores the ray paths as RayRecord.
 class RayPath : public SimulationItem
 {
 public:
     RayPath(Emitter *em,
             Receiver *rv,
             QList<QLineF> rays,
-            vector<complex> En,
-            double dn,
-            double theta = M_PI_2,
+            double power,
             bool is_gnd = false);
 
     Emitter *getEmitter() const;
     Receiver *getReceiver() const;
     QList<QLineF> getRays() const;
-    vector<complex> getElectricField() const;
-    double getVerticalAngle() const;
-    double getTotalLength() const;
-    double getDelay() const;
-    double getAmplitude();
-
-    double computePower();
+    double getPower() const;
 
     bool isGround() const;
-    bool isLOS() const;
 
     QRectF boundingRect() const override;
     QPainterPath shape() const override;
@@ -42,9 +36,6 @@ private:
     Emitter *m_emitter;
     Receiver *m_receiver;
     QList<QLineF> m_rays;
-    vector<complex> m_electric_field;
-    double m_theta;
-    double m_totat_length;
 
     double m_ray_power;
 
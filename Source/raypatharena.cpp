@@ -0,0 +1,141 @@
+#include "raypatharena.h"
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// The arena never calls the destructors of the stored objects
+static_assert(std::is_trivially_destructible<RayRecord>::value, "RayRecord must be trivially destructible");
+static_assert(std::is_trivially_destructible<QPointF>::value, "QPointF must be trivially destructible");
+
+
+RayPathArena::RayPathArena()
+{
+    m_current = nullptr;
+    m_available = 0;
+    m_allocated = 0;
+}
+
+RayPathArena::~RayPathArena()
+{
+    clear();
+}
+
+/**
+ * @brief RayPathArena::allocate
+ * @param size
+ * @param align
+ * @return
+ *
+ * This function returns size bytes aligned on align, taken from the last chunk.
+ * A new chunk is created when the last one is full. The allocations larger than
+ * a chunk get their own chunk (and the last chunk is kept for the next allocations).
+ */
+void *RayPathArena::allocate(size_t size, size_t align) {
+    // Allocation larger than a chunk
+    if (size + align > RAY_ARENA_CHUNK_SIZE) {
+        char *chunk = new char[size + align];
+        m_chunks.prepend(chunk);
+        m_allocated += size + align;
+
+        void *ptr = chunk;
+        size_t space = size + align;
+        return std::align(align, size, ptr, space);
+    }
+
+    void *ptr = m_current;
+    size_t space = m_available;
+
+    // Start a new chunk if the last one is full
+    if (m_current == nullptr || std::align(align, size, ptr, space) == nullptr) {
+        m_current = new char[RAY_ARENA_CHUNK_SIZE];
+        m_available = RAY_ARENA_CHUNK_SIZE;
+        m_chunks.append(m_current);
+        m_allocated += RAY_ARENA_CHUNK_SIZE;
+
+        ptr = m_current;
+        space = m_available;
+        std::align(align, size, ptr, space);
+    }
+
+    // Bump the pointer after the allocated bytes
+    m_current = static_cast<char*>(ptr) + size;
+    m_available = space - size;
+
+    return ptr;
+}
+
+/**
+ * @brief RayPathArena::storeBlock
+ * @param records
+ * @param records_count
+ * @param vertices
+ * @param vertices_count
+ * @return
+ *
+ * This function copies the ray paths (and their vertices) into the arena,
+ * and returns the new block. The block is valid until the arena is cleared.
+ */
+RayPathBlock *RayPathArena::storeBlock(
+        const RayRecord *records,
+        int records_count,
+        const QPointF *vertices,
+        int vertices_count)
+{
+    RayRecord *block_records = static_cast<RayRecord*>(
+                allocate(sizeof(RayRecord) * records_count, alignof(RayRecord)));
+    QPointF *block_vertices = static_cast<QPointF*>(
+                allocate(sizeof(QPointF) * vertices_count, alignof(QPointF)));
+
+    std::uninitialized_copy(records, records + records_count, block_records);
+    std::uninitialized_copy(vertices, vertices + vertices_count, block_vertices);
+
+    RayPathBlock *block = static_cast<RayPathBlock*>(allocate(sizeof(RayPathBlock), alignof(RayPathBlock)));
+    block->records = block_records;
+    block->vertices = block_vertices;
+    block->records_count = records_count;
+    block->vertices_count = vertices_count;
+    block->next = nullptr;
+
+    return block;
+}
+
+/**
+ * @brief RayPathArena::clear
+ *
+ * This function frees all the blocks of the arena at once
+ * (the receivers must not use them anymore)
+ */
+void RayPathArena::clear() {
+    foreach (char *chunk, m_chunks) {
+        delete[] chunk;
+    }
+
+    m_chunks.clear();
+    m_current = nullptr;
+    m_available = 0;
+    m_allocated = 0;
+}
+
+/**
+ * @brief RayPathArena::swap
+ * @param other
+ *
+ * This function exchanges the blocks of the two arenas
+ */
+void RayPathArena::swap(RayPathArena &other) {
+    m_chunks.swap(other.m_chunks);
+    std::swap(m_current, other.m_current);
+    std::swap(m_available, other.m_available);
+    std::swap(m_allocated, other.m_allocated);
+}
+
+/**
+ * @brief RayPathArena::allocatedBytes
+ * @return
+ *
+ * Returns the memory allocated by the arena (in bytes)
+ */
+qint64 RayPathArena::allocatedBytes() const {
+    return m_allocated;
+}
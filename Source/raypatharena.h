@@ -0,0 +1,52 @@
+#ifndef RAYPATHARENA_H
+#define RAYPATHARENA_H
+
+#include <QPointF>
+#include <QVector>
+
+#include "rayrecord.h"
+
+// Size of the memory chunks of the arenas (in bytes)
+#define RAY_ARENA_CHUNK_SIZE    (1 << 20)
+
+// Ray paths added at once to a receiver (stored in a RayPathArena).
+// The vertex_index of the records is relative to the vertices of the block.
+// The receiver owns its blocks, and can remove ray paths in place.
+struct RayPathBlock {
+    RayRecord *records;
+    QPointF *vertices;
+    int records_count;
+    int vertices_count;
+    RayPathBlock *next;         // Next block of the same receiver
+};
+
+// Storage of the ray paths of a simulation.
+// The blocks are allocated by a pointer bump in large chunks, and they are all
+// freed at once by clear() (they are never freed one by one).
+// An arena is only used by one thread at a time (one arena per computation unit).
+class RayPathArena
+{
+public:
+    RayPathArena();
+    ~RayPathArena();
+
+    RayPathBlock *storeBlock(
+            const RayRecord *records,
+            int records_count,
+            const QPointF *vertices,
+            int vertices_count);
+
+    void clear();
+    void swap(RayPathArena &other);
+    qint64 allocatedBytes() const;
+
+private:
+    void *allocate(size_t size, size_t align);
+
+    QVector<char*> m_chunks;
+    char *m_current;        // Next free byte of the last chunk
+    size_t m_available;     // Free bytes in the last chunk
+    qint64 m_allocated;
+};
+
+#endif // RAYPATHARENA_H
@@ -0,0 +1,93 @@
+#ifndef RAYRECORD_H
+#define RAYRECORD_H
+
+#include <QPointF>
+#include <QVector>
+#include <QtGlobal>
+
+#include "constants.h"
+
+class Emitter;
+
+namespace RayType {
+enum RayType : quint8 {
+    LOS,
+    Reflection,
+    Diffraction,
+    Ground,
+    RayTypesCount
+};
+}
+
+// Compact result of a ray path computed by the simulation engine.
+// The points of the ray path are stored in the vertex pool of the receiver,
+// from the receiver to the emitter.
+struct RayRecord {
+    Emitter *emitter;           // Emitter of the ray path
+    Vec3c field;                // Electric field at the receiver
+    double length;              // Total length of the ray path (in meters)
+    double excess_length;       // Length of a diffracted path minus the LOS length (0 for the other paths)
+    double theta;               // Vertical angle at the receiver side (in radians)
+    double arrival_angle;       // Angle of the ray line at the receiver side (in radians)
+    double departure_angle;     // Angle of the ray line at the emitter side (in radians)
+    int vertex_index;           // Index of the first point in the vertex pool
+    quint8 vertex_count;        // Number of points of the ray path
+    RayType::RayType type;      // Kind of ray path
+
+    double getDelay() const {
+        return length / LIGHT_SPEED;
+    }
+
+    Vec3c getElectricField() const {
+        return field;
+    }
+
+    bool isLOS() const {
+        return type == RayType::LOS;
+    }
+
+    bool isGround() const {
+        return type == RayType::Ground;
+    }
+};
+
+// Ray paths computed for one receiver, before they are added to it at once.
+// Each computation unit owns its buffer (reused for all its receivers), so
+// the buffer is filled without any lock.
+struct RayPathBuffer {
+    QVector<RayRecord> records;
+    QVector<QPointF> vertices;  // Vertex pool of the records
+    Emitter *oom_emitter;       // Emitter that makes the receiver out of model (if one)
+
+    RayPathBuffer() {
+        oom_emitter = nullptr;
+    }
+
+    void clear() {
+        records.clear();
+        vertices.clear();
+        oom_emitter = nullptr;
+    }
+
+    // The points of a ray path are added from the receiver to the emitter, between
+    // a call to beginPath() and a call to endPath() (or cancelPath() if invalid)
+    int beginPath() const {
+        return vertices.size();
+    }
+
+    void addVertex(const QPointF &p) {
+        vertices.append(p);
+    }
+
+    void cancelPath(int first_vertex) {
+        vertices.resize(first_vertex);
+    }
+
+    void endPath(RayRecord rec, int first_vertex) {
+        rec.vertex_index = first_vertex;
+        rec.vertex_count = vertices.size() - first_vertex;
+        records.append(rec);
+    }
+};
+
+#endif // RAYRECORD_H
@@ -3,6 +3,7 @@
 #include "simulationscene.h"
 #include "simulationdata.h"
 #include "simulationhandler.h"
+#include "profiler.h"
 
 #include <QPainter>
 
@@ -10,6 +11,8 @@
 #define RECEIVER_CROSS_SIZE     (4.0 * simulationScene()->simulationScale())
 #define RECEIVER_CIRCLE_SIZE    6 // Size of the circle at the center (in pixels)
 
+int Receiver::m_results_sweep_index = -1;
+
 Receiver::Receiver(Antenna *antenna) : SimulationItem()
 {
     // The default angle for the emitter is PI/2 (incidence to top)
@@ -34,10 +37,13 @@ Receiver::Receiver(Antenna *antenna) : SimulationItem()
     m_res_max = 0;
 
     // Initialize the computation values
-    m_received_power = NAN;
-    m_user_end_SNR   = NAN;
-    m_delay_spread   = NAN;
-    m_rice_factor    = NAN;
+    m_metrics.clear();
+    m_finalized = 0;
+
+    // No ray paths yet
+    m_ray_blocks = nullptr;
+    m_last_ray_block = nullptr;
+    m_ray_paths_count = 0;
 
     // Over buildings
     setZValue(2000);
@@ -116,8 +122,19 @@ double Receiver::getRotation() const {
  * This function assumes the ray comes into the emitter.
  */
 double Receiver::getIncidentRayAngle(QLineF ray) const {
-    double ray_angle = ray.angle() / 180.0 * M_PI - M_PI;
-    return ray_angle - getRotation();
+    return getIncidentRayAngle(ray.angle() / 180.0 * M_PI);
+}
+
+/**
+ * @brief Receiver::getIncidentRayAngle
+ * @param ray_angle
+ * @return
+ *
+ * Returns the incidence angle of a ray to the emitter (in radians),
+ * from the angle of the ray line (in radians).
+ */
+double Receiver::getIncidentRayAngle(double ray_angle) const {
+    return ray_angle - M_PI - getRotation();
 }
 
 double Receiver::getEfficiency() const {
@@ -128,11 +145,11 @@ double Receiver::getResistance() const {
     return m_antenna->getResistance();
 }
 
-vector<complex> Receiver::getEffectiveHeight(double phi, double frequency) const {
+Vec3c Receiver::getEffectiveHeight(double phi, double frequency) const {
     return m_antenna->getEffectiveHeight(M_PI_2, phi, frequency);
 }
 
-vector<complex> Receiver::getEffectiveHeight(double theta, double phi, double frequency) const {
+Vec3c Receiver::getEffectiveHeight(double theta, double phi, double frequency) const {
     return m_antenna->getEffectiveHeight(theta, phi, frequency);
 }
 
@@ -147,22 +164,23 @@ double Receiver::getGain(double phi) const {
 
 void Receiver::reset() {
     // Delete all RayPaths from this receiver
-    foreach (RayPath *rp, m_received_rays) {
-        delete rp;
-    }
-    m_received_rays.clear();
+    deleteRayPathItems();
+
+    // The blocks of ray paths are freed with the arenas of the simulation
+    m_ray_blocks = nullptr;
+    m_last_ray_block = nullptr;
+    m_ray_paths_count = 0;
     m_attached_emitters.clear();
 
-    m_received_power = NAN;
-    m_user_end_SNR   = NAN;
-    m_delay_spread   = NAN;
-    m_rice_factor    = NAN;
+    // The results are computed again when the receiver is finalized
+    invalidateResults();
 
     // Hide the results
     m_show_result = false;
 
     // Reset the Out of Model flag
     m_out_of_model = false;
+    m_oom_emitter = nullptr;
 
     // Generate the idle tooltip
     generateIdleTooltip();
@@ -172,55 +190,232 @@ void Receiver::reset() {
     update();
 }
 
-void Receiver::addRayPath(RayPath *rp) {
-    // Don't add an invalid RayPath
-    if (rp == nullptr)
-        return;
+/**
+ * @brief Receiver::addRayPaths
+ * @param buffer
+ * @param arena
+ *
+ * This function adds the ray paths computed for this receiver (by one computation unit),
+ * and finalizes the receiver. The ray paths are copied into a block of the arena.
+ * A receiver is only computed by one thread at a time, and its results are not read
+ * until it is finalized, so no lock is needed.
+ */
+void Receiver::addRayPaths(const RayPathBuffer &buffer, RayPathArena *arena) {
+    PROFILE_SCOPE(ProfileStage::AddRayPath);
+
+    if (!buffer.records.isEmpty()) {
+        appendRayBlock(arena->storeBlock(
+                           buffer.records.constData(),
+                           buffer.records.size(),
+                           buffer.vertices.constData(),
+                           buffer.vertices.size()));
+
+        // Insert the source emitters (if not present yet)
+        foreach (const RayRecord &rec, buffer.records) {
+            m_attached_emitters.insert(rec.emitter);
+        }
+    }
 
-    // Lock the mutex to ensure that only one thread write in the list at a time
-    m_mutex.lock();
+    // Set this receiver as out of model (too close to an emitter)
+    if (buffer.oom_emitter != nullptr) {
+        m_out_of_model = true;
+        m_oom_emitter = buffer.oom_emitter;
+        m_attached_emitters.insert(buffer.oom_emitter);
+    }
 
-    // Append the new ray path to the list
-    m_received_rays.append(rp);
+    finalize();
+}
 
-    // Invalidate the previously computed power
-    m_received_power = NAN;
-    m_user_end_SNR   = NAN;
-    m_delay_spread   = NAN;
-    m_rice_factor    = NAN;
+/**
+ * @brief Receiver::invalidateResults
+ *
+ * This function marks the results of the receiver as not computed.
+ * It must be called from the main thread before the receiver is computed again.
+ */
+void Receiver::invalidateResults() {
+    m_finalized.storeRelease(0);
+    m_metrics.clear();
+    m_sweep_power.clear();
+}
 
-    // Insert the source emitter (if not present yet)
-    m_attached_emitters.insert(rp->getEmitter());
+/**
+ * @brief Receiver::finalize
+ *
+ * This function computes the results of the receiver once all its ray paths are added.
+ * The ray paths and the results don't change anymore until the receiver is
+ * computed again, so they can be read without lock by the other threads.
+ */
+void Receiver::finalize() {
+    computeMetrics();
 
-    // Unlock the mutex to allow others threads to write
-    m_mutex.unlock();
+    // Publish the results (written before the flag)
+    m_finalized.storeRelease(1);
 }
 
-QList<RayPath*> Receiver::getRayPaths() {
-    return m_received_rays;
+bool Receiver::isFinalized() const {
+    return m_finalized.loadAcquire() != 0;
 }
 
-void Receiver::discardEmitter(Emitter *e) {
-    // Lock the mutex to ensure that only one thread can access the list at a time
-    m_mutex.lock();
+/**
+ * @brief Receiver::appendRayBlock
+ * @param block
+ *
+ * This function adds a block of ray paths after the previous ones
+ */
+void Receiver::appendRayBlock(RayPathBlock *block) {
+    if (m_last_ray_block == nullptr) {
+        m_ray_blocks = block;
+    }
+    else {
+        m_last_ray_block->next = block;
+    }
 
-    // Ignore if no rays come from this emitter
-    if (!m_attached_emitters.contains(e)) {
-        // Unlock the mutex to allow others threads to access
-        m_mutex.unlock();
+    m_last_ray_block = block;
+    m_ray_paths_count += block->records_count;
+}
 
-        return;
+/**
+ * @brief Receiver::getRayRecords
+ * @return
+ *
+ * This function returns a copy of the received ray paths (without their points)
+ */
+QVector<RayRecord> Receiver::getRayRecords() const {
+    QVector<RayRecord> records;
+    records.reserve(m_ray_paths_count);
+
+    for (const RayPathBlock *b = m_ray_blocks ; b != nullptr ; b = b->next) {
+        for (int i = 0 ; i < b->records_count ; i++) {
+            records.append(b->records[i]);
+        }
     }
 
-    // For every raypath
-    foreach(RayPath *rp, m_received_rays) {
-        // Remove this raypath if it is coming from the given emitter
-        if (rp->getEmitter() == e) {
-            m_received_rays.removeAll(rp);
-            delete rp;
+    return records;
+}
+
+int Receiver::getRayPathsCount() const {
+    return m_ray_paths_count;
+}
+
+/**
+ * @brief Receiver::getRayLines
+ * @param block
+ * @param rec
+ * @return
+ *
+ * This function returns the lines forming a ray path of the block (in meters),
+ * from the receiver to the emitter
+ */
+QList<QLineF> Receiver::getRayLines(const RayPathBlock *block, const RayRecord &rec) const {
+    QList<QLineF> rays;
+    const QPointF *vertices = block->vertices + rec.vertex_index;
+
+    for (int i = 0 ; i < rec.vertex_count - 1 ; i++) {
+        rays.append(QLineF(vertices[i+1], vertices[i]));
+    }
+
+    return rays;
+}
+
+/**
+ * @brief Receiver::getRayPower
+ * @param rec
+ * @return
+ *
+ * This function computes the power of a ray path at this receiver
+ * (equation 3.51, applyed to one ray)
+ */
+double Receiver::getRayPower(const RayRecord &rec) const {
+    // Incidence angle of the ray to the receiver
+    const double phi = getIncidentRayAngle(rec.arrival_angle);
+
+    // Get the frequency from the emitter
+    const double frequency = rec.emitter->getFrequency();
+
+    // Get the antenna's resistance and effective height
+    const double Ra = getResistance();
+    const Vec3c he = getEffectiveHeight(rec.theta, phi, frequency);
+
+    // norm() = square of modulus
+    return norm(dotProduct(he, rec.getElectricField())) / (8.0 * Ra);
+}
+
+double Receiver::getRayAmplitude(const RayRecord &rec) const {
+    return sqrt(getRayPower(rec) / rec.emitter->getPower());
+}
+
+/**
+ * @brief Receiver::discardEmitter
+ * @param e
+ *
+ * This function removes the ray paths of the emitter e (from the main thread,
+ * when the receiver is not computed) and computes the results again.
+ * The kept ray paths are moved to the front of their block (in place, nothing is
+ * allocated), and the emptied blocks are unlinked. The bytes left unused in the
+ * arenas are counted by the simulation handler (see rayPathsBytes).
+ */
+void Receiver::discardEmitter(Emitter *e) {
+    // Ignore if no rays come from this emitter
+    if (!m_attached_emitters.contains(e))
+        return;
+
+    // The graphics items will be re-created on demand
+    deleteRayPathItems();
+
+    RayPathBlock *prev_block = nullptr;
+    RayPathBlock *b = m_ray_blocks;
+
+    m_ray_blocks = nullptr;
+    m_last_ray_block = nullptr;
+    m_ray_paths_count = 0;
+
+    while (b != nullptr) {
+        RayPathBlock *next_block = b->next;
+
+        // Keep the ray paths (and their points) that don't come from the given emitter.
+        // They are only moved backward, so they are never overwritten before being read.
+        int records_count = 0;
+        int vertices_count = 0;
+
+        for (int i = 0 ; i < b->records_count ; i++) {
+            RayRecord rec = b->records[i];
+
+            if (rec.emitter == e)
+                continue;
+
+            for (int k = 0 ; k < rec.vertex_count ; k++) {
+                b->vertices[vertices_count + k] = b->vertices[rec.vertex_index + k];
+            }
+
+            rec.vertex_index = vertices_count;
+            vertices_count += rec.vertex_count;
+
+            b->records[records_count++] = rec;
         }
+
+        b->records_count = records_count;
+        b->vertices_count = vertices_count;
+        b->next = nullptr;
+
+        // Unlink the emptied blocks
+        if (records_count > 0) {
+            if (prev_block == nullptr) {
+                m_ray_blocks = b;
+            }
+            else {
+                prev_block->next = b;
+            }
+
+            prev_block = b;
+            m_last_ray_block = b;
+            m_ray_paths_count += records_count;
+        }
+
+        b = next_block;
     }
 
+    m_attached_emitters.remove(e);
+
     // If this receiver was out of model due to this emitter
     if (m_oom_emitter == e) {
         // Reset the out of model flags
@@ -228,28 +423,95 @@ void Receiver::discardEmitter(Emitter *e) {
         m_oom_emitter = nullptr;
     }
 
-    // Invalidate the previously computed data
-    m_received_power = NAN;
-    m_user_end_SNR   = NAN;
-    m_delay_spread   = NAN;
-    m_rice_factor    = NAN;
+    // Compute the results without the discarded ray paths
+    finalize();
+}
+
+/**
+ * @brief Receiver::relocateRayPaths
+ * @param arena
+ * @param buffer
+ *
+ * This function copies the ray paths of the receiver into a single block of the
+ * given arena (the previous blocks are not used anymore). The results don't change.
+ * The buffer is only used to gather the ray paths (it is cleared first).
+ */
+void Receiver::relocateRayPaths(RayPathArena *arena, RayPathBuffer *buffer) {
+    buffer->clear();
+
+    for (const RayPathBlock *b = m_ray_blocks ; b != nullptr ; b = b->next) {
+        for (int i = 0 ; i < b->records_count ; i++) {
+            const int first_vertex = buffer->beginPath();
+
+            for (int k = 0 ; k < b->records[i].vertex_count ; k++) {
+                buffer->addVertex(b->vertices[b->records[i].vertex_index + k]);
+            }
+
+            buffer->endPath(b->records[i], first_vertex);
+        }
+    }
+
+    m_ray_blocks = nullptr;
+    m_last_ray_block = nullptr;
+    m_ray_paths_count = 0;
 
-    // Unlock the mutex to allow others threads to access
-    m_mutex.unlock();
+    if (!buffer->records.isEmpty()) {
+        appendRayBlock(arena->storeBlock(
+                           buffer->records.constData(),
+                           buffer->records.size(),
+                           buffer->vertices.constData(),
+                           buffer->vertices.size()));
+    }
 }
 
-void Receiver::setOutOfModel(bool out, Emitter *e) {
-    m_out_of_model = out;
-    m_oom_emitter = e;
+/**
+ * @brief Receiver::rayPathsBytes
+ * @return
+ *
+ * Returns the size of the ray paths stored for this receiver (in bytes)
+ */
+qint64 Receiver::rayPathsBytes() const {
+    qint64 bytes = 0;
 
-    // Lock the mutex to ensure that only one thread can access the list at a time
-    m_mutex.lock();
+    for (const RayPathBlock *b = m_ray_blocks ; b != nullptr ; b = b->next) {
+        bytes += b->records_count * sizeof(RayRecord) + b->vertices_count * sizeof(QPointF);
+    }
 
-    // Insert the source emitter (if not present yet)
-    m_attached_emitters.insert(e);
+    return bytes;
+}
 
-    // Unlock the mutex to allow others threads to access
-    m_mutex.unlock();
+/**
+ * @brief Receiver::createRayPathItems
+ * @return
+ *
+ * This function creates the graphics items of the received ray paths (if not created yet).
+ * These items are only needed to show the ray paths on the scene.
+ */
+QList<RayPath*> Receiver::createRayPathItems() {
+    if (m_ray_path_items.isEmpty()) {
+        for (const RayPathBlock *b = m_ray_blocks ; b != nullptr ; b = b->next) {
+            for (int i = 0 ; i < b->records_count ; i++) {
+                const RayRecord &rec = b->records[i];
+
+                RayPath *rp = new RayPath(rec.emitter, this, getRayLines(b, rec), getRayPower(rec), rec.isGround());
+                m_ray_path_items.append(rp);
+            }
+        }
+    }
+
+    return m_ray_path_items;
+}
+
+QList<RayPath*> Receiver::getRayPathItems() {
+    return m_ray_path_items;
+}
+
+void Receiver::deleteRayPathItems() {
+    foreach (RayPath *rp, m_ray_path_items) {
+        delete rp;
+    }
+
+    m_ray_path_items.clear();
 }
 
 bool Receiver::outOfModel() {
@@ -257,174 +519,303 @@ bool Receiver::outOfModel() {
 }
 
 /**
- * @brief Receiver::receivedPower
+ * @brief Receiver::outOfModelEmitter
  * @return
  *
- * This function computes the received power using the equation (3.51)
+ * Returns the emitter that made this receiver out of model (if one)
  */
-double Receiver::receivedPower() {
-    // If the received power was already computed previously
-    if (!isnan(m_received_power))
-        return m_received_power;
-
-    // Lock the mutex to ensure that only one thread can access the list at a time
-    m_mutex.lock();
+Emitter *Receiver::outOfModelEmitter() const {
+    return m_oom_emitter;
+}
 
-    // Implementation of equation 3.51
-    complex sum = 0;
+/**
+ * @brief Receiver::metrics
+ * @return
+ *
+ * Returns the results of the receiver (NAN values while the receiver is not finalized)
+ */
+const ReceiverMetrics &Receiver::metrics() const {
+    return m_metrics;
+}
 
-    // For each received rays
-    foreach (RayPath *rp, m_received_rays) {
-        // Incidence angle of the ray to the receiver (first ray in the list)
-        const double phi = getIncidentRayAngle(rp->getRays().at(0));
+double Receiver::receivedPower() const {
+    return m_metrics.received_power;
+}
 
-        // Get the frequency from the emitter
-        const double frequency = rp->getEmitter()->getFrequency();
+double Receiver::userEndSNR() const {
+    return m_metrics.user_end_SNR;
+}
 
-        // Get the antenna's resistance and effective height
-        const vector<complex> he = getEffectiveHeight(rp->getVerticalAngle(), phi, frequency);
+/**
+ * @brief Receiver::userEndSNR
+ * @param buffer
+ * @return
+ *
+ * This function returns the SNR of the ray paths of the buffer alone, as if they
+ * were the only ray paths of this receiver (the receiver is not modified)
+ */
+double Receiver::userEndSNR(const RayPathBuffer &buffer) const {
+    // Sum inside the square modulus of equation 3.51
+    complex sum = 0;
 
-        // Get the electric field of the incoming ray
-        const vector<complex> En = rp->getElectricField();
+    foreach (const RayRecord &rec, buffer.records) {
+        const double phi = getIncidentRayAngle(rec.arrival_angle);
+        const Vec3c he = getEffectiveHeight(rec.theta, phi, rec.emitter->getFrequency());
 
-        // Sum inside the square modulus
-        sum += dotProduct(he, En);
+        sum += dotProduct(he, rec.getElectricField());
     }
 
-    const double Ra = getResistance();
+    const double received_power = norm(sum) / (8.0 * getResistance());
 
-    // norm() = square of modulus
-    m_received_power =  norm(sum) / (8.0 * Ra);
+    return SimulationData::convertPowerTodBm(received_power) - noiseFloor();
+}
 
-    // Unlock the mutex to allow others threads to access
-    m_mutex.unlock();
+double Receiver::delaySpread() const {
+    return m_metrics.delay_spread;
+}
 
-    return m_received_power;
+double Receiver::meanExcessDelay() const {
+    return m_metrics.mean_excess_delay;
+}
+
+double Receiver::rmsDelaySpread() const {
+    return m_metrics.rms_delay_spread;
+}
+
+double Receiver::riceFactor() const {
+    return m_metrics.rice_factor;
 }
 
 /**
- * @brief Receiver::userEndSNR
+ * @brief Receiver::sweepPower
  * @return
  *
- * This function computes the SNR at user-end (as described in Table 3.3, p.60)
+ * Returns the received power (in Watts) at each frequency of the sweep
+ * (see SimulationData::getSweepFrequencies), empty if there is no sweep
  */
-double Receiver::userEndSNR() {
-    // If the user-end SNR was already computed previously
-    if (!isnan(m_user_end_SNR))
-        return m_user_end_SNR;
+QVector<double> Receiver::sweepPower() const {
+    return m_sweep_power;
+}
 
-    const double temperature = SimulationHandler::simulationData()->getSimulationTemperature();
-    const double bandwidth = SimulationHandler::simulationData()->getSimulationBandwidth();
+/**
+ * @brief Receiver::setResultsSweepIndex
+ * @param index
+ *
+ * Selects the frequency of the sweep at which the power and the SNR are shown
+ * on the heat maps (-1 for the frequencies of the emitters)
+ */
+void Receiver::setResultsSweepIndex(int index) {
+    m_results_sweep_index = index;
+}
 
-    const double therm_noise = 10.0 * log10(K_boltz * temperature * bandwidth / 1e-3);
-    const double noise_fig = SimulationHandler::simulationData()->getSimulationNoiseFigure();
+int Receiver::resultsSweepIndex() {
+    return m_results_sweep_index;
+}
 
-    const double noise_floor = therm_noise + noise_fig;
-    const double rx_power = SimulationData::convertPowerTodBm(receivedPower());
+/**
+ * @brief Receiver::resultsPower
+ * @return
+ *
+ * Returns the received power at the frequency of the shown results (in Watts)
+ */
+double Receiver::resultsPower() const {
+    if (m_results_sweep_index >= 0 && m_results_sweep_index < m_sweep_power.size()) {
+        return m_sweep_power[m_results_sweep_index];
+    }
 
-    // SNR = RX_power [dBm] - Noise_power [dBm]
-    m_user_end_SNR = rx_power - noise_floor;
+    return m_metrics.received_power;
+}
 
-    return m_user_end_SNR;
+double Receiver::resultsSNR() const {
+    if (m_results_sweep_index >= 0 && m_results_sweep_index < m_sweep_power.size()) {
+        return SimulationData::convertPowerTodBm(m_sweep_power[m_results_sweep_index]) - noiseFloor();
+    }
+
+    return m_metrics.user_end_SNR;
 }
 
 /**
- * @brief Receiver::delaySpread
- * @return
+ * @brief Receiver::computeMetrics
  *
- * This function computes the delay spread (Equation (1.24)).
- * The delay spread is defined if there is only one emitter in the simulation.
+ * This function computes all the results of the receiver in a single pass over the ray paths:
+ *  - the received power, using the equation (3.51)
+ *  - the SNR at user-end (as described in Table 3.3, p.60)
+ *  - the delay spread (Equation (1.24)), the largest difference between two delays
+ *  - the mean excess delay and the RMS delay spread (power delay profile of the rays)
+ *  - the rice factor (Equation (4.18)), from the powers of the LOS and other rays
+ *  - the number of ray paths of each type
+ *  - the received power at each frequency of the sweep, from the same ray paths
+ *    (only their phase and diffraction coefficient change), and its range over the sweep
+ * The delay spreads and the rice factor are defined if there is only one emitter
+ * in the simulation (and at least two rays).
  */
-double Receiver::delaySpread() {
-    // Re-use the previously computed value
-    if (!isnan(m_delay_spread)) {
-        return m_delay_spread;
-    }
+void Receiver::computeMetrics() {
+    const double Ra = getResistance();
 
-    // Lock the mutex to ensure that only one thread can access the list at a time
-    m_mutex.lock();
+    m_metrics.clear();
 
-    // No delay spread if more than one emitter or if less than two rays
-    if (m_attached_emitters.size() != 1 ||
-            m_received_rays.size() < 2) {
+    // Sum inside the square modulus of equation 3.51
+    complex sum = 0;
 
-        // Unlock the mutex to allow others threads to access
-        m_mutex.unlock();
+    // Same sum at each frequency of the sweep. The effective height of the antennas
+    // is proportional to the wave length, so the sums are taken with the effective
+    // heights at 1 Hz (he * frequency) and scaled by the wave length at the end.
+    const QVector<double> sweep = SimulationHandler::simulationData()->getSweepFrequencies();
+    QVector<complex> sweep_sum(sweep.size(), 0);
 
-        return NAN;
+    // Propagation constants of the sweep (the sweep frequencies are evenly spaced)
+    QVector<double> sweep_beta(sweep.size());
+
+    for (int k = 0 ; k < sweep.size() ; k++) {
+        sweep_beta[k] = sweep[k]*2*M_PI/LIGHT_SPEED;
     }
 
-    double delay_i, delay_j;
-    double max_delay = 0;
+    const double sweep_beta_step = (sweep.size() > 1 ? sweep_beta[1] - sweep_beta[0] : 0);
+
+    // The delays are taken relative to the first ray (better accuracy of the sums)
+    double ref_delay = NAN;
+    double min_delay = qInf();
+    double max_delay = -qInf();
+
+    // Sums of the powers of the rays, weighted by their delay and squared delay
+    double sum_p = 0;
+    double sum_p_delay = 0;
+    double sum_p_delay_sq = 0;
+
+    // Powers of the LOS ray (if one) and of the other rays
+    double los_power = 0;
+    double nlos_power = 0;
+
+    for (const RayPathBlock *b = m_ray_blocks ; b != nullptr ; b = b->next) {
+        for (int i = 0 ; i < b->records_count ; i++) {
+            const RayRecord &rec = b->records[i];
+
+            // Incidence angle of the ray to the receiver
+            const double phi = getIncidentRayAngle(rec.arrival_angle);
+
+            // Get the frequency from the emitter
+            const double frequency = rec.emitter->getFrequency();
+
+            // Get the antenna's effective height (only once per ray)
+            const Vec3c he = getEffectiveHeight(rec.theta, phi, frequency);
+
+            const complex v = dotProduct(he, rec.getElectricField());
+            sum += v;
+
+            // The ray path is only evaluated again at the other frequencies: the phase
+            // of the field (beta*dn) changes by the same step between two frequencies
+            if (!sweep.isEmpty()) {
+                const double beta_0 = frequency*2*M_PI/LIGHT_SPEED;
+
+                complex v_k = v * frequency * exp(-1i*(sweep_beta[0] - beta_0)*rec.length);
+                const complex phase_step = exp(-1i*sweep_beta_step*rec.length);
+
+                if (rec.type == RayType::Diffraction) {
+                    // The diffraction coefficient also depends on the frequency
+                    const complex F_nu_0 = SimulationHandler::diffractionCoefficient(beta_0, rec.excess_length);
+
+                    for (int k = 0 ; k < sweep.size() ; k++) {
+                        sweep_sum[k] += v_k * SimulationHandler::diffractionCoefficient(sweep_beta[k], rec.excess_length) / F_nu_0;
+                        v_k *= phase_step;
+                    }
+                }
+                else {
+                    for (int k = 0 ; k < sweep.size() ; k++) {
+                        sweep_sum[k] += v_k;
+                        v_k *= phase_step;
+                    }
+                }
+            }
+
+            // Power of this ray alone, and its delay
+            const double ray_power = norm(v) / (8.0 * Ra);
 
-    // Loop over each pair of rays
-    for (int i = 0 ; i < m_received_rays.size() ; i++) {
-        for (int j = i+1 ; j < m_received_rays.size() ; j++) {
-            // Get the transmission delay of the two rays
-            delay_i = m_received_rays.at(i)->getDelay();
-            delay_j = m_received_rays.at(j)->getDelay();
+            if (isnan(ref_delay)) {
+                ref_delay = rec.getDelay();
+            }
 
-            // Keep the maximal delay difference
-            max_delay = max(max_delay, abs(delay_i - delay_j));
+            const double delay = rec.getDelay() - ref_delay;
+
+            min_delay = min(min_delay, delay);
+            max_delay = max(max_delay, delay);
+
+            sum_p += ray_power;
+            sum_p_delay += ray_power * delay;
+            sum_p_delay_sq += ray_power * delay * delay;
+
+            if (rec.isLOS()) {
+                los_power += ray_power;
+            }
+            else {
+                nlos_power += ray_power;
+            }
+
+            m_metrics.paths_count[rec.type]++;
         }
     }
 
-    // Store the computed delay spread for future usage
-    m_delay_spread = max_delay;
+    // norm() = square of modulus
+    m_metrics.received_power = norm(sum) / (8.0 * Ra);
 
-    // Unlock the mutex to allow others threads to access
-    m_mutex.unlock();
+    // SNR = RX_power [dBm] - Noise_power [dBm]
+    m_metrics.user_end_SNR = SimulationData::convertPowerTodBm(m_metrics.received_power) - noiseFloor();
 
-    return m_delay_spread;
-}
+    // Received powers over the sweep, and their range (frequency selective fading)
+    m_sweep_power.resize(sweep.size());
 
-/**
- * @brief Receiver::riceFactor
- * @return
- *
- * This function computes the rice factor (Equation (4.18)).
- * The rice factor is defined if there is only one emitter in the simulation.
- */
-double Receiver::riceFactor() {
-    // Re-use the previously computed value
-    if (!isnan(m_rice_factor)) {
-        return m_rice_factor;
+    for (int k = 0 ; k < sweep.size() ; k++) {
+        m_sweep_power[k] = norm(sweep_sum[k] / sweep[k]) / (8.0 * Ra);
     }
 
-    // Lock the mutex to ensure that only one thread can access the list at a time
-    m_mutex.lock();
+    if (sweep.size() > 1 && m_ray_paths_count > 0) {
+        const double min_power = *std::min_element(m_sweep_power.constBegin(), m_sweep_power.constEnd());
+        const double max_power = *std::max_element(m_sweep_power.constBegin(), m_sweep_power.constEnd());
 
-    // No rice factor if more than one emitter or if less than two rays
-    if (m_attached_emitters.size() != 1 ||
-            m_received_rays.size() < 2) {
+        // Undefined range if the power vanishes at a frequency
+        if (min_power > 0) {
+            m_metrics.frequency_selectivity = 10*log10(max_power / min_power);
+        }
+    }
 
-        // Unlock the mutex to allow others threads to access
-        m_mutex.unlock();
+    if (m_ray_paths_count > 0) {
+        m_metrics.min_delay = ref_delay + min_delay;
+        m_metrics.max_delay = ref_delay + max_delay;
+    }
 
-        return NAN;
+    // No delay spreads nor rice factor if more than one emitter or if less than two rays
+    if (m_attached_emitters.size() != 1 ||
+            m_ray_paths_count < 2) {
+        return;
     }
 
-    // Initialize to 0
-    double los_val_sq = 0;
-    double sum_ampl_sq = 0;
+    m_metrics.delay_spread = max_delay - min_delay;
 
-    foreach(RayPath *rp, m_received_rays) {
-        // One of them may be a LOS
-        if (rp->isLOS()) {
-            los_val_sq = pow(rp->getAmplitude(), 2);
-        }
-        else {
-            sum_ampl_sq += pow(rp->getAmplitude(), 2);
-        }
+    if (sum_p > 0) {
+        // Mean delay weighted by the powers, and its standard deviation
+        const double mean_delay = sum_p_delay / sum_p;
+
+        m_metrics.mean_excess_delay = mean_delay - min_delay;
+        m_metrics.rms_delay_spread  = sqrt(max(0.0, sum_p_delay_sq / sum_p - mean_delay * mean_delay));
     }
 
-    // Rice factor in dB
-    m_rice_factor = 10*log10(los_val_sq/sum_ampl_sq);
+    // Rice factor in dB (the power of the emitter is the same for all the rays)
+    m_metrics.rice_factor = 10*log10(los_power / nlos_power);
+}
 
-    // Unlock the mutex to allow others threads to access
-    m_mutex.unlock();
+/**
+ * @brief Receiver::noiseFloor
+ * @return
+ *
+ * Returns the noise power at the receivers (in dBm)
+ */
+double Receiver::noiseFloor() {
+    const double temperature = SimulationHandler::simulationData()->getSimulationTemperature();
+    const double bandwidth = SimulationHandler::simulationData()->getSimulationBandwidth();
+
+    const double therm_noise = 10.0 * log10(K_boltz * temperature * bandwidth / 1e-3);
+    const double noise_fig = SimulationHandler::simulationData()->getSimulationNoiseFigure();
 
-    return m_rice_factor;
+    return therm_noise + noise_fig;
 }
 
 /**
@@ -519,73 +910,115 @@ void Receiver::paintFlat(QPainter *painter) {
         return;
     }
 
-    double data = 0;
+    painter->fillRect(
+                -RECEIVER_AREA_SIZE/2, -RECEIVER_AREA_SIZE/2,
+                 RECEIVER_AREA_SIZE,    RECEIVER_AREA_SIZE,
+                resultColor(m_result_type, m_res_min, m_res_max));
+}
 
-    switch (m_result_type) {
+/**
+ * @brief Receiver::resultValue
+ * @param type
+ * @return
+ *
+ * Returns the value of the given result type, as shown on the heat maps
+ * (the power is converted in dBm)
+ */
+double Receiver::resultValue(ResultType::ResultType type) {
+    switch (type) {
     case ResultType::Power:
-        data = SimulationData::convertPowerTodBm(receivedPower());
-        break;
+        return SimulationData::convertPowerTodBm(resultsPower());
     case ResultType::CoverageMap:
     case ResultType::SNR:
-        data = userEndSNR();
-        break;
+        return resultsSNR();
     case ResultType::DelaySpread:
-        data = delaySpread();
-        break;
+        return m_metrics.delay_spread;
+    case ResultType::MeanExcessDelay:
+        return m_metrics.mean_excess_delay;
+    case ResultType::RmsDelaySpread:
+        return m_metrics.rms_delay_spread;
     case ResultType::RiceFactor:
-        data = riceFactor();
-        break;
+        return m_metrics.rice_factor;
     }
 
-    QColor background_color;
+    return NAN;
+}
+
+/**
+ * @brief Receiver::resultColor
+ * @param type
+ * @param min
+ * @param max
+ * @return
+ *
+ * Returns the heat map color of the receiver for the given result type.
+ * The range [min, max] must be rounded with roundResultsRange().
+ */
+QColor Receiver::resultColor(ResultType::ResultType type, double min, double max) {
+    // Not computed yet (gray background)
+    if (!isFinalized())
+        return qRgb(220,220,220);
+
+    const double data = resultValue(type);
 
-    if (!isinf(data) && !isnan(data) && !outOfModel() && !(data < m_res_min)) {
-        double data_ratio = (data - m_res_min) / (m_res_max - m_res_min);
+    if (!isinf(data) && !isnan(data) && !outOfModel() && !(data < min)) {
+        double data_ratio = (data - min) / (max - min);
 
         // Use the light color profile
-        background_color = SimulationData::ratioToColor(data_ratio, true);
+        return SimulationData::ratioToColor(data_ratio, true);
     }
     else if (outOfModel()) {
         // White background
-        background_color = qRgb(255,255,255);
+        return qRgb(255,255,255);
     }
     else {
         // Gray background
-        background_color = qRgb(220,220,220);
+        return qRgb(220,220,220);
     }
-
-    painter->fillRect(
-                -RECEIVER_AREA_SIZE/2, -RECEIVER_AREA_SIZE/2,
-                 RECEIVER_AREA_SIZE,    RECEIVER_AREA_SIZE,
-                background_color);
 }
 
-void Receiver::showResults(ResultType::ResultType type, double min, double max) {
-    // Result type
-    m_result_type = type;
-
+/**
+ * @brief Receiver::roundResultsRange
+ * @param type
+ * @param min
+ * @param max
+ *
+ * This function converts and rounds the range of the received data
+ * (as given by SimulationArea::getReceivedDataBounds) to the range shown on the heat maps
+ */
+void Receiver::roundResultsRange(ResultType::ResultType type, double *min, double *max) {
     // If result is power -> convert watts to dBm
     switch (type) {
     case ResultType::Power: {
-        min = floor(SimulationData::convertPowerTodBm(min));
-        max = ceil(SimulationData::convertPowerTodBm(max));
+        *min = floor(SimulationData::convertPowerTodBm(*min));
+        *max = ceil(SimulationData::convertPowerTodBm(*max));
         break;
     }
     case ResultType::SNR:
     case ResultType::RiceFactor: {
-        min = floor(min);
-        max = ceil(max);
+        *min = floor(*min);
+        *max = ceil(*max);
         break;
     }
     case ResultType::DelaySpread:
+    case ResultType::MeanExcessDelay:
+    case ResultType::RmsDelaySpread:
         // Nothing to round/convert
         break;
     case ResultType::CoverageMap: {
-        min = SimulationHandler::simulationData()->getSimulationTargetSNR();
-        max = ceil(max);
+        *min = SimulationHandler::simulationData()->getSimulationTargetSNR();
+        *max = ceil(*max);
         break;
     }
     }
+}
+
+void Receiver::showResults(ResultType::ResultType type, double min, double max) {
+    // Result type
+    m_result_type = type;
+
+    // Round the data range
+    roundResultsRange(type, &min, &max);
 
     // Store the data range
     m_res_min = min;
@@ -610,48 +1043,84 @@ void Receiver::generateIdleTooltip() {
 }
 
 void Receiver::generateResultsTooltip() {
-    // Set the tooltip of the receiver with
-    //  - the number of incident rays
+    setToolTip(resultsTooltip());
+}
+
+/**
+ * @brief Receiver::resultsTooltip
+ * @return
+ *
+ * Returns the tooltip text of the receiver with the computed results
+ */
+QString Receiver::resultsTooltip() {
+    // Tooltip of the receiver with
+    //  - the number of incident rays (and of each type)
     //  - the received power
     //  - the UE SNR
-    //  - the delay spread (if one)
+    //  - the delay spread, mean excess delay and RMS delay spread (if one)
     //  - the rice factor (if one)
 
+    // No results while the receiver is computed
+    if (!isFinalized()) {
+        return QString("<b><u>Receiver</u></b><br/>"
+                       "<b><i>%1</i></b>")
+                .arg(m_antenna->getAntennaName());
+    }
 
     // Tooltip shows special message if out of model
     if (outOfModel()) {
-        setToolTip(QString("<b><u>Receiver</u></b><br/>"
-                           "<b><i>%1</i></b><br/>"
-                           "<i><u>Out of Model</u></i>")
-                   .arg(m_antenna->getAntennaName()));
-        return;
+        return QString("<b><u>Receiver</u></b><br/>"
+                       "<b><i>%1</i></b><br/>"
+                       "<i><u>Out of Model</u></i>")
+                .arg(m_antenna->getAntennaName());
     }
 
 
+    const ReceiverMetrics &m = m_metrics;
+
     QString tip_str = QString(
                 "<b><u>Receiver</u></b><br/>"
                 "<b><i>%1</i></b><br/>"
-                "<b>Incident rays:</b> %2<br/>"
-                "<b>Power:</b> %3&nbsp;dBm<br/>"
-                "<b>UE SNR:</b> %4&nbsp;dB")
+                "<b>Incident rays:</b> %2 (LOS:&nbsp;%3, reflected:&nbsp;%4, diffracted:&nbsp;%5, ground:&nbsp;%6)<br/>"
+                "<b>Power:</b> %7&nbsp;dBm<br/>"
+                "<b>UE SNR:</b> %8&nbsp;dB")
             .arg(m_antenna->getAntennaName())
-            .arg(getRayPaths().size())
-            .arg(SimulationData::convertPowerTodBm(receivedPower()), 0, 'f', 2)
-            .arg(userEndSNR(), 0, 'f', 2);
-
-    double delay_spread = delaySpread();
-    double rice_factor = riceFactor();
+            .arg(m_ray_paths_count)
+            .arg(m.paths_count[RayType::LOS])
+            .arg(m.paths_count[RayType::Reflection])
+            .arg(m.paths_count[RayType::Diffraction])
+            .arg(m.paths_count[RayType::Ground])
+            .arg(SimulationData::convertPowerTodBm(m.received_power), 0, 'f', 2)
+            .arg(m.user_end_SNR, 0, 'f', 2);
+
+    double delay_spread = m.delay_spread;
+    double mean_delay = m.mean_excess_delay;
+    double rms_delay = m.rms_delay_spread;
+    double rice_factor = m.rice_factor;
 
     if (!isnan(delay_spread)) {
         QString units;
-        double hr_ds = SimulationData::delayToHumanReadable(delaySpread(), &units);
+        double hr_ds = SimulationData::delayToHumanReadable(delay_spread, &units);
         tip_str.append(QString("<br/><b>Delay spread: </b>%1&nbsp;%2").arg(hr_ds, 0, 'f', 2).arg(units));
     }
+    if (!isnan(mean_delay)) {
+        QString units;
+        double hr_md = SimulationData::delayToHumanReadable(mean_delay, &units);
+        tip_str.append(QString("<br/><b>Mean excess delay: </b>%1&nbsp;%2").arg(hr_md, 0, 'f', 2).arg(units));
+    }
+    if (!isnan(rms_delay)) {
+        QString units;
+        double hr_rms = SimulationData::delayToHumanReadable(rms_delay, &units);
+        tip_str.append(QString("<br/><b>RMS delay spread: </b>%1&nbsp;%2").arg(hr_rms, 0, 'f', 2).arg(units));
+    }
     if (!isnan(rice_factor) && !isinf(rice_factor)) {
         tip_str.append(QString("<br/><b>Rice factor: </b>%1&nbsp;dB").arg(rice_factor, 0, 'f', 2));
     }
+    if (!isnan(m.frequency_selectivity) && !isinf(m.frequency_selectivity)) {
+        tip_str.append(QString("<br/><b>Power range over the sweep: </b>%1&nbsp;dB").arg(m.frequency_selectivity, 0, 'f', 2));
+    }
 
-    setToolTip(tip_str);
+    return tip_str;
 }
 
 
@@ -1,12 +1,16 @@
 #ifndef RECEIVER_H
 #define RECEIVER_H
 
+#include <algorithm>
+
+#include <QAtomicInt>
 #include <QGraphicsItem>
-#include <QMutex>
 #include <QSet>
 
 #include "simulationitem.h"
 #include "raypath.h"
+#include "rayrecord.h"
+#include "raypatharena.h"
 #include "antennas.h"
 #include "emitter.h"
 
@@ -15,11 +19,41 @@ enum ResultType {
     Power,
     SNR,
     DelaySpread,
+    MeanExcessDelay,
+    RmsDelaySpread,
     RiceFactor,
     CoverageMap
 };
 }
 
+// Results of a receiver, computed in a single pass over its ray paths when it is
+// finalized (NAN when not defined)
+struct ReceiverMetrics {
+    double received_power;      // Watts
+    double user_end_SNR;        // dB
+    double min_delay;           // Delay of the first and last rays (seconds)
+    double max_delay;
+    double delay_spread;        // Seconds
+    double mean_excess_delay;   // Seconds
+    double rms_delay_spread;    // Seconds
+    double rice_factor;         // dB
+    double frequency_selectivity;   // Range of the received power over the frequency sweep (dB)
+    int paths_count[RayType::RayTypesCount];
+
+    void clear() {
+        received_power = NAN;
+        user_end_SNR = NAN;
+        min_delay = NAN;
+        max_delay = NAN;
+        delay_spread = NAN;
+        mean_excess_delay = NAN;
+        rms_delay_spread = NAN;
+        rice_factor = NAN;
+        frequency_selectivity = NAN;
+        std::fill(paths_count, paths_count + RayType::RayTypesCount, 0);
+    }
+};
+
 class Receiver : public SimulationItem
 {
 public:
@@ -37,11 +71,12 @@ public:
     void setRotation(double angle);
     double getRotation() const;
     double getIncidentRayAngle(QLineF ray) const;
+    double getIncidentRayAngle(double ray_angle) const;
 
     double getEfficiency() const;
     double getResistance() const;
-    vector<complex> getEffectiveHeight(double phi, double frequency) const;
-    vector<complex> getEffectiveHeight(double theta, double phi, double frequency) const;
+    Vec3c getEffectiveHeight(double phi, double frequency) const;
+    Vec3c getEffectiveHeight(double theta, double phi, double frequency) const;
     double getGain(double phi) const;
 
     QRectF boundingRect() const override;
@@ -53,36 +88,78 @@ public:
     void paintFlat(QPainter *painter);
 
     void reset();
-    void addRayPath(RayPath *rp);
-    QList<RayPath*> getRayPaths();
+    void addRayPaths(const RayPathBuffer &buffer, RayPathArena *arena);
+    void invalidateResults();
+    void finalize();
+    bool isFinalized() const;
+    QVector<RayRecord> getRayRecords() const;
+    int getRayPathsCount() const;
+    double getRayPower(const RayRecord &rec) const;
+    double getRayAmplitude(const RayRecord &rec) const;
     void discardEmitter(Emitter *e);
+    void relocateRayPaths(RayPathArena *arena, RayPathBuffer *buffer);
+    qint64 rayPathsBytes() const;
 
-    void setOutOfModel(bool out, Emitter *e);
-    bool outOfModel();
+    QList<RayPath*> createRayPathItems();
+    QList<RayPath*> getRayPathItems();
+    void deleteRayPathItems();
 
-    double receivedPower();
-    double userEndSNR();
-    double delaySpread();
-    double riceFactor();
+    bool outOfModel();
+    Emitter *outOfModelEmitter() const;
+
+    const ReceiverMetrics &metrics() const;
+    double receivedPower() const;
+    double userEndSNR() const;
+    double userEndSNR(const RayPathBuffer &buffer) const;
+    double delaySpread() const;
+    double meanExcessDelay() const;
+    double rmsDelaySpread() const;
+    double riceFactor() const;
+    QVector<double> sweepPower() const;
+
+    static void setResultsSweepIndex(int index);
+    static int resultsSweepIndex();
+    double resultsPower() const;
+    double resultsSNR() const;
 
     bool isCovered(double coverage_margin);
+    static double noiseFloor();
+
+    double resultValue(ResultType::ResultType type);
+    QColor resultColor(ResultType::ResultType type, double min, double max);
+    static void roundResultsRange(ResultType::ResultType type, double *min, double *max);
 
     void showResults(ResultType::ResultType type, double min, double max);
 
     void generateIdleTooltip();
     void generateResultsTooltip();
+    QString resultsTooltip();
 
 private:
+    void appendRayBlock(RayPathBlock *block);
+    QList<QLineF> getRayLines(const RayPathBlock *block, const RayRecord &rec) const;
+
+    void computeMetrics();
+
     double m_rotation_angle;
     Antenna *m_antenna;
 
-    QList<RayPath*> m_received_rays;
+    // Received ray paths (blocks stored in the arenas of the simulation handler)
+    RayPathBlock *m_ray_blocks;
+    RayPathBlock *m_last_ray_block;
+    int m_ray_paths_count;
     QSet<Emitter*> m_attached_emitters;
 
-    double m_received_power;
-    double m_user_end_SNR;
-    double m_delay_spread;
-    double m_rice_factor;
+    // Graphics items of the ray paths (only created on demand)
+    QList<RayPath*> m_ray_path_items;
+
+    // Results computed once the ray paths are all added (see finalize())
+    ReceiverMetrics m_metrics;
+    QVector<double> m_sweep_power;  // Received power at each frequency of the sweep (Watts)
+    QAtomicInt m_finalized;
+
+    // Index of the sweep frequency of the shown results (-1 for the frequencies of the emitters)
+    static int m_results_sweep_index;
 
     ResultType::ResultType m_result_type;
     double m_res_min;
@@ -93,8 +170,6 @@ private:
 
     bool m_out_of_model;
     Emitter *m_oom_emitter; // The receiver is out of model w.r.t. this emitter
-
-    QMutex m_mutex;
 };
 
 // Operator overload to write objects from the Receiver class into a files
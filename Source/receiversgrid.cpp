@@ -0,0 +1,322 @@
+#include "receiversgrid.h"
+#include "constants.h"
+#include "imagetree.h"
+#include "receiver.h"
+
+#include <qnumeric.h>
+
+// Average number of receivers per grid cell
+#define RECEIVERS_PER_CELL  4.0
+
+// Maximum number of cells in the grid
+#define GRID_MAX_CELLS      1000000
+
+// Margin added around the cells for the region tests, so a receiver on
+// (or very close to) a cell boundary is never missed
+#define GRID_MARGIN         1e-6    // Meters
+
+// Relative tolerance of the distance test of the cells
+#define DISTANCE_TOLERANCE  1e-9
+
+
+ReceiversGrid::ReceiversGrid()
+{
+    clear();
+}
+
+/**
+ * @brief ReceiversGrid::clear
+ *
+ * This function removes all the receivers from the grid
+ */
+void ReceiversGrid::clear() {
+    m_bounds = QRectF();
+    m_cell_size = 1.0;
+    m_cols = 0;
+    m_rows = 0;
+
+    m_cells_start.clear();
+    m_entries.clear();
+    m_positions.clear();
+    m_indexes.clear();
+}
+
+bool ReceiversGrid::isEmpty() const {
+    return m_entries.isEmpty();
+}
+
+int ReceiversGrid::size() const {
+    return m_entries.size();
+}
+
+/**
+ * @brief ReceiversGrid::indexOf
+ * @param r
+ * @return
+ *
+ * Returns the index of the receiver in the grid, or -1 if it is not in the grid
+ */
+int ReceiversGrid::indexOf(Receiver *r) const {
+    return m_indexes.value(r, -1);
+}
+
+/**
+ * @brief ReceiversGrid::build
+ * @param receivers_list
+ *
+ * This function builds the grid over the given receivers list.
+ * The size of the cells is chosen to have a few receivers per cell.
+ */
+void ReceiversGrid::build(const QList<Receiver*> &receivers_list) {
+    clear();
+
+    if (receivers_list.isEmpty())
+        return;
+
+    // Compute the bounding rect of all receivers (in meters)
+    double min_x = qInf(), min_y = qInf();
+    double max_x = -qInf(), max_y = -qInf();
+
+    m_positions.reserve(receivers_list.size());
+    m_indexes.reserve(receivers_list.size());
+
+    foreach (Receiver *r, receivers_list) {
+        const QPointF pos = r->getRealPos();
+
+        min_x = min(min_x, pos.x());
+        min_y = min(min_y, pos.y());
+        max_x = max(max_x, pos.x());
+        max_y = max(max_y, pos.y());
+
+        m_indexes.insert(r, m_positions.size());
+        m_positions.append(pos);
+    }
+
+    m_bounds = QRectF(QPointF(min_x, min_y), QPointF(max_x, max_y))
+            .adjusted(-GRID_MARGIN, -GRID_MARGIN, GRID_MARGIN, GRID_MARGIN);
+
+    // A few receivers per cell, but limit the total number of cells
+    m_cell_size = sqrt(m_bounds.width() * m_bounds.height() * RECEIVERS_PER_CELL / receivers_list.size());
+    m_cell_size = max(m_cell_size, GRID_MARGIN);
+
+    while (ceil(m_bounds.width() / m_cell_size) * ceil(m_bounds.height() / m_cell_size) > GRID_MAX_CELLS) {
+        m_cell_size *= 2.0;
+    }
+
+    m_cols = max(1, (int) ceil(m_bounds.width()  / m_cell_size));
+    m_rows = max(1, (int) ceil(m_bounds.height() / m_cell_size));
+
+    // First pass: count the receivers in each cell
+    QVector<int> cells_count(m_cols * m_rows, 0);
+
+    foreach (const QPointF &pos, m_positions) {
+        cells_count[cellY(pos.y()) * m_cols + cellX(pos.x())]++;
+    }
+
+    // Compute the start offset of each cell
+    m_cells_start.resize(m_cols * m_rows + 1);
+    m_cells_start[0] = 0;
+
+    for (int i = 0 ; i < cells_count.size() ; i++) {
+        m_cells_start[i+1] = m_cells_start[i] + cells_count[i];
+    }
+
+    // Second pass: fill the cells
+    m_entries.resize(m_positions.size());
+
+    QVector<int> cells_fill = m_cells_start;
+
+    for (int i = 0 ; i < m_positions.size() ; i++) {
+        const int cell = cellY(m_positions[i].y()) * m_cols + cellX(m_positions[i].x());
+        m_entries[cells_fill[cell]++] = i;
+    }
+}
+
+/**
+ * @brief ReceiversGrid::cellX
+ * @param x
+ * @return
+ *
+ * This function returns the column of the cell containing the abscissa x
+ * (bounded to the grid)
+ */
+int ReceiversGrid::cellX(double x) const {
+    const int cx = (int) floor((x - m_bounds.left()) / m_cell_size);
+    return qBound(0, cx, m_cols - 1);
+}
+
+/**
+ * @brief ReceiversGrid::cellY
+ * @param y
+ * @return
+ *
+ * This function returns the row of the cell containing the ordinate y
+ * (bounded to the grid)
+ */
+int ReceiversGrid::cellY(double y) const {
+    const int cy = (int) floor((y - m_bounds.top()) / m_cell_size);
+    return qBound(0, cy, m_rows - 1);
+}
+
+/**
+ * @brief ReceiversGrid::blockRect
+ * @return
+ *
+ * This function returns the rectangle of the cells cx1 to cx2 and cy1 to cy2
+ * (included), enlarged by the grid margin
+ */
+QRectF ReceiversGrid::blockRect(int cx1, int cy1, int cx2, int cy2) const {
+    return QRectF(QPointF(m_bounds.left() + cx1 * m_cell_size, m_bounds.top() + cy1 * m_cell_size),
+                  QPointF(m_bounds.left() + (cx2 + 1) * m_cell_size, m_bounds.top() + (cy2 + 1) * m_cell_size))
+            .adjusted(-GRID_MARGIN, -GRID_MARGIN, GRID_MARGIN, GRID_MARGIN);
+}
+
+/**
+ * @brief ReceiversGrid::findInValidityRegion
+ * @param tree
+ * @param node
+ * @param source
+ * @param max_distance
+ * @param receivers
+ *
+ * This function appends to the receivers vector the index of all the receivers that are
+ * in the validity region of the node of the image tree, and not farther than max_distance
+ * from the source. The region is rasterized on the grid: the blocks of cells out of the
+ * region are discarded at once, and the receivers of the other cells are tested one by one
+ * (with the same test as the receiver by receiver computation).
+ */
+void ReceiversGrid::findInValidityRegion(
+        const ImageTree *tree,
+        int node,
+        const QPointF &source,
+        double max_distance,
+        QVector<int> *receivers) const
+{
+    if (isEmpty())
+        return;
+
+    visitBlock(tree, node, source, max_distance, 0, 0, m_cols - 1, m_rows - 1, receivers);
+}
+
+/**
+ * @brief ReceiversGrid::visitBlock
+ *
+ * This function finds the receivers of the cells cx1 to cx2 and cy1 to cy2 (included)
+ * in the validity region. The block is split in two halves until it is out of the
+ * region or it is only one cell.
+ */
+void ReceiversGrid::visitBlock(
+        const ImageTree *tree,
+        int node,
+        const QPointF &source,
+        double max_distance,
+        int cx1,
+        int cy1,
+        int cx2,
+        int cy2,
+        QVector<int> *receivers) const
+{
+    const QRectF rect = blockRect(cx1, cy1, cx2, cy2);
+
+    // Discard the block if all its points are farther than max_distance from the source
+    const double dx = max(0.0, max(rect.left() - source.x(), source.x() - rect.right()));
+    const double dy = max(0.0, max(rect.top() - source.y(), source.y() - rect.bottom()));
+
+    if (sqrt(dx*dx + dy*dy) > max_distance * (1.0 + DISTANCE_TOLERANCE))
+        return;
+
+    // Discard the block if it is out of the validity region
+    if (!tree->intersectsValidityRegion(node, rect))
+        return;
+
+    // Test the receivers of one cell
+    if (cx1 == cx2 && cy1 == cy2) {
+        const int cell = cy1 * m_cols + cx1;
+
+        for (int i = m_cells_start[cell] ; i < m_cells_start[cell+1] ; i++) {
+            if (tree->isInValidityRegion(node, m_positions[m_entries[i]])) {
+                receivers->append(m_entries[i]);
+            }
+        }
+
+        return;
+    }
+
+    // Split the block along its largest side
+    if (cx2 - cx1 >= cy2 - cy1) {
+        const int mid = (cx1 + cx2) / 2;
+        visitBlock(tree, node, source, max_distance, cx1, cy1, mid, cy2, receivers);
+        visitBlock(tree, node, source, max_distance, mid + 1, cy1, cx2, cy2, receivers);
+    }
+    else {
+        const int mid = (cy1 + cy2) / 2;
+        visitBlock(tree, node, source, max_distance, cx1, cy1, cx2, mid, receivers);
+        visitBlock(tree, node, source, max_distance, cx1, mid + 1, cx2, cy2, receivers);
+    }
+}
+
+
+/**
+ * @brief ReflectionCandidates::ReflectionCandidates
+ * @param tree
+ * @param grid
+ * @param max_distance
+ *
+ * This constructor finds the receivers in the validity region of each node of the tree
+ * (traced from the source of the tree), and stores the nodes of each receiver.
+ * The receivers farther than max_distance from the source have no nodes.
+ */
+ReflectionCandidates::ReflectionCandidates(
+        const ImageTree *tree,
+        const ReceiversGrid *grid,
+        double max_distance)
+{
+    // Receivers of each node (node by node)
+    QVector<int> pairs_receiver;
+    QVector<int> pairs_node;
+    QVector<int> found;
+
+    for (int i = 0 ; i < tree->size() ; i++) {
+        found.clear();
+        grid->findInValidityRegion(tree, i, tree->getSource(), max_distance, &found);
+
+        foreach (int r, found) {
+            pairs_receiver.append(r);
+            pairs_node.append(i);
+        }
+    }
+
+    // Sort the pairs by receiver (the nodes stay in the order of the tree)
+    QVector<int> receivers_count(grid->size(), 0);
+
+    foreach (int r, pairs_receiver) {
+        receivers_count[r]++;
+    }
+
+    m_receivers_start.resize(grid->size() + 1);
+    m_receivers_start[0] = 0;
+
+    for (int r = 0 ; r < grid->size() ; r++) {
+        m_receivers_start[r+1] = m_receivers_start[r] + receivers_count[r];
+    }
+
+    m_nodes.resize(pairs_node.size());
+
+    QVector<int> receivers_fill = m_receivers_start;
+
+    for (int k = 0 ; k < pairs_node.size() ; k++) {
+        m_nodes[receivers_fill[pairs_receiver[k]]++] = pairs_node[k];
+    }
+}
+
+int ReflectionCandidates::count(int receiver) const {
+    return m_receivers_start[receiver+1] - m_receivers_start[receiver];
+}
+
+const int *ReflectionCandidates::nodes(int receiver) const {
+    return m_nodes.constData() + m_receivers_start[receiver];
+}
+
+int ReflectionCandidates::totalCount() const {
+    return m_nodes.size();
+}
@@ -0,0 +1,87 @@
+#ifndef RECEIVERSGRID_H
+#define RECEIVERSGRID_H
+
+#include <QHash>
+#include <QList>
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+
+class ImageTree;
+class Receiver;
+
+// Uniform grid over the receivers of a simulation (in meters), used by the
+// reciprocity mode to find all the receivers in a region at once.
+// The receivers are identified by their index in the list given to build().
+class ReceiversGrid
+{
+public:
+    ReceiversGrid();
+
+    void build(const QList<Receiver*> &receivers_list);
+    void clear();
+
+    bool isEmpty() const;
+    int size() const;
+    int indexOf(Receiver *r) const;
+
+    void findInValidityRegion(
+            const ImageTree *tree,
+            int node,
+            const QPointF &source,
+            double max_distance,
+            QVector<int> *receivers) const;
+
+private:
+    int cellX(double x) const;
+    int cellY(double y) const;
+    QRectF blockRect(int cx1, int cy1, int cx2, int cy2) const;
+    void visitBlock(
+            const ImageTree *tree,
+            int node,
+            const QPointF &source,
+            double max_distance,
+            int cx1,
+            int cy1,
+            int cx2,
+            int cy2,
+            QVector<int> *receivers) const;
+
+    QRectF m_bounds;
+    double m_cell_size;
+    int m_cols;
+    int m_rows;
+
+    // Compressed storage: the receivers of the cell i are the entries
+    // m_cells_start[i] to m_cells_start[i+1] - 1
+    QVector<int> m_cells_start;
+    QVector<int> m_entries;
+
+    // Position of each receiver, and index of each receiver
+    QVector<QPointF> m_positions;
+    QHash<Receiver*,int> m_indexes;
+};
+
+// Image tree nodes whose validity region contains each receiver of a grid
+// (the reflections to compute for each receiver in the reciprocity mode).
+// The nodes of a receiver are in the order of the tree.
+class ReflectionCandidates
+{
+public:
+    ReflectionCandidates(
+            const ImageTree *tree,
+            const ReceiversGrid *grid,
+            double max_distance);
+
+    int count(int receiver) const;
+    const int *nodes(int receiver) const;
+    int totalCount() const;
+
+private:
+    // The nodes of the receiver i are m_nodes[m_receivers_start[i]] to
+    // m_nodes[m_receivers_start[i+1] - 1]
+    QVector<int> m_receivers_start;
+    QVector<int> m_nodes;
+};
+
+#endif // RECEIVERSGRID_H
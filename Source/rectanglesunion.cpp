@@ -0,0 +1,273 @@
+#include "rectanglesunion.h"
+
+#include <algorithm>
+
+
+// Edge of a rectangle crossed by the sweep line: the rectangle starts (or ends) at the
+// position pos of the sweep, over the compressed interval [from, to[
+struct SweepEvent {
+    double pos;
+    int from;
+    int to;
+    bool start;
+
+    bool operator<(const SweepEvent &other) const {
+        return pos < other.pos;
+    }
+};
+
+// Interval [from, to[ of compressed coordinates
+typedef QPair<int,int> Interval;
+
+
+// Segment tree counting the rectangles covering the elementary intervals
+// [coords[i], coords[i+1]] crossed by the sweep line
+class CoverageTree
+{
+public:
+    CoverageTree(int intervals_count) {
+        m_size = intervals_count;
+        m_count.fill(0, 4 * qMax(1, m_size));
+        m_covered.fill(0, 4 * qMax(1, m_size));
+    }
+
+    void add(int from, int to, int delta) {
+        add(1, 0, m_size, from, to, delta);
+    }
+
+    // Appends the uncovered parts of [from, to[ (in increasing order)
+    void uncovered(int from, int to, QVector<Interval> *intervals) const {
+        uncovered(1, 0, m_size, from, to, intervals);
+    }
+
+private:
+    void add(int node, int lo, int hi, int from, int to, int delta) {
+        if (to <= lo || hi <= from)
+            return;
+
+        if (from <= lo && hi <= to) {
+            m_count[node] += delta;
+        }
+        else {
+            const int mid = (lo + hi) / 2;
+            add(2*node, lo, mid, from, to, delta);
+            add(2*node+1, mid, hi, from, to, delta);
+        }
+
+        // Number of covered elementary intervals of the node
+        if (m_count[node] > 0) {
+            m_covered[node] = hi - lo;
+        }
+        else if (hi - lo == 1) {
+            m_covered[node] = 0;
+        }
+        else {
+            m_covered[node] = m_covered[2*node] + m_covered[2*node+1];
+        }
+    }
+
+    void uncovered(int node, int lo, int hi, int from, int to, QVector<Interval> *intervals) const {
+        if (to <= lo || hi <= from || m_count[node] > 0)
+            return;
+
+        // Nothing covered in the node: all its part of [from, to[ is uncovered
+        if (m_covered[node] == 0) {
+            const int a = (lo > from ? lo : from);
+            const int b = (hi < to ? hi : to);
+
+            if (!intervals->isEmpty() && intervals->last().second == a) {
+                intervals->last().second = b;
+            }
+            else {
+                intervals->append(Interval(a, b));
+            }
+
+            return;
+        }
+
+        const int mid = (lo + hi) / 2;
+        uncovered(2*node, lo, mid, from, to, intervals);
+        uncovered(2*node+1, mid, hi, from, to, intervals);
+    }
+
+    int m_size;
+    QVector<int> m_count;       // Rectangles covering the whole node
+    QVector<int> m_covered;     // Covered elementary intervals in the node
+};
+
+
+/**
+ * @brief mergeIntervals
+ * @param intervals
+ *
+ * This function sorts the intervals, and merges the ones that overlap or touch
+ */
+static void mergeIntervals(QVector<Interval> *intervals) {
+    if (intervals->isEmpty())
+        return;
+
+    std::sort(intervals->begin(), intervals->end());
+
+    int last = 0;
+
+    for (int i = 1 ; i < intervals->size() ; i++) {
+        if ((*intervals)[i].first <= (*intervals)[last].second) {
+            (*intervals)[last].second = qMax((*intervals)[last].second, (*intervals)[i].second);
+        }
+        else {
+            (*intervals)[++last] = (*intervals)[i];
+        }
+    }
+
+    intervals->resize(last + 1);
+}
+
+
+/**
+ * @brief RectanglesUnion::outline
+ * @param rects
+ * @return
+ *
+ * This function returns the outline of the union of the rectangles, as maximal
+ * horizontal and vertical lines: the collinear parts of the outline are merged
+ * (except when the inside of the union is on opposite sides, as at the common
+ * corner of two rectangles touching diagonally).
+ * The lines are oriented with the inside of the union on their right.
+ */
+QList<QLineF> RectanglesUnion::outline(const QVector<QRectF> &rects) {
+    QVector<QRectF> valid_rects;
+    valid_rects.reserve(rects.size());
+
+    // Ignore the empty rectangles (no wall)
+    foreach (const QRectF &r, rects) {
+        const QRectF rect = r.normalized();
+
+        if (rect.width() > 0 && rect.height() > 0) {
+            valid_rects.append(rect);
+        }
+    }
+
+    QList<QLineF> lines;
+
+    sweep(valid_rects, true, &lines);
+    sweep(valid_rects, false, &lines);
+
+    return lines;
+}
+
+/**
+ * @brief RectanglesUnion::sweep
+ * @param rects
+ * @param vertical
+ * @param lines
+ *
+ * This function appends the vertical (or horizontal) lines of the outline.
+ * The sweep line moves along the x axis (or the y axis) over the edges of the rectangles.
+ * At a position of the sweep, the outline is where the coverage changes: the intervals
+ * covered before the position but not after it (rectangles ending here), and the ones
+ * covered after but not before (rectangles starting here).
+ */
+void RectanglesUnion::sweep(const QVector<QRectF> &rects, bool vertical, QList<QLineF> *lines) {
+    if (rects.isEmpty())
+        return;
+
+    // Compressed coordinates of the intervals along the sweep line
+    QVector<double> coords;
+    coords.reserve(2 * rects.size());
+
+    foreach (const QRectF &r, rects) {
+        coords.append(vertical ? r.top() : r.left());
+        coords.append(vertical ? r.bottom() : r.right());
+    }
+
+    std::sort(coords.begin(), coords.end());
+    coords.erase(std::unique(coords.begin(), coords.end()), coords.end());
+
+    // Start and end edges of the rectangles
+    QVector<SweepEvent> events;
+    events.reserve(2 * rects.size());
+
+    foreach (const QRectF &r, rects) {
+        const double lo = (vertical ? r.top() : r.left());
+        const double hi = (vertical ? r.bottom() : r.right());
+
+        SweepEvent ev;
+        ev.from = std::lower_bound(coords.begin(), coords.end(), lo) - coords.begin();
+        ev.to   = std::lower_bound(coords.begin(), coords.end(), hi) - coords.begin();
+
+        ev.pos = (vertical ? r.left() : r.top());
+        ev.start = true;
+        events.append(ev);
+
+        ev.pos = (vertical ? r.right() : r.bottom());
+        ev.start = false;
+        events.append(ev);
+    }
+
+    std::sort(events.begin(), events.end());
+
+    CoverageTree tree(coords.size() - 1);
+
+    QVector<Interval> inside_after;     // Covered after the position only
+    QVector<Interval> inside_before;    // Covered before the position only
+
+    int first = 0;
+
+    while (first < events.size()) {
+        // Events at the same position
+        int last = first;
+
+        while (last < events.size() && events[last].pos == events[first].pos) {
+            last++;
+        }
+
+        inside_after.clear();
+        inside_before.clear();
+
+        // Parts of the starting rectangles that were not covered before
+        for (int i = first ; i < last ; i++) {
+            if (events[i].start) {
+                tree.uncovered(events[i].from, events[i].to, &inside_after);
+            }
+        }
+
+        // Coverage after the position
+        for (int i = first ; i < last ; i++) {
+            tree.add(events[i].from, events[i].to, events[i].start ? 1 : -1);
+        }
+
+        // Parts of the ending rectangles that are not covered after
+        for (int i = first ; i < last ; i++) {
+            if (!events[i].start) {
+                tree.uncovered(events[i].from, events[i].to, &inside_before);
+            }
+        }
+
+        mergeIntervals(&inside_after);
+        mergeIntervals(&inside_before);
+
+        const double pos = events[first].pos;
+
+        // Orient the lines with the inside of the union on their right
+        // (the y axis of the scene is pointing down)
+        foreach (const Interval &in, inside_after) {
+            if (vertical) {
+                lines->append(QLineF(pos, coords[in.second], pos, coords[in.first]));
+            }
+            else {
+                lines->append(QLineF(coords[in.first], pos, coords[in.second], pos));
+            }
+        }
+
+        foreach (const Interval &in, inside_before) {
+            if (vertical) {
+                lines->append(QLineF(pos, coords[in.first], pos, coords[in.second]));
+            }
+            else {
+                lines->append(QLineF(coords[in.second], pos, coords[in.first], pos));
+            }
+        }
+
+        first = last;
+    }
+}
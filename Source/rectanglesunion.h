@@ -0,0 +1,21 @@
+#ifndef RECTANGLESUNION_H
+#define RECTANGLESUNION_H
+
+#include <QLineF>
+#include <QList>
+#include <QRectF>
+#include <QVector>
+
+// Outline of the union of axis-aligned rectangles (the walls of the buildings).
+// The outline is computed by two sweep lines (one per axis) over the edges of the
+// rectangles, with a segment tree of the covered intervals: O(n log n) for n rectangles.
+class RectanglesUnion
+{
+public:
+    static QList<QLineF> outline(const QVector<QRectF> &rects);
+
+private:
+    static void sweep(const QVector<QRectF> &rects, bool vertical, QList<QLineF> *lines);
+};
+
+#endif // RECTANGLESUNION_H
@@ -0,0 +1,242 @@
+#include "segmentkernel.h"
+
+#include <qnumeric.h>
+
+// SSE2 is always available on x86-64. AVX2 is selected at runtime (GCC and Clang only).
+#if defined(__x86_64__) || defined(_M_X64)
+#define SEGMENT_KERNEL_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(SEGMENT_KERNEL_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define SEGMENT_KERNEL_AVX2
+#include <immintrin.h>
+#endif
+
+
+// Signature of the implementations of SegmentKernel::firstHit()
+typedef int (*FirstHitFunction)(
+        double x0, double y0, double ax, double ay,
+        const WallsArrays &walls, int first, int end);
+
+
+/**
+ * @brief segmentHitsWall
+ *
+ * This function tests one wall, with the same operations as QLineF::intersects():
+ * the segment starts at (x0, y0) with the vector (ax, ay), and the wall i is given
+ * by its first point and its (p1 - p2) vector.
+ */
+static inline bool segmentHitsWall(
+        double x0, double y0, double ax, double ay,
+        const WallsArrays &walls, int i)
+{
+    const double bx = walls.bx[i];
+    const double by = walls.by[i];
+    const double ox = x0 - walls.x1[i];
+    const double oy = y0 - walls.y1[i];
+
+    // Parallel lines (no intersection)
+    const double denominator = ay * bx - ax * by;
+
+    if (denominator == 0 || !qIsFinite(denominator))
+        return false;
+
+    const double reciprocal = 1 / denominator;
+
+    // Position of the intersection on the segment and on the wall
+    const double na = (by * ox - bx * oy) * reciprocal;
+
+    if (na < 0 || na > 1)
+        return false;
+
+    const double nb = (ax * oy - ay * ox) * reciprocal;
+
+    if (nb < 0 || nb > 1)
+        return false;
+
+    return true;
+}
+
+static int firstHitScalar(
+        double x0, double y0, double ax, double ay,
+        const WallsArrays &walls, int first, int end)
+{
+    for (int i = first ; i < end ; i++) {
+        if (segmentHitsWall(x0, y0, ax, ay, walls, i))
+            return i;
+    }
+
+    return -1;
+}
+
+#ifdef SEGMENT_KERNEL_SSE2
+/**
+ * @brief firstHitSse2
+ *
+ * Tests two walls at a time. The comparisons are ordered (false with a NaN),
+ * as the comparisons of the scalar test.
+ */
+static int firstHitSse2(
+        double x0, double y0, double ax, double ay,
+        const WallsArrays &walls, int first, int end)
+{
+    const __m128d v_x0 = _mm_set1_pd(x0);
+    const __m128d v_y0 = _mm_set1_pd(y0);
+    const __m128d v_ax = _mm_set1_pd(ax);
+    const __m128d v_ay = _mm_set1_pd(ay);
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d one  = _mm_set1_pd(1.0);
+    const __m128d inf  = _mm_set1_pd(qInf());
+    const __m128d sign = _mm_set1_pd(-0.0);
+
+    int i = first;
+
+    for ( ; i + 2 <= end ; i += 2) {
+        const __m128d bx = _mm_loadu_pd(walls.bx + i);
+        const __m128d by = _mm_loadu_pd(walls.by + i);
+        const __m128d ox = _mm_sub_pd(v_x0, _mm_loadu_pd(walls.x1 + i));
+        const __m128d oy = _mm_sub_pd(v_y0, _mm_loadu_pd(walls.y1 + i));
+
+        const __m128d den = _mm_sub_pd(_mm_mul_pd(v_ay, bx), _mm_mul_pd(v_ax, by));
+
+        // Not parallel: denominator != 0 and finite
+        const __m128d valid = _mm_and_pd(
+                    _mm_cmpneq_pd(den, zero),
+                    _mm_cmplt_pd(_mm_andnot_pd(sign, den), inf));
+
+        const __m128d rec = _mm_div_pd(one, den);
+        const __m128d na = _mm_mul_pd(_mm_sub_pd(_mm_mul_pd(by, ox), _mm_mul_pd(bx, oy)), rec);
+        const __m128d nb = _mm_mul_pd(_mm_sub_pd(_mm_mul_pd(v_ax, oy), _mm_mul_pd(v_ay, ox)), rec);
+
+        const __m128d outside = _mm_or_pd(
+                    _mm_or_pd(_mm_cmplt_pd(na, zero), _mm_cmpgt_pd(na, one)),
+                    _mm_or_pd(_mm_cmplt_pd(nb, zero), _mm_cmpgt_pd(nb, one)));
+
+        const int mask = _mm_movemask_pd(_mm_andnot_pd(outside, valid));
+
+        if (mask != 0)
+            return i + ((mask & 1) ? 0 : 1);
+    }
+
+    // Remaining wall
+    return firstHitScalar(x0, y0, ax, ay, walls, i, end);
+}
+#endif
+
+#ifdef SEGMENT_KERNEL_AVX2
+/**
+ * @brief firstHitAvx2
+ *
+ * Tests four walls at a time (same operations as the SSE2 implementation).
+ * Only FMA-free instructions are used, so the products are rounded as in the scalar test.
+ */
+__attribute__((target("avx2")))
+static int firstHitAvx2(
+        double x0, double y0, double ax, double ay,
+        const WallsArrays &walls, int first, int end)
+{
+    const __m256d v_x0 = _mm256_set1_pd(x0);
+    const __m256d v_y0 = _mm256_set1_pd(y0);
+    const __m256d v_ax = _mm256_set1_pd(ax);
+    const __m256d v_ay = _mm256_set1_pd(ay);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one  = _mm256_set1_pd(1.0);
+    const __m256d inf  = _mm256_set1_pd(qInf());
+    const __m256d sign = _mm256_set1_pd(-0.0);
+
+    int i = first;
+
+    for ( ; i + 4 <= end ; i += 4) {
+        const __m256d bx = _mm256_loadu_pd(walls.bx + i);
+        const __m256d by = _mm256_loadu_pd(walls.by + i);
+        const __m256d ox = _mm256_sub_pd(v_x0, _mm256_loadu_pd(walls.x1 + i));
+        const __m256d oy = _mm256_sub_pd(v_y0, _mm256_loadu_pd(walls.y1 + i));
+
+        const __m256d den = _mm256_sub_pd(_mm256_mul_pd(v_ay, bx), _mm256_mul_pd(v_ax, by));
+
+        // Not parallel: denominator != 0 and finite
+        const __m256d valid = _mm256_and_pd(
+                    _mm256_cmp_pd(den, zero, _CMP_NEQ_UQ),
+                    _mm256_cmp_pd(_mm256_andnot_pd(sign, den), inf, _CMP_LT_OQ));
+
+        const __m256d rec = _mm256_div_pd(one, den);
+        const __m256d na = _mm256_mul_pd(_mm256_sub_pd(_mm256_mul_pd(by, ox), _mm256_mul_pd(bx, oy)), rec);
+        const __m256d nb = _mm256_mul_pd(_mm256_sub_pd(_mm256_mul_pd(v_ax, oy), _mm256_mul_pd(v_ay, ox)), rec);
+
+        const __m256d outside = _mm256_or_pd(
+                    _mm256_or_pd(_mm256_cmp_pd(na, zero, _CMP_LT_OQ), _mm256_cmp_pd(na, one, _CMP_GT_OQ)),
+                    _mm256_or_pd(_mm256_cmp_pd(nb, zero, _CMP_LT_OQ), _mm256_cmp_pd(nb, one, _CMP_GT_OQ)));
+
+        const int mask = _mm256_movemask_pd(_mm256_andnot_pd(outside, valid));
+
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+
+    // Remaining walls
+    return firstHitScalar(x0, y0, ax, ay, walls, i, end);
+}
+#endif
+
+/**
+ * @brief selectFirstHit
+ * @return
+ *
+ * Returns the best implementation for the processor
+ */
+static FirstHitFunction selectFirstHit() {
+#ifdef SEGMENT_KERNEL_AVX2
+    if (__builtin_cpu_supports("avx2"))
+        return firstHitAvx2;
+#endif
+
+#ifdef SEGMENT_KERNEL_SSE2
+    return firstHitSse2;
+#else
+    return firstHitScalar;
+#endif
+}
+
+// Implementation selected at the first use
+static FirstHitFunction firstHitFunction() {
+    static const FirstHitFunction function = selectFirstHit();
+    return function;
+}
+
+/**
+ * @brief SegmentKernel::firstHit
+ * @param segment
+ * @param walls
+ * @param first
+ * @param end
+ * @return
+ *
+ * This function returns the index of the first wall (from first to end - 1)
+ * crossed by the segment (endpoints included), or -1 if none.
+ */
+int SegmentKernel::firstHit(const QLineF &segment, const WallsArrays &walls, int first, int end) {
+    return firstHitFunction()(segment.x1(), segment.y1(), segment.dx(), segment.dy(), walls, first, end);
+}
+
+/**
+ * @brief SegmentKernel::name
+ * @return
+ *
+ * Returns the name of the implementation used on this processor
+ */
+QString SegmentKernel::name() {
+    const FirstHitFunction function = firstHitFunction();
+
+#ifdef SEGMENT_KERNEL_AVX2
+    if (function == firstHitAvx2)
+        return "avx2";
+#endif
+
+#ifdef SEGMENT_KERNEL_SSE2
+    if (function == firstHitSse2)
+        return "sse2";
+#endif
+
+    return "scalar";
+}
@@ -0,0 +1,27 @@
+#ifndef SEGMENTKERNEL_H
+#define SEGMENTKERNEL_H
+
+#include <QLineF>
+#include <QString>
+
+// Walls given as a structure of arrays (see WallsGrid): the first point
+// of each wall (x1, y1), and the vector from its second point to its first point (bx, by)
+struct WallsArrays {
+    const double *x1;
+    const double *y1;
+    const double *bx;
+    const double *by;
+};
+
+// Batch test of a segment against a range of walls (innermost test of the ray-tracing).
+// The walls are tested several at a time with AVX2 (4 walls) or SSE2 (2 walls) when the
+// processor supports them, else one by one. All the implementations give the same result
+// as QLineF::intersects() == QLineF::BoundedIntersection for each wall (endpoints included).
+class SegmentKernel
+{
+public:
+    static int firstHit(const QLineF &segment, const WallsArrays &walls, int first, int end);
+    static QString name();
+};
+
+#endif // SEGMENTKERNEL_H
@@ -11,6 +11,7 @@ SimSetupDialog::SimSetupDialog(SimulationData *sim_data, QWidget *parent) :
     m_simulation_data = sim_data;
 
     connect(ui->validEmitterRadiusSpinBox, SIGNAL(valueChanged(double)), this, SLOT(updateUiComponents()));
+    connect(ui->sweepPointsSpinBox, SIGNAL(valueChanged(int)), this, SLOT(updateUiComponents()));
 }
 
 SimSetupDialog::~SimSetupDialog()
@@ -34,6 +35,10 @@ void SimSetupDialog::updateUiComponents() {
     if (is_min) {
         ui->pruningRadiusSpinBox->setValue(ui->pruningRadiusSpinBox->minimum());
     }
+
+    // The sweep frequencies are only used with at least one point (and one point is the start)
+    ui->sweepStartSpinBox->setEnabled(ui->sweepPointsSpinBox->value() > 0);
+    ui->sweepStopSpinBox->setEnabled(ui->sweepPointsSpinBox->value() > 1);
 }
 
 /**
@@ -53,6 +58,11 @@ int SimSetupDialog::exec() {
     ui->targetSNRSpinBox->setValue(m_simulation_data->getSimulationTargetSNR());
     ui->validEmitterRadiusSpinBox->setValue(m_simulation_data->getMinimumValidRadius());
 
+    // Sweep frequencies are in GHz
+    ui->sweepPointsSpinBox->setValue(m_simulation_data->getSweepPointsCount());
+    ui->sweepStartSpinBox->setValue(m_simulation_data->getSweepStartFrequency() * 1e-9);
+    ui->sweepStopSpinBox->setValue(m_simulation_data->getSweepStopFrequency() * 1e-9);
+
     // Special case for pruning
     double prune_radius = m_simulation_data->getPruningRadius();
     if (isinf(prune_radius)) {
@@ -62,6 +72,8 @@ int SimSetupDialog::exec() {
         ui->pruningRadiusSpinBox->setValue(prune_radius);
     }
 
+    updateUiComponents();
+
     // Execute the dialog
     int ans = QDialog::exec();
 
@@ -76,6 +88,10 @@ int SimSetupDialog::exec() {
         m_simulation_data->setSimulationNoiseFigure(ui->noiseFigureSpinBox->value());
         m_simulation_data->setSimulationTargetSNR(ui->targetSNRSpinBox->value());
         m_simulation_data->setMinimumValidRadius(ui->validEmitterRadiusSpinBox->value());
+        m_simulation_data->setSweepFrequencies(
+                    ui->sweepStartSpinBox->value() * 1e9,
+                    ui->sweepStopSpinBox->value() * 1e9,
+                    ui->sweepPointsSpinBox->value());
 
         // Special case for pruning
         prune_radius = ui->pruningRadiusSpinBox->value();
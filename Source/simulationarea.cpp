@@ -3,8 +3,10 @@
 #include "simulationhandler.h"
 
 #include <QApplication>
+#include <QGraphicsSceneHoverEvent>
+#include <QPainter>
 
-#define RECEIVER_AREA_SIZE (1.0 * simulationScene()->simulationScale())
+#define RECEIVER_AREA_SIZE (1.0 * SimulationScene::simulationScale())
 
 /*
  * This function allows "orderable positions", mendatory to use a position
@@ -26,6 +28,16 @@ bool operator<(const QPoint& p1, const QPoint& p2) {
 SimulationArea::SimulationArea() : QGraphicsRectItem(), SimulationItem()
 {
     QGraphicsRectItem::setZValue(-10);
+
+    // The tooltip of the receiver under the mouse is computed on hover
+    // (the SimulationItem base is the item added to the scene)
+    SimulationItem::setAcceptHoverEvents(true);
+
+    // No results shown at creation
+    m_result_type = ResultType::Power;
+    m_res_min = -100;
+    m_res_max = 0;
+    m_show_results = false;
 }
 
 SimulationArea::~SimulationArea() {
@@ -40,14 +52,14 @@ void SimulationArea::getReceivedDataBounds(ResultType::ResultType type, double *
     *min = qInf();
     *max = -qInf();
 
-    foreach(Receiver *r, m_receivers_map) {
-        // Skip out-of-model receivers
-        if (r->outOfModel())
+    foreach(Receiver *r, m_receivers_grid) {
+        // Skip the cells without receiver and the out-of-model receivers
+        if (r == nullptr || r->outOfModel())
             continue;
 
         switch (type) {
         case ResultType::Power:
-            val = r->receivedPower();
+            val = r->resultsPower();
 
             // Ignore zero-powers
             if (val == 0)
@@ -56,13 +68,19 @@ void SimulationArea::getReceivedDataBounds(ResultType::ResultType type, double *
             break;
         case ResultType::CoverageMap:
         case ResultType::SNR:
-            val = r->userEndSNR();
+            val = r->resultsSNR();
             break;
         case ResultType::DelaySpread:
-            val = r->delaySpread();
+            val = r->metrics().delay_spread;
+            break;
+        case ResultType::MeanExcessDelay:
+            val = r->metrics().mean_excess_delay;
+            break;
+        case ResultType::RmsDelaySpread:
+            val = r->metrics().rms_delay_spread;
             break;
         case ResultType::RiceFactor:
-            val = r->riceFactor();
+            val = r->metrics().rice_factor;
             break;
         }
 
@@ -80,11 +98,48 @@ void SimulationArea::getReceivedDataBounds(ResultType::ResultType type, double *
 }
 
 QList<Receiver*> SimulationArea::getReceiversList() const {
-    return m_receivers_map.values();
+    QList<Receiver*> rcv_list;
+    rcv_list.reserve(m_receivers_grid.size());
+
+    foreach(Receiver *r, m_receivers_grid) {
+        if (r != nullptr) {
+            rcv_list.append(r);
+        }
+    }
+
+    return rcv_list;
 }
 
 QMap<QPoint,Receiver*> SimulationArea::getReceiversMap() const {
-    return m_receivers_map;
+    QMap<QPoint,Receiver*> rcv_map;
+
+    for (int i = 0 ; i < m_receivers_grid.size() ; i++) {
+        if (m_receivers_grid[i] != nullptr) {
+            rcv_map.insert(QPoint(i % m_grid_size.width(), i / m_grid_size.width()), m_receivers_grid[i]);
+        }
+    }
+
+    return rcv_map;
+}
+
+/**
+ * @brief SimulationArea::getReceiverAt
+ * @param scene_pos
+ * @return
+ *
+ * Returns the receiver of the area at the given position (in scene coordinates),
+ * or nullptr if there is no receiver at this position
+ */
+Receiver *SimulationArea::getReceiverAt(const QPointF &scene_pos) const {
+    QPointF rel_pos = (SimulationItem::mapFromScene(scene_pos) - rect().topLeft()) / RECEIVER_AREA_SIZE;
+
+    int x = floor(rel_pos.x());
+    int y = floor(rel_pos.y());
+
+    if (x < 0 || y < 0 || x >= m_grid_size.width() || y >= m_grid_size.height())
+        return nullptr;
+
+    return m_receivers_grid[y * m_grid_size.width() + x];
 }
 
 void SimulationArea::setArea(AntennaType::AntennaType type, QRectF area) {
@@ -92,7 +147,7 @@ void SimulationArea::setArea(AntennaType::AntennaType type, QRectF area) {
     m_area = area;
 
     // Compute the area as a rect of size multiple of 1m²
-    qreal sim_scale = simulationScene()->simulationScale();
+    qreal sim_scale = SimulationScene::simulationScale();
 
     // Compute the 1m² fitted rect
     QSizeF fit_size(round(area.width() / sim_scale) * sim_scale,
@@ -108,8 +163,9 @@ void SimulationArea::setArea(AntennaType::AntennaType type, QRectF area) {
     setBrush(QBrush(qRgba(225, 225, 255, 255), Qt::DiagCrossPattern));
     QGraphicsRectItem::setRect(fit_area);
 
-    // Remove the placed emitters (if one)
+    // Remove the placed emitters (if one) and the shown results
     deletePlacedEmitters();
+    hideResults();
 
     // Delete and recreate the receivers list
     deleteReceivers();
@@ -148,18 +204,16 @@ void SimulationArea::removePlacedEmitter(Emitter *e) {
 }
 
 void SimulationArea::createReceivers(AntennaType::AntennaType type, QRectF area) {
-    if (!simulationScene())
-        return;
-
     // Get the count of receivers in each dimension
-    QSize num_rcv = (area.size() / simulationScene()->simulationScale()).toSize();
+    m_grid_size = (area.size() / SimulationScene::simulationScale()).toSize();
+    m_receivers_grid.fill(nullptr, m_grid_size.width() * m_grid_size.height());
 
     // Get the initial position of the receivers
     QPointF init_pos = area.topLeft() + QPointF(RECEIVER_AREA_SIZE/2, RECEIVER_AREA_SIZE/2);
 
     // Add a receiver to each m² on the area
-    for (int y = 0 ; y < num_rcv.height() ; y++) {
-        for (int x = 0 ; x < num_rcv.width() ; x++) {
+    for (int y = 0 ; y < m_grid_size.height() ; y++) {
+        for (int x = 0 ; x < m_grid_size.width() ; x++) {
             QPointF delta_pos(x * RECEIVER_AREA_SIZE, y * RECEIVER_AREA_SIZE);
             QPointF rcv_pos = init_pos + delta_pos;
 
@@ -170,7 +224,7 @@ void SimulationArea::createReceivers(AntennaType::AntennaType type, QRectF area)
                 // If the position is overlapped by a building -> don't place a receiver
                 if (b->getRect().contains(rcv_pos)) {
                     // Go to the end of this building
-                    x = (b->getRect().right() - init_pos.x()) / simulationScene()->simulationScale();
+                    x = (b->getRect().right() - init_pos.x()) / SimulationScene::simulationScale();
                     overlap_building = true;
                     break;
                 }
@@ -180,13 +234,11 @@ void SimulationArea::createReceivers(AntennaType::AntennaType type, QRectF area)
             if (overlap_building)
                 continue;
 
+            // The receiver is not added to the scene (the results are drawn by the area)
             Receiver *rcv = new Receiver(type, 1.0);
-            simulationScene()->addItem(rcv);
-
-            rcv->setFlat(true);
             rcv->setPos(rcv_pos);
 
-            m_receivers_map.insert(QPoint(x,y), rcv);
+            m_receivers_grid[y * m_grid_size.width() + x] = rcv;
         }
 
         // Avoid freezing the UI
@@ -195,11 +247,12 @@ void SimulationArea::createReceivers(AntennaType::AntennaType type, QRectF area)
 }
 
 void SimulationArea::deleteReceivers() {
-    foreach(Receiver *r, m_receivers_map) {
+    foreach(Receiver *r, m_receivers_grid) {
         delete r;
     }
 
-    m_receivers_map.clear();
+    m_receivers_grid.clear();
+    m_grid_size = QSize();
 }
 
 void SimulationArea::deletePlacedEmitters() {
@@ -221,5 +274,96 @@ QPainterPath SimulationArea::shape() const {
 
 void SimulationArea::paint(QPainter *p, const QStyleOptionGraphicsItem *s, QWidget *w) {
     QGraphicsRectItem::paint(p, s, w);
+
+    if (!m_show_results)
+        return;
+
+    // Draw the heat map image on the area (one pixel per m², without smoothing)
+    p->save();
+    p->setRenderHint(QPainter::SmoothPixmapTransform, false);
+    p->drawImage(rect(), m_results_image);
+    p->restore();
+}
+
+/**
+ * @brief SimulationArea::showResults
+ * @param type
+ * @param min
+ * @param max
+ *
+ * This function draws the heat map of the given result type, in the range [min, max]
+ * (as given by getReceivedDataBounds)
+ */
+void SimulationArea::showResults(ResultType::ResultType type, double min, double max) {
+    Receiver::roundResultsRange(type, &min, &max);
+
+    m_result_type = type;
+    m_res_min = min;
+    m_res_max = max;
+    m_show_results = true;
+
+    renderResults();
+    SimulationItem::update();
+}
+
+/**
+ * @brief SimulationArea::refreshResults
+ *
+ * This function redraws the shown heat map (if one) with the current data of the receivers
+ */
+void SimulationArea::refreshResults() {
+    if (!m_show_results)
+        return;
+
+    renderResults();
+    SimulationItem::update();
+}
+
+void SimulationArea::hideResults() {
+    m_show_results = false;
+    m_results_image = QImage();
+
+    SimulationItem::setToolTip(QString());
+    SimulationItem::update();
+}
+
+/**
+ * @brief SimulationArea::renderResults
+ *
+ * This function renders the colors of the receivers into the heat map image.
+ * The cells without receiver (under the buildings) are left transparent.
+ */
+void SimulationArea::renderResults() {
+    if (m_results_image.size() != m_grid_size) {
+        m_results_image = QImage(m_grid_size, QImage::Format_ARGB32_Premultiplied);
+    }
+
+    m_results_image.fill(Qt::transparent);
+
+    for (int y = 0 ; y < m_grid_size.height() ; y++) {
+        QRgb *line = (QRgb*) m_results_image.scanLine(y);
+
+        for (int x = 0 ; x < m_grid_size.width() ; x++) {
+            Receiver *r = m_receivers_grid[y * m_grid_size.width() + x];
+
+            if (r != nullptr) {
+                line[x] = r->resultColor(m_result_type, m_res_min, m_res_max).rgb();
+            }
+        }
+    }
+}
+
+void SimulationArea::hoverMoveEvent(QGraphicsSceneHoverEvent *event) {
+    // Show the results of the receiver under the mouse
+    Receiver *r = getReceiverAt(event->scenePos());
+
+    if (m_show_results && r != nullptr) {
+        SimulationItem::setToolTip(r->resultsTooltip());
+    }
+    else {
+        SimulationItem::setToolTip(QString());
+    }
+
+    SimulationItem::hoverMoveEvent(event);
 }
 
@@ -1,6 +1,8 @@
 #ifndef SIMULATIONAREA_H
 #define SIMULATIONAREA_H
 
+#include <QImage>
+
 #include "simulationitem.h"
 #include "raypath.h"
 #include "antennas.h"
@@ -24,6 +26,7 @@ public:
 
     QList<Receiver*> getReceiversList() const;
     QMap<QPoint,Receiver*> getReceiversMap() const;
+    Receiver *getReceiverAt(const QPointF &scene_pos) const;
     void setArea(AntennaType::AntennaType type, QRectF area);
     QRectF getArea();
     QRectF getRealArea();
@@ -38,15 +41,33 @@ public:
     QPainterPath shape() const override;
     void paint(QPainter *p, const QStyleOptionGraphicsItem *s, QWidget *w) override;
 
+    void showResults(ResultType::ResultType type, double min, double max);
+    void refreshResults();
+    void hideResults();
+
     void deletePlacedEmitters();
 
+protected:
+    void hoverMoveEvent(QGraphicsSceneHoverEvent *event) override;
+
 private:
     void createReceivers(AntennaType::AntennaType type, QRectF area);
     void deleteReceivers();
+    void renderResults();
 
-    QMap<QPoint,Receiver*> m_receivers_map;
+    // Receivers of each m² of the area (row by row, nullptr under the buildings).
+    // They are only used for the computation, they are not added to the scene.
+    QVector<Receiver*> m_receivers_grid;
+    QSize m_grid_size;
     QRectF m_area;
 
+    // Heat map of the results (one pixel per receiver)
+    QImage m_results_image;
+    ResultType::ResultType m_result_type;
+    double m_res_min;
+    double m_res_max;
+    bool m_show_results;
+
     QList<Emitter*> m_placed_emitters;
 };
 
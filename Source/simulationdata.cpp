@@ -1,5 +1,10 @@
 #include "simulationdata.h"
 #include "corner.h"
+#include "rectanglesunion.h"
+
+#include <QHash>
+
+#include <algorithm>
 
 // The max amplitude for the data's color
 #define PEAK_COLOR_LIGHT 255
@@ -24,6 +29,11 @@
 #define DEFAULT_SIM_NOISE_FIGURE    10  // dB
 #define DEFAULT_SIM_TARGET_SNR      2   // dB
 
+// Default frequency sweep (disabled)
+#define DEFAULT_SWEEP_START         26  // GHz
+#define DEFAULT_SWEEP_STOP          28  // GHz
+#define DEFAULT_SWEEP_POINTS        0
+
 
 SimulationData::SimulationData() : QObject()
 {
@@ -215,6 +225,10 @@ void SimulationData::resetDefaults() {
     m_sim_target_SNR    = DEFAULT_SIM_TARGET_SNR;
     m_min_valid_radius  = DEFAULT_VALID_RADIUS;
     m_pruning_radius    = DEFAULT_PRUNE_RADIUS;
+
+    m_sweep_start       = DEFAULT_SWEEP_START * 1e9;
+    m_sweep_stop        = DEFAULT_SWEEP_STOP * 1e9;
+    m_sweep_points      = DEFAULT_SWEEP_POINTS;
 }
 
 QList<Wall*> SimulationData::makeBuildingWallsFiltered(const QRectF boundary_rect) const {
@@ -249,76 +263,102 @@ QList<Wall*> SimulationData::makeBuildingWallsFiltered(const QRectF boundary_rec
     return walls_flt;
 }
 
+/**
+ * @brief SimulationData::makeBuildingWallsList
+ * @return
+ *
+ * This function returns the walls of the union of all the buildings
+ * (the outline of the buildings rectangles, see RectanglesUnion)
+ */
 QList<Wall*> SimulationData::makeBuildingWallsList() const {
-    QPainterPath buildings_path;
+    QVector<QRectF> rects;
+    rects.reserve(m_building_list.size());
 
-    // Unite all building rectangles into one path
     foreach (Building *b, m_building_list) {
-        QPainterPath pth;
-        pth.addRect(b->getRect());
+        rects.append(b->getRect());
+    }
+
+    // Divide the outline of the buildings in walls
+    QList<Wall*> wall_list;
 
-        buildings_path = buildings_path.united(pth);
+    foreach (const QLineF &line, RectanglesUnion::outline(rects)) {
+        Wall *w = new Wall(line);
+        wall_list.append(w);
     }
 
-    // Simplify the path
-    buildings_path = buildings_path.simplified();
+    return wall_list;
+}
 
-    // Get the independent polygons
-    QList<QPolygonF> poly_list = buildings_path.toSubpathPolygons();
+/**
+ * @brief SimulationData::makeWallsCorners
+ * @param walls_list
+ * @return
+ *
+ * This function returns the corners formed by the pairs of walls with a common end.
+ * The walls are grouped by end point (hash), so only the walls with a common end are
+ * compared. The corners are in the order of the pairs of walls.
+ */
+QList<Corner*> SimulationData::makeWallsCorners(QList<Wall*> walls_list) const {
+    // Walls of each end point
+    QHash<QPair<qreal,qreal>, QVector<int>> walls_ends;
 
-    // Divide all the polygons in walls
-    QList<Wall*> wall_list;
+    for (int i = 0 ; i < walls_list.size() ; i++) {
+        const QLineF line = walls_list.at(i)->getLine();
 
-    foreach(QPolygonF p, poly_list) {
-        QList<QPointF> poly_points = p.toList();
+        walls_ends[qMakePair(line.x1(), line.y1())].append(i);
 
-        // Loop from 0 to Size - 2 since the last point is the same as the first one (closed path)
-        for (int i = 0 ; i < poly_points.size() - 1 ; i++) {
-            QLineF line(poly_points[i], poly_points[i+1]);
-            Wall *w = new Wall(line);
-            wall_list.append(w);
+        if (line.p2() != line.p1()) {
+            walls_ends[qMakePair(line.x2(), line.y2())].append(i);
         }
     }
 
-    return wall_list;
-}
+    // Pairs of walls with a common end (a pair can have two common ends)
+    QVector<QPair<int,int>> pairs;
+
+    foreach (const QVector<int> &walls, walls_ends) {
+        for (int a = 0 ; a < walls.size() ; a++) {
+            for (int b = a+1 ; b < walls.size() ; b++) {
+                pairs.append(qMakePair(min(walls[a], walls[b]), max(walls[a], walls[b])));
+            }
+        }
+    }
+
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
 
-QList<Corner*> SimulationData::makeWallsCorners(QList<Wall*> walls_list) const {
     // Initialize the corners list
     QList<Corner*> corner_list;
     QLineF l_w1, l_w2;
 
     // Check the start/end points for each pair of wall
-    for (int i = 0 ; i < walls_list.size() ; i++) {
-        for (int j = i+1 ; j < walls_list.size() ; j++) {
-            Wall *w1 = walls_list.at(i);
-            Wall *w2 = walls_list.at(j);
-
-            // Get the line of each wall
-            l_w1 = w1->getLine();
-            l_w2 = w2->getLine();
-
-            // Check if one end matches for both walls
-            if (l_w1.p1() == l_w2.p1()) {
-                // In this case, there is a corner at l_w1.p1()
-                Corner *corner = new Corner(l_w1.p1(), l_w1.p2(), l_w2.p2(), w1, w2);
-                corner_list.append(corner);
-            }
-            else if (l_w1.p1() == l_w2.p2()) {
-                // In this case, there is a corner at l_w1.p1()
-                Corner *corner = new Corner(l_w1.p1(), l_w1.p2(), l_w2.p1(), w1, w2);
-                corner_list.append(corner);
-            }
-            else if (l_w1.p2() == l_w2.p1()) {
-                // In this case, there is a corner at l_w1.p2()
-                Corner *corner = new Corner(l_w1.p2(), l_w1.p1(), l_w2.p2(), w1, w2);
-                corner_list.append(corner);
-            }
-            else if (l_w1.p2() == l_w2.p2()) {
-                // In this case, there is a corner at l_w1.p2()
-                Corner *corner = new Corner(l_w1.p2(), l_w1.p1(), l_w2.p1(), w1, w2);
-                corner_list.append(corner);
-            }
+    foreach (const QPair<int,int> &pair, pairs) {
+        Wall *w1 = walls_list.at(pair.first);
+        Wall *w2 = walls_list.at(pair.second);
+
+        // Get the line of each wall
+        l_w1 = w1->getLine();
+        l_w2 = w2->getLine();
+
+        // Check if one end matches for both walls
+        if (l_w1.p1() == l_w2.p1()) {
+            // In this case, there is a corner at l_w1.p1()
+            Corner *corner = new Corner(l_w1.p1(), l_w1.p2(), l_w2.p2(), w1, w2);
+            corner_list.append(corner);
+        }
+        else if (l_w1.p1() == l_w2.p2()) {
+            // In this case, there is a corner at l_w1.p1()
+            Corner *corner = new Corner(l_w1.p1(), l_w1.p2(), l_w2.p1(), w1, w2);
+            corner_list.append(corner);
+        }
+        else if (l_w1.p2() == l_w2.p1()) {
+            // In this case, there is a corner at l_w1.p2()
+            Corner *corner = new Corner(l_w1.p2(), l_w1.p1(), l_w2.p2(), w1, w2);
+            corner_list.append(corner);
+        }
+        else if (l_w1.p2() == l_w2.p2()) {
+            // In this case, there is a corner at l_w1.p2()
+            Corner *corner = new Corner(l_w1.p2(), l_w1.p1(), l_w2.p1(), w1, w2);
+            corner_list.append(corner);
         }
     }
 
@@ -418,6 +458,50 @@ double SimulationData::getPruningRadius() const {
     return m_pruning_radius;
 }
 
+/**
+ * @brief SimulationData::setSweepFrequencies
+ * @param start
+ * @param stop
+ * @param points
+ *
+ * Sets the frequencies (in Hz) at which the received power is evaluated from the
+ * computed ray paths, in addition to the frequencies of the emitters.
+ * The points are evenly spaced from start to stop (0 point disables the sweep).
+ */
+void SimulationData::setSweepFrequencies(double start, double stop, int points) {
+    m_sweep_start = start;
+    m_sweep_stop = stop;
+    m_sweep_points = max(points, 0);
+}
+double SimulationData::getSweepStartFrequency() const {
+    return m_sweep_start;
+}
+double SimulationData::getSweepStopFrequency() const {
+    return m_sweep_stop;
+}
+int SimulationData::getSweepPointsCount() const {
+    return m_sweep_points;
+}
+
+/**
+ * @brief SimulationData::getSweepFrequencies
+ * @return
+ *
+ * Returns the frequencies of the sweep (in Hz), empty if the sweep is disabled
+ */
+QVector<double> SimulationData::getSweepFrequencies() const {
+    QVector<double> frequencies;
+
+    // A single point is at the start frequency
+    const double step = (m_sweep_points > 1 ? (m_sweep_stop - m_sweep_start) / (m_sweep_points - 1) : 0);
+
+    for (int i = 0 ; i < m_sweep_points ; i++) {
+        frequencies.append(m_sweep_start + i * step);
+    }
+
+    return frequencies;
+}
+
 // ---------------------------------------------------------------------------------------------- //
 
 // +++++++++++++++++++++++++++ SIMULATION DATA FILE WRITING FUNCTIONS +++++++++++++++++++++++++++ //
@@ -65,6 +65,11 @@ public:
     double getMinimumValidRadius() const;
     double getPruningRadius() const;
 
+    double getSweepStartFrequency() const;
+    double getSweepStopFrequency() const;
+    int getSweepPointsCount() const;
+    QVector<double> getSweepFrequencies() const;
+
     double computeThermalNoise() const;
 
     int maxReflectionsCount() const;
@@ -80,6 +85,7 @@ public slots:
     void setSimulationTargetSNR(double snr);
     void setMinimumValidRadius(double radius);
     void setPruningRadius(double radius);
+    void setSweepFrequencies(double start, double stop, int points);
 
     void setSimulationHeight(double height);
     void setReflectionsCount(int cnt);
@@ -106,6 +112,11 @@ private:
     double m_min_valid_radius;
     double m_pruning_radius;
 
+    // Frequency sweep evaluated from the computed ray paths (Hz, no sweep if no points)
+    double m_sweep_start;
+    double m_sweep_stop;
+    int m_sweep_points;
+
 
     // Operator overload to write the simulation data into a file
     friend QDataStream &operator>>(QDataStream &in, SimulationData *sd);
@@ -2,10 +2,50 @@
 #include "computationunit.h"
 #include "constants.h"
 #include "corner.h"
+#include "profiler.h"
 
 #include <QDebug>
 
-#define AREA_PER_THREAD 100
+// Estimated cost of a receiver (relative to the cost of one ray path)
+#define RECEIVER_BASE_COST  1.0
+
+
+/**
+ * @brief makeRayRecord
+ *
+ * This function fills the record of a computed ray path (without its points).
+ *
+ * @param emitter      : The emitter of the ray path
+ * @param En           : The electric field at the receiver
+ * @param dn           : The total length of the ray path
+ * @param theta        : The vertical angle at the receiver side
+ * @param receiver_ray : The ray line at the receiver side
+ * @param emitter_ray  : The ray line at the emitter side
+ * @param type         : The kind of ray path
+ */
+static RayRecord makeRayRecord(
+        Emitter *emitter,
+        const Vec3c &En,
+        double dn,
+        double theta,
+        const QLineF &receiver_ray,
+        const QLineF &emitter_ray,
+        RayType::RayType type)
+{
+    RayRecord rec;
+    rec.emitter = emitter;
+    rec.field = En;
+    rec.length = dn;
+    rec.excess_length = 0;
+    rec.theta = theta;
+    rec.arrival_angle = receiver_ray.angle() / 180.0 * M_PI;
+    rec.departure_angle = emitter_ray.angle() / 180.0 * M_PI;
+    rec.vertex_index = 0;
+    rec.vertex_count = 0;
+    rec.type = type;
+
+    return rec;
+}
 
 
 // Global variable for static access to simulation data
@@ -15,9 +55,21 @@ SimulationData *g_simulation_data = new SimulationData();
 SimulationHandler::SimulationHandler()
 {
     m_sim_started = false;
-    m_sim_cancelling = false;
+    m_sim_cancelling = 0;
     m_sim_done = false;
-    m_init_cu_count = 0;
+    m_finished_cu_count = 0;
+    m_incremental = false;
+    m_reciprocity = false;
+    m_discarded_bytes = 0;
+}
+
+SimulationHandler::~SimulationHandler()
+{
+    foreach (RayPathArena *arena, m_units_arenas) {
+        delete arena;
+    }
+
+    deleteReflectionCandidates();
 }
 
 /**
@@ -34,19 +86,67 @@ SimulationData *SimulationHandler::simulationData() {
  * @brief SimulationHandler::getRayPathsList
  * @return
  *
- * This function returns all the computed ray paths in the scene
+ * This function returns the graphics items of the computed ray paths in the scene.
+ * Only the items already created by the receivers (see Receiver::createRayPathItems)
+ * are returned.
  */
 QList<RayPath*> SimulationHandler::getRayPathsList() const {
     QList<RayPath*> ray_paths;
 
     // Append the ray paths of each receivers to the ray paths list to return
     foreach(Receiver *re, m_receivers_list) {
-        ray_paths.append(re->getRayPaths());
+        ray_paths.append(re->getRayPathItems());
     }
 
     return ray_paths;
 }
 
+/**
+ * @brief SimulationHandler::getRayPathsCount
+ * @return
+ *
+ * This function returns the number of computed ray paths in the scene
+ */
+int SimulationHandler::getRayPathsCount() const {
+    int count = 0;
+
+    foreach(Receiver *re, m_receivers_list) {
+        count += re->getRayPathsCount();
+    }
+
+    return count;
+}
+
+/**
+ * @brief SimulationHandler::getWallsCount
+ * @return
+ *
+ * This function returns the number of walls of the current simulation
+ */
+int SimulationHandler::getWallsCount() const {
+    return m_wall_list.size();
+}
+
+/**
+ * @brief SimulationHandler::getWallsList
+ * @return
+ *
+ * This function returns the walls of the current simulation (owned by the handler)
+ */
+QList<Wall*> SimulationHandler::getWallsList() const {
+    return m_wall_list;
+}
+
+/**
+ * @brief SimulationHandler::getCornersCount
+ * @return
+ *
+ * This function returns the number of corners of the current simulation
+ */
+int SimulationHandler::getCornersCount() const {
+    return m_corners_list.size();
+}
+
 /**
  * @brief SimulationHandler::isDone
  * @return
@@ -74,7 +174,29 @@ bool SimulationHandler::isRunning() const {
  * This function returns true if the simulation is cancelling
  */
 bool SimulationHandler::isCancelling() const {
-    return m_sim_cancelling;
+    return m_sim_cancelling.loadAcquire() != 0;
+}
+
+/**
+ * @brief SimulationHandler::reciprocityMode
+ * @return
+ *
+ * This function returns true if the reflections are traced from the emitters
+ * (see buildReflectionCandidates)
+ */
+bool SimulationHandler::reciprocityMode() const {
+    return m_reciprocity;
+}
+
+/**
+ * @brief SimulationHandler::setReciprocityMode
+ * @param enabled
+ *
+ * This function enables or disables the reciprocity mode for the next runs.
+ * Both modes compute the same ray paths.
+ */
+void SimulationHandler::setReciprocityMode(bool enabled) {
+    m_reciprocity = enabled;
 }
 
 
@@ -88,33 +210,15 @@ bool SimulationHandler::isCancelling() const {
  * This function returns the coordinates of the image of the 'source' point
  * after an axial symmetry through the wall.
  *
- * WARNING: the y axis is upside down in the graphics scene !
- *
  * @param source : The position of the source whose image is calculated
  * @param wall   : The wall over which compute the image
  * @return       : The coordinates of the image
  */
 QPointF SimulationHandler::mirror(const QPointF source, Wall *wall) {
-    // Get the angle of the wall to the horizontal axis
-    const double theta = wall->getRealLine().angle() * M_PI / 180.0 - M_PI / 2.0;
-
-    // Translate the origin of the coordinates system on the base of the wall
-    const double x = source.x() - wall->getRealLine().p1().x();
-    const double y = source.y() - wall->getRealLine().p1().y();
-
-    // We use a rotation matrix :
-    //   x' =  x*cos(θ) - y*sin(θ)
-    //   y' = -x*sin(θ) - y*cos(θ)
-    // to set the y' axis along the wall, so the image is at the opposite of the x' coordinate
-    // in the new coordinates system.
-    const double x_p =  x*cos(theta) - y*sin(theta);
-    const double y_p = -x*sin(theta) - y*cos(theta);
+    PROFILE_SCOPE(ProfileStage::Mirror);
 
-    // Rotate back to the original coordinates system
-    const QPointF rel_pos = QPointF(-x_p*cos(theta) - y_p*sin(theta), x_p*sin(theta) - y_p*cos(theta));
-
-    // Translate back to the original coordinates system
-    return rel_pos + wall->getRealLine().p1();
+    // The line equation of the wall is computed once (see Wall::mirror)
+    return wall->mirror(source);
 }
 
 
@@ -122,6 +226,7 @@ QPointF SimulationHandler::mirror(const QPointF source, Wall *wall) {
  * @brief SimulationHandler::checkIntersections
  *
  * This function checks if the ray intersects a wall
+ * (using the walls grid built at the start of the simulation)
  *
  * @param ray         : The ray to check for clearance
  * @param origin_wall : The wall from which this ray come from (reflection), or nullptr
@@ -133,24 +238,10 @@ bool SimulationHandler::checkIntersections(
         Wall *origin_wall,
         Wall *target_wall)
 {
-    // Loop over all walls of the scene and look for intersection with ray
-    foreach(Wall *w, m_wall_list) {
-        // Don't care about the origin or target wall (where this ray is reflected)
-        if (w == origin_wall || w == target_wall) {
-            continue;
-        }
-
-        // Get the intersection point
-        QLineF::IntersectionType i_t = ray.intersects(w->getRealLine(), nullptr);
-
-        // There is obscursion if the intersection with the ray is
-        // on the wall (not on its extension)
-        if (i_t == QLineF::BoundedIntersection) {
-            return true;
-        }
-    }
+    PROFILE_SCOPE(ProfileStage::CheckIntersections);
 
-    return false;
+    // Only the walls close to the ray are tested (walls grid traversal)
+    return m_walls_grid.intersects(ray, origin_wall, target_wall);
 }
 
 /**
@@ -167,7 +258,7 @@ bool SimulationHandler::checkIntersections(
  * @param ray_in : The incident ray
  * @return       : The reflection coefficient for this reflection
  */
-vector<complex> SimulationHandler::reflectionCoefficient(Wall *w, QLineF in_ray) {
+Vec3c SimulationHandler::reflectionCoefficient(Wall *w, QLineF in_ray) {
     // Get the properties of the simulation
     const double e_r = simulationData()->getRelPermitivity();
 
@@ -205,7 +296,7 @@ vector<complex> SimulationHandler::reflectionCoefficient(Wall *w, QLineF in_ray)
  * @param theta : [Optional] The vertical angle at receiver side
  * @return      : The "Nominal" electric field
  */
-vector<complex> SimulationHandler::computeNominalElecField(
+Vec3c SimulationHandler::computeNominalElecField(
         Emitter *em,
         QLineF e_ray,
         QLineF r_ray,
@@ -216,7 +307,7 @@ vector<complex> SimulationHandler::computeNominalElecField(
     double phi = em->getIncidentRayAngle(e_ray);
 
     // Get the polarization vector of the emitter
-    vector<complex> polarization = em->getPolarization();
+    Vec2c polarization = em->getPolarization();
 
     // Get properties from the emitter
     double GTX = em->getGain(theta, phi);
@@ -250,27 +341,37 @@ vector<complex> SimulationHandler::computeNominalElecField(
  *
  * @param emitter  : The emitter for this ray path
  * @param receiver : The receiver for this ray path
+ * @param buffer   : The buffer of the ray paths computed for this receiver
  * @param images   : The list of reflection images computed for this ray path
  * @param walls    : The list of walls that form a combination of reflections
- * @return         : A pointer to the new RayPath object computed (or nullptr if invalid)
+ * @return         : True if the ray path is valid (and added to the buffer)
  */
-RayPath *SimulationHandler::computeRayPath(
+bool SimulationHandler::computeRayPath(
         Emitter *emitter,
         Receiver *receiver,
-        QList<QPointF> images,
-        QList<Wall*> walls)
+        RayPathBuffer *buffer,
+        const QList<QPointF> &images,
+        const QList<Wall*> &walls)
 {
+    PROFILE_SCOPE(ProfileStage::ComputeRayPath);
+    PROFILE_COUNT(images.isEmpty() ? ProfileCounter::DirectTested : ProfileCounter::ReflectionTested, 1);
+
     // We run backward in this function (from receiver to emitter)
 
     // The first target point is the receiver
     QPointF target_point = receiver->getRealPos();
 
-    // This list will contain the lines forming the ray path
-    QList<QLineF> rays;
+    // The points of the ray path are added to the buffer (from the receiver to the emitter)
+    const int first_vertex = buffer->beginPath();
+    buffer->addVertex(target_point);
+
+    // Lines at the receiver side and at the emitter side of the ray path
+    QLineF receiver_ray;
+    QLineF emitter_ray;
 
     // This coefficient will contain the product of all reflection
     // coefficients for this ray path
-    vector<complex> coeff = {1,1,1};
+    Vec3c coeff = {1,1,1};
 
     // Total length of the ray path
     double dn = 0;
@@ -293,13 +394,15 @@ RayPath *SimulationHandler::computeRayPath(
 
         // The ray path is valid if the reflection is on the wall (not on its extension)
         if (i_t != QLineF::BoundedIntersection) {
-            return nullptr; // Return an invalid ray path
+            buffer->cancelPath(first_vertex);
+            return false; // Return an invalid ray path
         }
 
         // If the target point is the same as the reflection point
         //  -> not a physics situation -> invalid raypath
         if (reflection_pt == target_point) {
-            return nullptr;
+            buffer->cancelPath(first_vertex);
+            return false;
         }
 
         // Create a ray line between these two points
@@ -307,7 +410,8 @@ RayPath *SimulationHandler::computeRayPath(
 
         // If this ray intersects a wall -> neglected
         if (checkIntersections(ray, reflect_wall, target_wall)) {
-            return nullptr;
+            buffer->cancelPath(first_vertex);
+            return false;
         }
 
         // If this is the virtual ray from the last image to the receiver,
@@ -320,8 +424,13 @@ RayPath *SimulationHandler::computeRayPath(
         // The multiplication is made component by component (not a cross product).
         coeff *= reflectionCoefficient(reflect_wall, ray);
 
-        // Add this ray line to the list of lines forming the ray path
-        rays.append(ray);
+        // Keep the ray line at the receiver side
+        if (i == images.size()-1) {
+            receiver_ray = ray;
+        }
+
+        // Add the reflection point to the points of the ray path
+        buffer->addVertex(reflection_pt);
 
         // The next target point is the current reflection point
         target_point = reflection_pt;
@@ -331,7 +440,8 @@ RayPath *SimulationHandler::computeRayPath(
     // If the target point is the same as the emitter point
     //  -> not a physics situation -> invalid raypath
     if (emitter->getRealPos() == target_point) {
-        return nullptr;
+        buffer->cancelPath(first_vertex);
+        return false;
     }
 
     // The last ray line is from the emitter to the target point
@@ -339,11 +449,18 @@ RayPath *SimulationHandler::computeRayPath(
 
     // If this ray intersects a wall -> neglected
     if (checkIntersections(ray, nullptr, target_wall)) {
-        return nullptr;
+        buffer->cancelPath(first_vertex);
+        return false;
     }
 
-    // Add this last ray to the rays list
-    rays.append(ray);
+    // Add the emitter to the points of the ray path
+    buffer->addVertex(emitter->getRealPos());
+    emitter_ray = ray;
+
+    // If there were no images, this is the direct ray
+    if (images.isEmpty()) {
+        receiver_ray = ray;
+    }
 
     // If there were no images in the list, we are computing the direct ray, so the length
     // of the ray path (dn) is the length of the ray line from emitter to receiver.
@@ -352,96 +469,117 @@ RayPath *SimulationHandler::computeRayPath(
     }
 
     // Compute the electric field for this ray path (equation 8.78)
-    // rays.last() is the ray coming out from the emitter
-    // rays.first() is the ray coming to the receiver
     // The multiplication is made component by component (not a cross product).
-    vector<complex> En = coeff * computeNominalElecField(emitter, rays.last(), rays.first(), dn);
-
-    // Return a new RayPath object
-    RayPath *rp = new RayPath(emitter, receiver, rays, En, dn);
-    return rp;
+    Vec3c En = coeff * computeNominalElecField(emitter, emitter_ray, receiver_ray, dn);
+
+    // Add the ray path to the buffer of the receiver
+    RayRecord rec = makeRayRecord(
+                emitter,
+                En,
+                dn,
+                M_PI_2,
+                receiver_ray,
+                emitter_ray,
+                images.isEmpty() ? RayType::LOS : RayType::Reflection);
+
+    buffer->endPath(rec, first_vertex);
+
+    PROFILE_COUNT(images.isEmpty() ? ProfileCounter::DirectAccepted : ProfileCounter::ReflectionAccepted, 1);
+    return true;
 }
 
 /**
- * @brief SimulationHandler::recursiveReflection
+ * @brief SimulationHandler::computeReflectedRays
  *
- * This function gets the image of the source (emitter of previous image) over the 'reflect_wall'
- * and compute the ray path recursively.
+ * This function computes all the reflected ray paths from the emitter to the receiver.
+ * The images of the emitter are taken from its image tree (computed once for all receivers),
+ * and a ray path is computed only if the receiver is in the validity region of the image.
+ * In the reciprocity mode, these regions were already tested for all the receivers at once.
  * The computed ray paths are added to the RayPaths list of the receiver
  *
- * @param emitter      : The emitter for this ray path
- * @param receiver     : The receiver for this ray path
- * @param reflect_wall : The wall on which we will compute the reflection
- * @param images       : The list of images for the previous reflections
- * @param walls        : The list of walls for the previous reflections
- * @param level        : The recursion level
+ * @param emitter  : The emitter for these ray paths
+ * @param receiver : The receiver for these ray paths
+ * @param buffer   : The buffer of the ray paths computed for this receiver
  */
-void SimulationHandler::recursiveReflection(
-        Emitter *emitter,
-        Receiver *receiver,
-        Wall *reflect_wall,
-        QList<QPointF> images,
-        QList<Wall *> walls,
-        int level)
-{
-    // Position of the image of the source
-    QPointF src_image;
+void SimulationHandler::computeReflectedRays(Emitter *emitter, Receiver *receiver, RayPathBuffer *buffer) {
+    const ImageTree *tree = m_image_trees.value(emitter, nullptr);
 
-    if (images.size() == 0) {
-        // If there is no previous reflection, the source is the emitter
-        src_image = mirror(emitter->getRealPos(), reflect_wall);
-    }
-    else {
-        // If there are previous reflections, the source is the last image
-        src_image = mirror(images.last(), reflect_wall);
-    }
+    // No reflection to compute for this emitter
+    if (tree == nullptr)
+        return;
 
-    // Keep the list of walls and images for the next recursions
-    images.append(src_image);
-    walls.append(reflect_wall);
+    // Lists of the images and walls from the first to the current reflection
+    QList<QPointF> images;
+    QList<Wall*> walls;
 
-    // Compute the complete ray path for this set of reflections
-    RayPath *rp = computeRayPath(emitter, receiver, images, walls);
+    // Reciprocity mode: only the nodes whose validity region contains the receiver
+    // (found from the emitter) are computed
+    const ReflectionCandidates *candidates = m_reflection_candidates.value(emitter, nullptr);
+    const int rcv_index = (candidates != nullptr ? m_receivers_grid.indexOf(receiver) : -1);
 
-    // Add this ray path to his receiver
-    receiver->addRayPath(rp);
+    if (rcv_index >= 0) {
+        const int *nodes = candidates->nodes(rcv_index);
 
-    // If the level of recursion is under the max number of reflections
-    if (level < simulationData()->maxReflectionsCount())
-    {
-        // Compute the reflection from the 'reflect_wall' to all other walls of the scene
-        foreach (Wall *w, m_wall_list)
-        {
-            // We don't have to compute any reflection from the 'reflect_wall' to itself
-            if (w == reflect_wall) {
-                continue;
+        for (int k = 0 ; k < candidates->count(rcv_index) ; k++) {
+            images.clear();
+            walls.clear();
+
+            // Images and walls of the parents of this node
+            for (int i = nodes[k] ; i >= 0 ; i = tree->getNode(i).parent) {
+                images.prepend(tree->getNode(i).image);
+                walls.prepend(tree->getNodeWall(i));
             }
 
-            // Recursive call for each wall of the scene (and increase the recusion level)
-            recursiveReflection(emitter, receiver, w, images, walls, level+1);
+            // Compute the complete ray path for this set of reflections
+            // (added to the buffer if valid)
+            computeRayPath(emitter, receiver, buffer, images, walls);
         }
+
+        return;
+    }
+
+    const QPointF rcv_pos = receiver->getRealPos();
+
+    // The nodes are stored in depth-first order
+    for (int i = 0 ; i < tree->size() ; i++) {
+        const ImageNode &node = tree->getNode(i);
+
+        // Keep only the reflections of the parents of this node
+        while (images.size() >= node.level) {
+            images.removeLast();
+            walls.removeLast();
+        }
+
+        images.append(node.image);
+        walls.append(tree->getNodeWall(i));
+
+        // The last reflection can't be on its wall if the receiver is not in this region
+        if (!tree->isInValidityRegion(i, rcv_pos)) {
+            continue;
+        }
+
+        // Compute the complete ray path for this set of reflections
+        // (added to the buffer if valid)
+        computeRayPath(emitter, receiver, buffer, images, walls);
     }
 }
 
 
 /**
- * @brief SimulationHandler::computeDiffractedRay
+ * @brief SimulationHandler::prepareDiffractionCorner
  * @param e
- * @param r
  * @param c
+ * @param dc
+ * @return
  *
- * This function computes the diffracted ray from an emitter to a receiver via the corner c.
+ * This function computes the part of the diffraction via the corner c that only depends
+ * on the emitter e (the ray from the corner to the emitter and the adjacent walls).
+ * It returns false if no ray of this emitter can be diffracted by the corner:
+ * the angle of the ray with its adjacent wall is > 90°, or the ray intersects a wall.
  */
-void SimulationHandler::computeDiffractedRay(Emitter *e, Receiver *r, Corner *c) {
-    // If the target point is the same as the emitter point
-    //  -> not a physics situation -> invalid raypath
-    if (e->getRealPos() == r->getRealPos()) {
-        return;
-    }
-
-    // Create the rays from emitter/receiver to the corner
+bool SimulationHandler::prepareDiffractionCorner(Emitter *e, Corner *c, DiffractionCorner *dc) {
+    // Create the ray from the corner to the emitter
     QLineF ce_ray(c->getRealPos(), e->getRealPos());
-    QLineF cr_ray(c->getRealPos(), r->getRealPos());
 
     // Create measurement lines from adjacent walls ends to the emitter
     QLineF measur_line1(e->getRealPos(), c->getRealEndPoints().at(0));
@@ -463,27 +601,101 @@ void SimulationHandler::computeDiffractedRay(Emitter *e, Receiver *r, Corner *c)
         rv_adj = c->getAdjecentRealLines()[0];
     }
 
-    // Check if both angles of the rays with their adjacent wall is < 90° -> valid diffraction
+    // Angle of the ray with its adjacent wall, normalized to [0,180°]
     qreal em_angle = fabs(em_adj.angle() - ce_ray.angle());
-    qreal rv_angle = fabs(rv_adj.angle() - cr_ray.angle());
 
-    // Normalize the computed angles to [0,180°]
     if (em_angle > 180) {
         em_angle = 360 - em_angle;
     }
+
+    // Not a valid diffraction for any receiver
+    if (em_angle > 90) {
+        return false;
+    }
+
+    // Check if the ray from the emitter to the corner intersects a wall
+    if (checkIntersections(ce_ray, c->getAdjecentWalls().at(0), c->getAdjecentWalls().at(1))) {
+        return false;
+    }
+
+    dc->corner = c;
+    dc->ce_ray = ce_ray;
+    dc->rv_adj = rv_adj;
+    dc->em_angle = em_angle;
+
+    return true;
+}
+
+/**
+ * @brief SimulationHandler::diffractionCoefficient
+ * @param beta
+ * @param excess_length
+ * @return
+ *
+ * This function computes the diffraction coefficient F(ν) of the Knife-edge model,
+ * from the propagation constant and the excess length of the diffracted path
+ * over the LOS (Delta_r).
+ */
+complex SimulationHandler::diffractionCoefficient(double beta, double excess_length) {
+    // Negative Delta_r = numerical instabilities when (s1+s2) = d_los -> treated as a LOS ray
+    if (excess_length <= 0) {
+        return 1.0;
+    }
+
+    // Fresnel parameter (equation 3.57)
+    double nu = sqrt(2/M_PI * beta * excess_length);
+
+    // Compute the diffraction coefficient F(ν) (equations 3.58, 3.59)
+    double F_nu2_mod_dB = -6.9 - 20.0*log10(sqrt(pow((nu - 0.1), 2.0) + 1.0) + nu - 0.1);
+    double F_nu_mod = sqrt(pow(10.0, F_nu2_mod_dB/10.0));
+    double F_nu_arg = -M_PI_4 - M_PI_2 * pow(nu, 2.0);
+
+    return F_nu_mod * exp(1i*F_nu_arg);
+}
+
+/**
+ * @brief SimulationHandler::computeDiffractedRay
+ * @param e
+ * @param r
+ * @param dc
+ * @param buffer
+ *
+ * This function computes the diffracted ray from an emitter to a receiver via a corner
+ * (prepared for this emitter by prepareDiffractionCorner).
+ */
+void SimulationHandler::computeDiffractedRay(Emitter *e, Receiver *r, const DiffractionCorner &dc, RayPathBuffer *buffer) {
+    PROFILE_SCOPE(ProfileStage::DiffractedRay);
+    PROFILE_COUNT(ProfileCounter::DiffractionTested, 1);
+
+    Corner *c = dc.corner;
+
+    // If the target point is the same as the emitter point
+    //  -> not a physics situation -> invalid raypath
+    if (e->getRealPos() == r->getRealPos()) {
+        return;
+    }
+
+    // Create the rays from emitter/receiver to the corner
+    const QLineF &ce_ray = dc.ce_ray;
+    QLineF cr_ray(c->getRealPos(), r->getRealPos());
+
+    // Check if both angles of the rays with their adjacent wall is < 90° -> valid diffraction
+    qreal em_angle = dc.em_angle;
+    qreal rv_angle = fabs(dc.rv_adj.angle() - cr_ray.angle());
+
+    // Normalize the computed angle to [0,180°]
     if (rv_angle > 180) {
         rv_angle = 360 - rv_angle;
     }
 
     // Check if one of this angle is > 90° and the sum of both > 90° -> not a valid diffraction
-    if (em_angle > 90 || rv_angle > 90 || em_angle+rv_angle > 90) {
+    if (rv_angle > 90 || em_angle+rv_angle > 90) {
         return;
     }
 
-    // Check if the ray from the emitter/receiver to the corner intersects a wall
-    if (checkIntersections(ce_ray, c->getAdjecentWalls().at(0), c->getAdjecentWalls().at(1)) ||
-        checkIntersections(cr_ray, c->getAdjecentWalls().at(0), c->getAdjecentWalls().at(1)))
-    {
+    // Check if the ray from the receiver to the corner intersects a wall
+    // (the ray from the emitter was checked by prepareDiffractionCorner)
+    if (checkIntersections(cr_ray, c->getAdjecentWalls().at(0), c->getAdjecentWalls().at(1))) {
         // If the diffracted ray intersects a wall -> ignore it
         return;
     }
@@ -500,47 +712,43 @@ void SimulationHandler::computeDiffractedRay(Emitter *e, Receiver *r, Corner *c)
     double dn       = ce_ray.length() + cr_ray.length();
     double Delta_r  = dn - los_ray.length();
 
-    // Coefficients vector
-    vector<complex> coeff = {1, 1, 1};
-
-    // Negative Delta_r = numerical instabilities when (s1+s2) = d_los -> treated as a LOS ray
-    if (Delta_r > 0) {
-        // Fresnel parameter (equation 3.57)
-        double nu = sqrt(2/M_PI * beta * Delta_r);
-
-        // Compute the diffraction coefficient F(ν) (equations 3.58, 3.59)
-        double F_nu2_mod_dB = -6.9 - 20.0*log10(sqrt(pow((nu - 0.1), 2.0) + 1.0) + nu - 0.1);
-        double F_nu_mod = sqrt(pow(10.0, F_nu2_mod_dB/10.0));
-        double F_nu_arg = -M_PI_4 - M_PI_2 * pow(nu, 2.0);
-
-        // Complex diffraction coefficient F(ν)
-        complex F_nu = F_nu_mod * exp(1i*F_nu_arg);
-        coeff = {F_nu, F_nu, F_nu};
-
-        vector<complex> En = coeff * computeNominalElecField(e, ce_ray, cr_ray, dn);
-    }
+    // Complex diffraction coefficient F(ν)
+    complex F_nu = diffractionCoefficient(beta, Delta_r);
+    Vec3c coeff = {F_nu, F_nu, F_nu};
 
     // Compute the electric field in the 3 components
-    vector<complex> En = coeff * computeNominalElecField(e, ce_ray, cr_ray, dn);
-
-    // Create a list of the rays
-    QList<QLineF> rays = QList<QLineF>() << ce_ray << cr_ray;
-
-    // Add the new RayPath object to the receiver
-    RayPath *rp = new RayPath(e, r, rays, En, dn);
-    r->addRayPath(rp);
+    Vec3c En = coeff * computeNominalElecField(e, ce_ray, cr_ray, dn);
+
+    // Points of the ray path (from the receiver to the emitter)
+    const int first_vertex = buffer->beginPath();
+    buffer->addVertex(r->getRealPos());
+    buffer->addVertex(c->getRealPos());
+    buffer->addVertex(e->getRealPos());
+
+    // Add the ray path to the buffer of the receiver.
+    // The arrival angle is taken from the corner-emitter line, as in the previous
+    // ray paths objects (first line of the ray path).
+    RayRecord rec = makeRayRecord(e, En, dn, M_PI_2, ce_ray, ce_ray, RayType::Diffraction);
+    rec.excess_length = Delta_r;
+    buffer->endPath(rec, first_vertex);
+
+    PROFILE_COUNT(ProfileCounter::DiffractionAccepted, 1);
 }
 
 /**
  * @brief SimulationHandler::computeGroundReflection
  * @param e
  * @param r
+ * @param buffer
  *
  * This function computes the ray reflected off the ground.
  * This computation assumes the emitter and the receiver are both at the same height.
  * It is also assumed that this ray is computed only when LOS is free (no obstacle).
  */
-void SimulationHandler::computeGroundReflection(Emitter *e, Receiver *r) {
+void SimulationHandler::computeGroundReflection(Emitter *e, Receiver *r, RayPathBuffer *buffer) {
+    PROFILE_SCOPE(ProfileStage::GroundReflection);
+    PROFILE_COUNT(ProfileCounter::GroundTested, 1);
+
     // Get the LOS ray between emitter and receiver
     QLineF los_ray(e->getRealPos(), r->getRealPos());
 
@@ -569,21 +777,25 @@ void SimulationHandler::computeGroundReflection(Emitter *e, Receiver *r) {
                                (cos(theta_i) + 1/sqrt(e_r) * sqrt(1 - 1/e_r * pow(sin(theta_i), 2)));
 
     // Return as a 3-D vector
-    vector<complex> refl_coef {
+    Vec3c refl_coef {
         Gamma_orth,
         Gamma_orth,
         Gamma_para
     };
 
     // The multiplication is made component by component (not a cross product).
-    vector<complex> En = refl_coef * computeNominalElecField(e, los_ray, los_ray, dn, theta_er);
+    Vec3c En = refl_coef * computeNominalElecField(e, los_ray, los_ray, dn, theta_er);
 
-    // Rays list
-    QList<QLineF> rays = QList<QLineF>() << los_ray;
+    // Points of the ray path (from the receiver to the emitter)
+    const int first_vertex = buffer->beginPath();
+    buffer->addVertex(r->getRealPos());
+    buffer->addVertex(e->getRealPos());
 
-    // Add the new RayPath object to the receiver
-    RayPath *rp = new RayPath(e, r, rays, En, dn, theta_er, true);
-    r->addRayPath(rp);
+    // Add the ray path to the buffer of the receiver
+    RayRecord rec = makeRayRecord(e, En, dn, theta_er, los_ray, los_ray, RayType::Ground);
+    buffer->endPath(rec, first_vertex);
+
+    PROFILE_COUNT(ProfileCounter::GroundAccepted, 1);
 }
 
 
@@ -591,180 +803,411 @@ void SimulationHandler::computeGroundReflection(Emitter *e, Receiver *r) {
 // ---------------------------- SIMULATION MANAGEMENT FUNCTIONS --------------------------------- //
 /**************************************************************************************************/
 
+/**
+ * @brief SimulationHandler::buildImageTrees
+ * @param emitters
+ *
+ * This function (re)computes the image trees of the given emitters.
+ * These trees don't depend on the receivers, they are shared by all computation units.
+ * The trees of the other emitters are kept for the next incremental updates.
+ */
+void SimulationHandler::buildImageTrees(const QList<Emitter*> &emitters) {
+    foreach (Emitter *e, emitters) {
+        // Delete the previous tree of this emitter (if one)
+        deleteImageTree(e);
+
+        // No image to compute if reflections are disabled
+        if (simulationData()->maxReflectionsCount() <= 0)
+            continue;
+
+        ImageTree *tree = new ImageTree(
+                    e->getRealPos(),
+                    m_wall_list,
+                    simulationData()->maxReflectionsCount());
+
+        m_image_trees.insert(e, tree);
+    }
+}
+
+/**
+ * @brief SimulationHandler::buildVisibleCorners
+ * @param emitters
+ *
+ * This function (re)computes the corners that can diffract the rays of the given emitters
+ * (see prepareDiffractionCorner). The emitter side of the diffractions is computed once,
+ * so the receivers only check the corners visible from the emitter.
+ */
+void SimulationHandler::buildVisibleCorners(const QList<Emitter*> &emitters) {
+    foreach (Emitter *e, emitters) {
+        QVector<DiffractionCorner> visible;
+
+        foreach (Corner *c, m_corners_list) {
+            DiffractionCorner dc;
+
+            if (prepareDiffractionCorner(e, c, &dc)) {
+                visible.append(dc);
+            }
+        }
+
+        m_visible_corners.insert(e, visible);
+    }
+}
+
+void SimulationHandler::deleteImageTree(Emitter *e) {
+    delete m_reflection_candidates.take(e);
+    delete m_image_trees.take(e);
+}
+
+/**
+ * @brief SimulationHandler::deleteImageTrees
+ *
+ * This function deletes the image trees of the emitters
+ */
+void SimulationHandler::deleteImageTrees() {
+    deleteReflectionCandidates();
+
+    foreach (ImageTree *tree, m_image_trees) {
+        delete tree;
+    }
+
+    m_image_trees.clear();
+}
+
+/**
+ * @brief SimulationHandler::buildReflectionCandidates
+ * @param emitters
+ *
+ * This function prepares the reciprocity mode for a run: the reflections are traced
+ * from the few emitters instead of the many receivers. The validity region of each node
+ * of the image trees is rasterized on a grid of the receivers, so all the receivers of
+ * a region are found at once (see ReceiversGrid). The receivers then only compute the
+ * ray paths of their nodes, which are the ones computeReflectedRays would compute.
+ * Nothing is done if the reciprocity mode is disabled.
+ */
+void SimulationHandler::buildReflectionCandidates(const QList<Emitter*> &emitters) {
+    deleteReflectionCandidates();
+
+    if (!m_reciprocity || m_receivers_list.isEmpty())
+        return;
+
+    PROFILE_SCOPE(ProfileStage::ReflectionCandidates);
+
+    m_receivers_grid.build(m_receivers_list);
+
+    foreach (Emitter *e, emitters) {
+        const ImageTree *tree = m_image_trees.value(e, nullptr);
+
+        if (tree == nullptr)
+            continue;
+
+        // The receivers farther than the pruning radius are not computed
+        m_reflection_candidates.insert(
+                    e,
+                    new ReflectionCandidates(tree, &m_receivers_grid, simulationData()->getPruningRadius()));
+    }
+}
+
+/**
+ * @brief SimulationHandler::deleteReflectionCandidates
+ *
+ * This function deletes the data of the reciprocity mode (only used during a run).
+ * The receivers then test all the nodes of the image trees.
+ */
+void SimulationHandler::deleteReflectionCandidates() {
+    foreach (ReflectionCandidates *candidates, m_reflection_candidates) {
+        delete candidates;
+    }
+
+    m_reflection_candidates.clear();
+    m_receivers_grid.clear();
+}
+
+/**
+ * @brief SimulationHandler::estimateReceiverCost
+ * @param r
+ * @return
+ *
+ * This function returns an estimation of the computation cost of a receiver.
+ * The cost is about the number of ray paths to test: the receivers that are out of
+ * the pruning radius are cheap, the ones close to an emitter are out of model.
+ */
+double SimulationHandler::estimateReceiverCost(Receiver *r) {
+    double cost = RECEIVER_BASE_COST;
+
+    // Nothing to compute for an out of model receiver
+    if (r->outOfModel())
+        return cost;
+
+    foreach (Emitter *e, m_emitters_list) {
+        // Contribution already computed (incremental update)
+        if (!needsComputation(e, r))
+            continue;
+
+        const double bs_dist = QLineF(e->getRealPos(), r->getRealPos()).length();
+
+        // Out of model receiver (no computation for the next emitters)
+        if (bs_dist < simulationData()->getMinimumValidRadius())
+            break;
+
+        // Pruned receiver (not computed for this emitter)
+        if (bs_dist > simulationData()->getPruningRadius())
+            continue;
+
+        // LOS, ground, reflections (from the image tree) and diffractions
+        const ImageTree *tree = m_image_trees.value(e, nullptr);
+        const ReflectionCandidates *candidates = m_reflection_candidates.value(e, nullptr);
+        const int rcv_index = (candidates != nullptr ? m_receivers_grid.indexOf(r) : -1);
+
+        double reflections = (tree != nullptr ? tree->size() : 0);
+
+        // Only the nodes found from the emitter are computed (reciprocity mode)
+        if (rcv_index >= 0) {
+            reflections = candidates->count(rcv_index);
+        }
+
+        // Only the corners visible from the emitter are checked (if they were prepared)
+        QHash<Emitter*,QVector<DiffractionCorner>>::const_iterator visible = m_visible_corners.constFind(e);
+        const int diffractions = (visible != m_visible_corners.constEnd() ? visible.value().size() : m_corners_list.size());
+
+        cost += 2.0 + reflections + diffractions;
+    }
+
+    return cost;
+}
+
 /**
  * @brief SimulationHandler::computeAllRays
  *
  * This function computes the rays from every emitters to every receivers.
- * This is an asynchronous function that adds computation units to the thread pool.
+ * This is an asynchronous function that adds one computation unit per thread to the thread pool.
+ * The receivers are split into chunks of about the same estimated cost, and the units
+ * steal the chunks of the others when they have no more work (see WorkScheduler).
  */
 void SimulationHandler::computeAllRays() {
     // Start the time counter
     m_computation_timer.start();
 
-    // Loop over all receivers
-    for (int i = 0 ; i < m_receivers_list.size() ; ) {
-        QList<Receiver*> rcv_sublist;
+    // Estimate the cost of each receiver
+    QVector<double> costs;
+    costs.reserve(m_receivers_list.size());
 
-        // Create a sublist of max. AREA_PER_THREAD receivers
-        for (int j = 0 ; j < AREA_PER_THREAD && i < m_receivers_list.size() ; j++, i++) {
-            rcv_sublist.append(m_receivers_list.at(i));
-        }
+    foreach (Receiver *r, m_receivers_list) {
+        costs.append(estimateReceiverCost(r));
+    }
 
-        // Create a threaded computation unit to compute the rays to this list if receivers
-        receiverRaysThreaded(rcv_sublist);
+    // No need of more units than receivers
+    const int units_count = max(1, min(m_threadpool.maxThreadCount(), m_receivers_list.size()));
+
+    m_scheduler.setup(m_receivers_list, costs, units_count);
+
+    // The arenas of the units are kept until the computed data is reset
+    while (m_units_arenas.size() < units_count) {
+        m_units_arenas.append(new RayPathArena());
+    }
+
+    // Create the computation units
+    for (int i = 0 ; i < units_count ; i++) {
+        ComputationUnit *cu = new ComputationUnit(this, &m_scheduler, i, m_units_arenas[i]);
+
+        // Connect the computation unit to the simulation handler
+        connect(cu, SIGNAL(computationProgress()), this, SLOT(computationUnitProgress()));
+        connect(cu, SIGNAL(computationFinished()), this, SLOT(computationUnitFinished()));
+
+        m_computation_units.append(cu);
+    }
+
+    // Add the computation units to the queue of the thread pool
+    foreach (ComputationUnit *cu, m_computation_units) {
+        m_threadpool.start(cu);
     }
 }
 
 /**
  * @brief SimulationHandler::computeReceiverRays
  * @param r
+ * @param buffer
+ * @param arena
  *
- * This function computes all the rays arriving at the receiver r
+ * This function computes all the rays arriving at the receiver r.
+ * The ray paths are accumulated in the buffer (owned by the calling thread),
+ * and merged into the receiver at once at the end (stored in the arena).
  */
-void SimulationHandler::computeReceiverRays(Receiver *r) {
+void SimulationHandler::computeReceiverRays(Receiver *r, RayPathBuffer *buffer, RayPathArena *arena) {
+    buffer->clear();
+
     // No need to compute more if this receiver is already out of model
-    if (r->outOfModel())
+    if (r->outOfModel()) {
+        r->addRayPaths(*buffer, arena);
         return;
+    }
 
     // Loop over the emitters
     foreach(Emitter *e, m_emitters_list)
-    {        
-        // Compute the straight line distance to the base station
-        double bs_dist = QLineF(e->getRealPos(), r->getRealPos()).length();
-
-        // Set this receiver as Out of Model
-        if (bs_dist < simulationData()->getMinimumValidRadius()) {
-            r->setOutOfModel(true, e);
-            break;  // No need to compute it for other emitters
-        }
-
-        // Ignore this receiver if the distance to the base station is lower than pruning threshold
-        if (bs_dist > simulationData()->getPruningRadius()) {
+    {
+        // Keep the contribution of this emitter if already computed (incremental update)
+        if (!needsComputation(e, r))
             continue;
-        }
 
-        // Compute the direct ray path
-        RayPath *LOS = computeRayPath(e, r);
+        // Compute the ray paths of this emitter
+        if (!computeEmitterRays(e, r, buffer))
+            break;  // Out of model: no need to compute it for other emitters
+    }
 
-        // Add it to his receiver
-        r->addRayPath(LOS);
+    // Merge the ray paths into the receiver (only written once per computation)
+    r->addRayPaths(*buffer, arena);
+}
 
-        // Compute reflection off the ground only if LOS (else it will cross a wall)
-        if (LOS != nullptr && simulationData()->maxReflectionsCount() > 0) {
-            computeGroundReflection(e, r);
-        }
+/**
+ * @brief SimulationHandler::computeEmitterRays
+ * @param e
+ * @param r
+ * @param buffer
+ * @return
+ *
+ * This function computes the rays from the emitter e arriving at the receiver r
+ * (added to the buffer). It returns false if the receiver is out of model because
+ * of this emitter (the oom_emitter of the buffer is set).
+ */
+bool SimulationHandler::computeEmitterRays(Emitter *e, Receiver *r, RayPathBuffer *buffer) {
+    // Compute the straight line distance to the base station
+    double bs_dist = QLineF(e->getRealPos(), r->getRealPos()).length();
+
+    // Set this receiver as Out of Model
+    if (bs_dist < simulationData()->getMinimumValidRadius()) {
+        buffer->oom_emitter = e;
+        return false;
+    }
 
-        // Compute reflections only if LOS (or if NLOS reflection forced by settings)
-        if (LOS != nullptr || simulationData()->reflectionEnabledNLOS())
-        {
-            // For each wall in the scene, compute the reflections recursively
-            foreach(Wall *w, m_wall_list)
-            {
-                // Don't compute any reflection if not needed
-                if (simulationData()->maxReflectionsCount() > 0) {
-                    // Compute the ray paths recursively (in a thread)
-                    recursiveReflection(e, r, w);
-                }
+    // Ignore this receiver if the distance to the base station is lower than pruning threshold
+    if (bs_dist > simulationData()->getPruningRadius()) {
+        return true;
+    }
+
+    // Compute the direct ray path (added to the buffer if valid)
+    bool LOS = computeRayPath(e, r, buffer);
+
+    // Compute reflection off the ground only if LOS (else it will cross a wall)
+    if (LOS && simulationData()->maxReflectionsCount() > 0) {
+        computeGroundReflection(e, r, buffer);
+    }
+
+    // Compute reflections only if LOS (or if NLOS reflection forced by settings)
+    if (LOS || simulationData()->reflectionEnabledNLOS())
+    {
+        // Compute the ray paths from the image tree of this emitter
+        computeReflectedRays(e, r, buffer);
+    }
+
+    // Compute diffraction only if no LOS
+    if (!LOS) {
+        QHash<Emitter*,QVector<DiffractionCorner>>::const_iterator visible = m_visible_corners.constFind(e);
+
+        if (visible != m_visible_corners.constEnd()) {
+            // For each corner that can diffract the rays of this emitter
+            foreach (const DiffractionCorner &dc, visible.value()) {
+                computeDiffractedRay(e, r, dc, buffer);
             }
         }
-
-        // Compute diffraction only if no LOS
-        if (LOS == nullptr) {
-            // For each corner of the scene
+        else {
+            // For each corner of the scene (corners not prepared for this emitter)
             foreach(Corner *c, m_corners_list) {
-                computeDiffractedRay(e, r, c);
+                DiffractionCorner dc;
+
+                if (prepareDiffractionCorner(e, c, &dc)) {
+                    computeDiffractedRay(e, r, dc, buffer);
+                }
             }
         }
     }
+
+    return true;
 }
 
 /**
- * @brief SimulationHandler::receiverRaysThreaded
+ * @brief SimulationHandler::needsComputation
+ * @param e
  * @param r
+ * @return
  *
- * This function creates a computation unit to compute the rays
- * to the receiver r in a thread.
+ * Returns true if the contribution of the emitter e to the receiver r must be computed
+ * during the current run. An incremental update only computes the updated emitters,
+ * except for the receivers that were reset (they need all the emitters).
  */
-void SimulationHandler::receiverRaysThreaded(QList<Receiver*> r_lst) {
-    // Create a computation unit for the recursive computation of the reflections
-    ComputationUnit *cu = new ComputationUnit(this, r_lst);
-
-    // Connect the computation unit to the simulation handler
-    connect(cu, SIGNAL(computationFinished()), this, SLOT(computationUnitFinished()));
-
-    // Lock this section
-    m_mutex.lock();
+bool SimulationHandler::needsComputation(Emitter *e, Receiver *r) const {
+    return !m_incremental || m_updated_emitters.contains(e) || m_reset_receivers.contains(r);
+}
 
-    // Add this CU to the list
-    m_computation_units.append(cu);
+/**
+ * @brief SimulationHandler::computationUnitProgress
+ *
+ * This slot is called when a computation unit finished a chunk of receivers
+ */
+void SimulationHandler::computationUnitProgress() {
+    if (m_scheduler.receiversCount() == 0)
+        return;
 
-    // Add this computation unit to the queue of the thread pool
-    m_threadpool.start(cu);
+    // Sum the counters of the units (no lock needed)
+    int computed = 0;
 
-    // Unlock this section
-    m_mutex.unlock();
+    foreach (ComputationUnit *cu, m_computation_units) {
+        computed += cu->computedReceivers();
+    }
 
-    // Increase the computation units counter
-    m_init_cu_count++;
+    emit simulationProgress((double) computed / (double) m_scheduler.receiversCount());
 }
 
 /**
  * @brief SimulationHandler::computationUnitFinished
  *
- * This slot is called when a computation unit finished to compute
+ * This slot is called when a computation unit has no more receivers to compute
+ * (or when there is no unit to run)
  */
 void SimulationHandler::computationUnitFinished() {
-    // Get the computation unit (origin of the signal)
-    ComputationUnit *cu = qobject_cast<ComputationUnit*> (sender());
+    // Wait for the end of all the computation units
+    if (++m_finished_cu_count < m_computation_units.size())
+        return;
 
-    // Lock this whole slot
-    m_mutex.lock();
+    // The last signal may be received before the end of the run() of its unit
+    m_threadpool.waitForDone();
 
-    // If a computation unit is the origin of the call to this function
-    if (cu != nullptr) {
-        // One thread can write in this list at a time (mutex)
-        m_computation_units.removeAll(cu);
+    // All the threads are done, the profiling data of the run can be read
+    PROFILE_END_RUN();
 
-        // Delete this computation unit
+    foreach (ComputationUnit *cu, m_computation_units) {
         delete cu;
     }
 
-    // Compute the progression and send the progression signal
-    double progress = 1.0 - (double) m_computation_units.size() / (double) m_init_cu_count;
-    emit simulationProgress(progress);
+    m_computation_units.clear();
+    m_scheduler.clear();
 
-    // All computations done
-    if (m_computation_units.size() == 0) {
-        // Mark the simulation as stopped
-        m_sim_started = false;
+    // The reflections of the receivers were computed
+    deleteReflectionCandidates();
 
-        if (!m_sim_cancelling) {
-            qDebug() << "Time (ms):" << m_computation_timer.nsecsElapsed() / 1e6;
-            qDebug() << "Count:" << getRayPathsList().size();
-            qDebug() << "Receivers:" << m_receivers_list.size();
-            qDebug() << "Walls:" << m_wall_list.size();
-            qDebug() << "Corners:" << m_corners_list.size();
+    // Mark the simulation as stopped
+    m_sim_started = false;
 
-            // Set simulation done flag
-            m_sim_done = true;
+    if (!isCancelling()) {
+        qDebug() << "Time (ms):" << m_computation_timer.nsecsElapsed() / 1e6;
+        qDebug() << "Count:" << getRayPathsCount();
+        qDebug() << "Receivers:" << m_receivers_list.size();
+        qDebug() << "Walls:" << m_wall_list.size();
+        qDebug() << "Corners:" << m_corners_list.size();
 
-            // Emit the simulation finished signal
-            emit simulationFinished();
-        }
-        else {
-            // If this is the lastest cancelling thread
-            if (m_threadpool.activeThreadCount() <= 1) {
-                // Reset the cancelling flag
-                m_sim_cancelling = false;
+        emit simulationProgress(1.0);
 
-                // Emit the simulation cancelled signal
-                emit simulationCancelled();
-            }
-        }
+        // Set simulation done flag
+        m_sim_done = true;
+
+        // Emit the simulation finished signal
+        emit simulationFinished();
     }
+    else {
+        // Reset the cancelling flag
+        m_sim_cancelling = 0;
 
-    // Unlock
-    m_mutex.unlock();
+        // Emit the simulation cancelled signal
+        emit simulationCancelled();
+    }
 }
 
 /**
@@ -791,9 +1234,6 @@ void SimulationHandler::startSimulationComputation(
         resetComputedData();
     }
 
-    // Reset simulation done flag
-    m_sim_done = false;
-
     // Setup the receivers list
     m_receivers_list = rcv_list;
 
@@ -805,30 +1245,213 @@ void SimulationHandler::startSimulationComputation(
         m_emitters_list = emit_list;
     }
 
-    // Setup the simulation area
-    m_sim_area = sim_area;
+    // All the emitters of the list are computed for all the receivers
+    m_incremental = false;
+    m_updated_emitters.clear();
+    m_reset_receivers.clear();
 
+    // Keep the list of all the emitters with computed contributions
+    foreach (Emitter *e, m_emitters_list) {
+        if (!m_computed_emitters.contains(e)) {
+            m_computed_emitters.append(e);
+        }
+    }
 
-    qDebug() << m_sim_area;
+    // Start the profiling of this run (if compiled)
+    PROFILE_BEGIN_RUN();
 
-    // Create the walls list from the buildings list
-    m_wall_list = simulationData()->makeBuildingWallsFiltered(m_sim_area);
+    {
+        PROFILE_SCOPE(ProfileStage::Setup);
 
-    // Create the corners list from the walls list
-    m_corners_list = simulationData()->makeWallsCorners(m_wall_list);
+        // The walls are kept between the runs of a same simulation (same buildings and area)
+        updateSceneGeometry(sim_area);
+
+        // Compute the images of the emitters and the corners they can see (shared by all receivers)
+        buildImageTrees(m_emitters_list);
+        buildVisibleCorners(m_emitters_list);
+
+        // Find the reflections of all the receivers from the emitters (reciprocity mode)
+        buildReflectionCandidates(m_emitters_list);
+    }
+
+    startComputation();
+}
+
+/**
+ * @brief SimulationHandler::updateEmitter
+ * @param e
+ *
+ * This function updates the results of the last simulation after the emitter e was
+ * moved or added (or its properties changed).
+ * Only the contributions of this emitter are computed again: the contributions
+ * of the other emitters to the receivers are kept.
+ */
+void SimulationHandler::updateEmitter(Emitter *e) {
+    // Only update a done simulation
+    if (isRunning() || !isDone())
+        return;
+
+    PROFILE_BEGIN_RUN();
+
+    // Only this emitter is computed, for all the receivers of the last simulation
+    m_incremental = true;
+    m_updated_emitters.clear();
+    m_updated_emitters.insert(e);
+
+    discardEmitterContributions(e);
+
+    if (!m_computed_emitters.contains(e)) {
+        m_computed_emitters.append(e);
+    }
+
+    m_emitters_list = m_computed_emitters;
+
+    {
+        PROFILE_SCOPE(ProfileStage::Setup);
+
+        // The images and the visible corners depend on the position of the emitter
+        buildImageTrees(QList<Emitter*>() << e);
+        buildVisibleCorners(QList<Emitter*>() << e);
+
+        // The reset receivers compute the other emitters without the reciprocity mode
+        buildReflectionCandidates(QList<Emitter*>() << e);
+    }
+
+    startComputation();
+}
+
+/**
+ * @brief SimulationHandler::removeEmitter
+ * @param e
+ *
+ * This function removes the contributions of the emitter e from the results of the
+ * last simulation (the emitter can then be deleted).
+ * This is a synchronous function: only the receivers that were out of model because
+ * of this emitter must be computed again, and they are close to it (so only a few).
+ */
+void SimulationHandler::removeEmitter(Emitter *e) {
+    if (isRunning())
+        return;
+
+    m_computed_emitters.removeAll(e);
+    m_emitters_list = m_computed_emitters;
+    deleteImageTree(e);
+    m_visible_corners.remove(e);
+
+    m_incremental = true;
+    m_updated_emitters.clear();
+
+    discardEmitterContributions(e);
+
+    RayPathBuffer buffer;
+
+    foreach (Receiver *r, m_reset_receivers) {
+        computeReceiverRays(r, &buffer, &m_main_arena);
+    }
+
+    m_reset_receivers.clear();
+}
+
+/**
+ * @brief SimulationHandler::evaluateFrequencySweep
+ *
+ * This function computes again the results of the receivers of the last simulation
+ * (after a change of the frequency sweep). The ray paths are not traced again: the
+ * stored ones are only evaluated at the new frequencies.
+ */
+void SimulationHandler::evaluateFrequencySweep() {
+    if (isRunning() || !isDone())
+        return;
+
+    foreach (Receiver *r, m_receivers_list) {
+        r->finalize();
+    }
+}
+
+/**
+ * @brief SimulationHandler::discardEmitterContributions
+ * @param e
+ *
+ * This function removes the ray paths of the emitter e from the receivers.
+ * A receiver that was out of model because of this emitter didn't compute the
+ * other emitters, so it is reset and marked to be computed again (m_reset_receivers).
+ */
+void SimulationHandler::discardEmitterContributions(Emitter *e) {
+    m_reset_receivers.clear();
+
+    // Size of the ray paths kept by the receivers
+    qint64 kept_bytes = 0;
+
+    foreach (Receiver *r, m_receivers_list) {
+        const qint64 bytes = r->rayPathsBytes();
+
+        if (r->outOfModel() && r->outOfModelEmitter() == e) {
+            r->reset();
+            m_reset_receivers.insert(r);
+        }
+        else {
+            r->discardEmitter(e);
+        }
+
+        kept_bytes += r->rayPathsBytes();
+        m_discarded_bytes += bytes - r->rayPathsBytes();
+    }
+
+    // The discarded ray paths are only freed with their arena: the arenas are compacted
+    // when they are more than half unused (this bounds the memory of the incremental
+    // updates, for a copy cost proportional to the discarded bytes)
+    if (m_discarded_bytes > kept_bytes) {
+        compactRayPathArenas();
+    }
+}
+
+/**
+ * @brief SimulationHandler::compactRayPathArenas
+ *
+ * This function moves the ray paths of all the receivers into a new arena, and
+ * frees the previous arenas (with the discarded ray paths they contain).
+ * It must not be called while the computation units are running.
+ */
+void SimulationHandler::compactRayPathArenas() {
+    RayPathArena compacted;
+    RayPathBuffer buffer;
+
+    foreach (Receiver *r, m_receivers_list) {
+        r->relocateRayPaths(&compacted, &buffer);
+    }
+
+    // The receivers don't use the previous blocks anymore
+    clearRayPathArenas();
+    m_main_arena.swap(compacted);
+}
+
+/**
+ * @brief SimulationHandler::startComputation
+ *
+ * This function starts the computation units of a run (the walls and
+ * the image trees must be ready)
+ */
+void SimulationHandler::startComputation() {
+    // Reset simulation done flag
+    m_sim_done = false;
 
     // Mark the simulation as running
     m_sim_started = true;
 
-    // Reset the counter of computation units
-    m_init_cu_count = 0;
+    // Reset the counter of finished computation units
+    m_finished_cu_count = 0;
 
     // Emit the simulation started signal
     emit simulationStarted();
     emit simulationProgress(0);
 
+    // The results of the receivers are not read until they are computed again
+    foreach (Receiver *r, m_receivers_list) {
+        r->invalidateResults();
+    }
+
     // Check if there are receivers to compute
-    if (rcv_list.size() > 0) {
+    if (m_receivers_list.size() > 0) {
         // Compute all rays
         computeAllRays();
     }
@@ -839,34 +1462,78 @@ void SimulationHandler::startSimulationComputation(
 }
 
 /**
- * @brief SimulationHandler::stopSimulationComputation
+ * @brief SimulationHandler::prepareEmittersCoverage
+ * @param sim_area
+ * @param emitters
  *
- * This function cancel the current simulation.
- * The cancel operation must wait for all threads to finish.
+ * This function prepares the coverage computation of the given emitters, each one
+ * alone (see isCoveredByEmitter). The emitters are not added to the simulation:
+ * only their images and the corners they can see are computed.
  */
-void SimulationHandler::stopSimulationComputation() {
-    // Lock this whole function to ensure thread management integrity
-    m_mutex.lock();
+void SimulationHandler::prepareEmittersCoverage(QRectF sim_area, const QList<Emitter*> &emitters) {
+    // The walls and images can't change during a simulation
+    if (isRunning())
+        return;
 
-    // Clear the queue of the thread pool
-    m_threadpool.clear();
+    PROFILE_SCOPE(ProfileStage::Setup);
 
-    // Mark the simulation as cancelling
-    m_sim_cancelling = true;
+    updateSceneGeometry(sim_area);
 
-    // Delete all CU that are not (yet) running
-    foreach(ComputationUnit *cu, m_computation_units) {
-        if (!cu->isRunning()) {
-            // Remove the CU from the list
-            m_computation_units.removeAll(cu);
+    buildImageTrees(emitters);
+    buildVisibleCorners(emitters);
+}
 
-            // Delete this CU
-            delete cu;
-        }
+/**
+ * @brief SimulationHandler::releaseEmittersCoverage
+ * @param emitters
+ *
+ * This function deletes the data prepared for the coverage of the emitters
+ */
+void SimulationHandler::releaseEmittersCoverage(const QList<Emitter*> &emitters) {
+    foreach (Emitter *e, emitters) {
+        deleteImageTree(e);
+        m_visible_corners.remove(e);
     }
+}
+
+/**
+ * @brief SimulationHandler::isCoveredByEmitter
+ * @param e
+ * @param r
+ * @param coverage_margin
+ * @param buffer
+ * @return
+ *
+ * This function returns true if the receiver r is covered by the emitter e alone
+ * (same test as Receiver::isCovered). The rays are computed in the buffer (owned by
+ * the calling thread), and the receiver is not modified: this function can be called
+ * from any thread, once the emitter is prepared (see prepareEmittersCoverage).
+ */
+bool SimulationHandler::isCoveredByEmitter(Emitter *e, Receiver *r, double coverage_margin, RayPathBuffer *buffer) {
+    buffer->clear();
 
-    // Lock access to the list
-    m_mutex.unlock();
+    // If the receiver is out of model -> consider coverage OK (we are in the near-field)
+    if (!computeEmitterRays(e, r, buffer))
+        return true;
+
+    return r->userEndSNR(*buffer) - coverage_margin >= simulationData()->getSimulationTargetSNR();
+}
+
+/**
+ * @brief SimulationHandler::stopSimulationComputation
+ *
+ * This function cancel the current simulation.
+ * The cancel operation must wait for all threads to finish.
+ */
+void SimulationHandler::stopSimulationComputation() {
+    // Ignore if no simulation is running
+    if (!isRunning())
+        return;
+
+    // Mark the simulation as cancelling.
+    // The computation units stop after their current receiver, and the
+    // last finished unit sends the cancelled signal.
+    m_sim_cancelling = 1;
 }
 
 /**
@@ -883,9 +1550,80 @@ void SimulationHandler::resetComputedData() {
         r->reset();
     }
 
-    // Clear the receivers list
+    // Clear the receivers and emitters lists
     m_receivers_list.clear();
+    m_emitters_list.clear();
+    m_computed_emitters.clear();
+    m_reset_receivers.clear();
+    m_updated_emitters.clear();
+
+    // Free all the ray paths at once (the receivers were reset)
+    clearRayPathArenas();
+
+    // Delete the walls, corners and images
+    deleteSceneGeometry();
+}
+
+/**
+ * @brief SimulationHandler::clearRayPathArenas
+ *
+ * This function frees the ray paths stored by the last simulation
+ * (no receiver must use them anymore)
+ */
+void SimulationHandler::clearRayPathArenas() {
+    foreach (RayPathArena *arena, m_units_arenas) {
+        arena->clear();
+    }
+
+    m_main_arena.clear();
+    m_discarded_bytes = 0;
+}
 
+/**
+ * @brief SimulationHandler::updateSceneGeometry
+ * @param sim_area
+ *
+ * This function builds the walls and corners of the simulation area
+ * (only if not built yet for this area)
+ */
+void SimulationHandler::updateSceneGeometry(QRectF sim_area) {
+    if (!m_wall_list.isEmpty() && sim_area == m_sim_area)
+        return;
+
+    // Setup the simulation area
+    m_sim_area = sim_area;
+
+    qDebug() << m_sim_area;
+
+    buildSceneGeometry();
+}
+
+/**
+ * @brief SimulationHandler::buildSceneGeometry
+ *
+ * This function creates the walls and corners of the buildings in the simulation area,
+ * and the walls grid used for the obstruction tests
+ */
+void SimulationHandler::buildSceneGeometry() {
+    // Delete the previous walls (and the image trees that refer to them)
+    deleteSceneGeometry();
+
+    // Create the walls list from the buildings list
+    m_wall_list = simulationData()->makeBuildingWallsFiltered(m_sim_area);
+
+    // Create the corners list from the walls list
+    m_corners_list = simulationData()->makeWallsCorners(m_wall_list);
+
+    // Build the walls grid used for the obstruction tests
+    m_walls_grid.build(m_wall_list);
+}
+
+/**
+ * @brief SimulationHandler::deleteSceneGeometry
+ *
+ * This function deletes the walls, corners and image trees of the simulation
+ */
+void SimulationHandler::deleteSceneGeometry() {
     // Delete all walls (created from buildings list)
     foreach(Wall *w, m_wall_list) {
         delete w;
@@ -894,6 +1632,15 @@ void SimulationHandler::resetComputedData() {
     // Clear the walls list
     m_wall_list.clear();
 
+    // Clear the walls grid (it refers to the deleted walls)
+    m_walls_grid.clear();
+
+    // Delete the image trees (they refer to the deleted walls)
+    deleteImageTrees();
+
+    // The visible corners refer to the deleted corners
+    m_visible_corners.clear();
+
     // Delete all corners (created from walls list)
     foreach(Corner *c, m_corners_list) {
         delete c;
@@ -3,6 +3,9 @@
 
 #include <QObject>
 #include <QElapsedTimer>
+#include <QAtomicInt>
+#include <QHash>
+#include <QSet>
 #include <QThreadPool>
 
 #include "simulationdata.h"
@@ -10,62 +13,101 @@
 #include "simulationscene.h"
 #include "constants.h"
 #include "raypath.h"
+#include "rayrecord.h"
+#include "raypatharena.h"
+#include "wallsgrid.h"
+#include "imagetree.h"
+#include "receiversgrid.h"
+#include "workscheduler.h"
 
 class ComputationUnit;
 
+// Corner that can diffract the rays of an emitter, with the values of the
+// diffraction that don't depend on the receiver (see SimulationHandler::buildVisibleCorners)
+struct DiffractionCorner {
+    Corner *corner;
+    QLineF ce_ray;      // Ray from the corner to the emitter
+    QLineF rv_adj;      // Wall adjacent to the receiver's ray
+    qreal em_angle;     // Angle of the emitter's ray with its adjacent wall (degrees, in [0,90])
+};
+
 class SimulationHandler : public QObject
 {
     Q_OBJECT
 public:
     SimulationHandler();
+    ~SimulationHandler();
 
     static SimulationData *simulationData();
 
     QList<RayPath*> getRayPathsList() const;
+    int getRayPathsCount() const;
+    int getWallsCount() const;
+    QList<Wall*> getWallsList() const;
+    int getCornersCount() const;
 
     bool isDone() const;
     bool isRunning() const;
     bool isCancelling() const;
 
+    bool reciprocityMode() const;
+    void setReciprocityMode(bool enabled);
+
     static QPointF mirror(const QPointF source, Wall *wall);
 
     bool checkIntersections(QLineF ray, Wall *origin_wall, Wall *target_wall);
-    vector<complex> reflectionCoefficient(Wall *w, QLineF in_ray);
+    Vec3c reflectionCoefficient(Wall *w, QLineF in_ray);
 
-    vector<complex> computeNominalElecField(
+    Vec3c computeNominalElecField(
             Emitter *em,
             QLineF emitter_ray,
             QLineF receiver_ray,
             double dn,
             double theta = M_PI_2);
 
-    RayPath *computeRayPath(
+    bool computeRayPath(
             Emitter *emitter,
             Receiver *receiver,
-            QList<QPointF> images = QList<QPointF>(),
-            QList<Wall*> walls = QList<Wall*>());
+            RayPathBuffer *buffer,
+            const QList<QPointF> &images = QList<QPointF>(),
+            const QList<Wall*> &walls = QList<Wall*>());
 
-    void recursiveReflection(
-            Emitter *emitter,
-            Receiver *receiver,
-            Wall *reflect_wall,
-            QList<QPointF> images = QList<QPointF>(),
-            QList<Wall*> walls = QList<Wall*>(),
-            int level = 1);
+    void computeReflectedRays(Emitter *emitter, Receiver *receiver, RayPathBuffer *buffer);
+
+    static complex diffractionCoefficient(double beta, double excess_length);
+
+    bool prepareDiffractionCorner(Emitter *e, Corner *c, DiffractionCorner *dc);
+    void computeDiffractedRay(Emitter *e, Receiver *r, const DiffractionCorner &dc, RayPathBuffer *buffer);
+    void computeGroundReflection(Emitter *e, Receiver *r, RayPathBuffer *buffer);
+
+    void buildImageTrees(const QList<Emitter*> &emitters);
+    void deleteImageTree(Emitter *e);
+    void deleteImageTrees();
+
+    void buildVisibleCorners(const QList<Emitter*> &emitters);
 
-    void computeDiffractedRay(Emitter *e, Receiver *r, Corner *c);
-    void computeGroundReflection(Emitter *e, Receiver *r);
+    void buildReflectionCandidates(const QList<Emitter*> &emitters);
+    void deleteReflectionCandidates();
+
+    double estimateReceiverCost(Receiver *r);
+    bool needsComputation(Emitter *e, Receiver *r) const;
 
     void computeAllRays();
-    void computeReceiverRays(Receiver *r);
+    void computeReceiverRays(Receiver *r, RayPathBuffer *buffer, RayPathArena *arena);
+    bool computeEmitterRays(Emitter *e, Receiver *r, RayPathBuffer *buffer);
 
-    void receiverRaysThreaded(QList<Receiver*> r_lst);
+    void prepareEmittersCoverage(QRectF sim_area, const QList<Emitter*> &emitters);
+    void releaseEmittersCoverage(const QList<Emitter*> &emitters);
+    bool isCoveredByEmitter(Emitter *e, Receiver *r, double coverage_margin, RayPathBuffer *buffer);
 
     void startSimulationComputation(
             QList<Receiver *> rcv_list,
             QRectF sim_area,
             bool reset = true,
             QList<Emitter*> emit_list = QList<Emitter*>());
+    void updateEmitter(Emitter *e);
+    void removeEmitter(Emitter *e);
+    void evaluateFrequencySweep();
     void stopSimulationComputation();
     void resetComputedData();
 
@@ -76,23 +118,59 @@ signals:
     void simulationProgress(double);
 
 private slots:
+    void computationUnitProgress();
     void computationUnitFinished();
 
 private:
+    void startComputation();
+    void discardEmitterContributions(Emitter *e);
+    void updateSceneGeometry(QRectF sim_area);
+    void buildSceneGeometry();
+    void deleteSceneGeometry();
+    void clearRayPathArenas();
+    void compactRayPathArenas();
+
     QList<Emitter*> m_emitters_list;
     QList<Receiver*> m_receivers_list;
     QList<Wall*> m_wall_list;
     QList<Corner*> m_corners_list;
 
+    WallsGrid m_walls_grid;
+    QHash<Emitter*,ImageTree*> m_image_trees;
+
+    // Corners that can diffract the rays of each emitter (computed once for all receivers)
+    QHash<Emitter*,QVector<DiffractionCorner>> m_visible_corners;
+
+    // Reciprocity mode: the reflections to compute for each receiver are found from
+    // the emitters (image trees) for all the receivers at once, before the run
+    bool m_reciprocity;
+    ReceiversGrid m_receivers_grid;
+    QHash<Emitter*,ReflectionCandidates*> m_reflection_candidates;
+
+    // Emitters whose contributions are stored in the receivers, and the emitters and
+    // receivers to compute during an incremental update
+    QList<Emitter*> m_computed_emitters;
+    QSet<Emitter*> m_updated_emitters;
+    QSet<Receiver*> m_reset_receivers;
+    bool m_incremental;
+
     QElapsedTimer m_computation_timer;
 
     QThreadPool m_threadpool;
-    QList<ComputationUnit*> m_computation_units;
-    QMutex m_mutex;
+    WorkScheduler m_scheduler;
+    QVector<ComputationUnit*> m_computation_units;
+
+    // Storage of the computed ray paths: one arena per computation unit, and one
+    // for the main thread (freed at once when the computed data is reset)
+    QVector<RayPathArena*> m_units_arenas;
+    RayPathArena m_main_arena;
+
+    // Size of the ray paths discarded by the incremental updates, still in the arenas
+    qint64 m_discarded_bytes;
 
-    int m_init_cu_count;
+    int m_finished_cu_count;
     bool m_sim_started;
-    bool m_sim_cancelling;
+    QAtomicInt m_sim_cancelling;
     bool m_sim_done;
 
     QRectF m_sim_area;
@@ -23,7 +23,9 @@ void SimulationItem::setPlacingMode(bool on) {
  * Returns the real position of the item (in meters)
  */
 QPointF SimulationItem::getRealPos() {
-    qreal scale = simulationScene()->simulationScale();
+    // The scale is static, so the item does not need to be in a scene
+    // (the receivers of a simulation area are not)
+    qreal scale = SimulationScene::simulationScale();
     return pos() / scale;
 }
 
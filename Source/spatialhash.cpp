@@ -0,0 +1,140 @@
+#include "spatialhash.h"
+#include "constants.h"
+
+#include <QLineF>
+#include <qnumeric.h>
+
+// Minimum size of the cells (the size is given in meters)
+#define MIN_CELL_SIZE   1e-3
+
+
+SpatialHash::SpatialHash(double cell_size)
+{
+    clear(cell_size);
+}
+
+/**
+ * @brief SpatialHash::clear
+ * @param cell_size
+ *
+ * This function removes all the points, and sets the size of the cells
+ */
+void SpatialHash::clear(double cell_size) {
+    m_cell_size = max(cell_size, MIN_CELL_SIZE);
+    m_cells.clear();
+    m_points.clear();
+}
+
+bool SpatialHash::isEmpty() const {
+    return m_points.isEmpty();
+}
+
+int SpatialHash::size() const {
+    return m_points.size();
+}
+
+/**
+ * @brief SpatialHash::insert
+ * @param p
+ * @return
+ *
+ * This function adds a point to the hash, and returns its index
+ */
+int SpatialHash::insert(const QPointF &p) {
+    const int index = m_points.size();
+
+    m_points.append(p);
+    m_cells[cellOf(p)].append(index);
+
+    return index;
+}
+
+const QPointF &SpatialHash::point(int index) const {
+    return m_points.at(index);
+}
+
+SpatialHash::Cell SpatialHash::cellOf(const QPointF &p) const {
+    return Cell((int) floor(p.x() / m_cell_size), (int) floor(p.y() / m_cell_size));
+}
+
+/**
+ * @brief SpatialHash::cellsRange
+ * @param center
+ * @param radius
+ * @param first
+ * @param last
+ * @return
+ *
+ * This function computes the range of cells that contains the disk of the given
+ * radius around the center. It returns false if the range is larger than the number
+ * of non-empty cells (all the points should be tested instead).
+ */
+bool SpatialHash::cellsRange(const QPointF &center, double radius, Cell *first, Cell *last) const {
+    if (!qIsFinite(radius))
+        return false;
+
+    const double cols = floor((center.x() + radius) / m_cell_size) - floor((center.x() - radius) / m_cell_size) + 1;
+    const double rows = floor((center.y() + radius) / m_cell_size) - floor((center.y() - radius) / m_cell_size) + 1;
+
+    if (cols * rows > m_cells.size())
+        return false;
+
+    *first = cellOf(center - QPointF(radius, radius));
+    *last = cellOf(center + QPointF(radius, radius));
+
+    return true;
+}
+
+/**
+ * @brief SpatialHash::findInRadius
+ * @param center
+ * @param radius
+ * @param indexes
+ *
+ * This function appends the index of all the points that are not farther than radius
+ * from the center (in no particular order)
+ */
+void SpatialHash::findInRadius(const QPointF &center, double radius, QVector<int> *indexes) const {
+    Cell first, last;
+
+    // Test all the points if the disk covers more cells than the non-empty ones
+    if (!cellsRange(center, radius, &first, &last)) {
+        for (int i = 0 ; i < m_points.size() ; i++) {
+            if (QLineF(center, m_points[i]).length() <= radius) {
+                indexes->append(i);
+            }
+        }
+
+        return;
+    }
+
+    for (int cx = first.first ; cx <= last.first ; cx++) {
+        for (int cy = first.second ; cy <= last.second ; cy++) {
+            QHash<Cell,QVector<int>>::const_iterator cell = m_cells.constFind(Cell(cx, cy));
+
+            if (cell == m_cells.constEnd())
+                continue;
+
+            foreach (int i, cell.value()) {
+                if (QLineF(center, m_points[i]).length() <= radius) {
+                    indexes->append(i);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief SpatialHash::containsInRadius
+ * @param center
+ * @param radius
+ * @return
+ *
+ * Returns true if a point is not farther than radius from the center
+ */
+bool SpatialHash::containsInRadius(const QPointF &center, double radius) const {
+    QVector<int> indexes;
+    findInRadius(center, radius, &indexes);
+
+    return !indexes.isEmpty();
+}
@@ -0,0 +1,37 @@
+#ifndef SPATIALHASH_H
+#define SPATIALHASH_H
+
+#include <QHash>
+#include <QPair>
+#include <QPointF>
+#include <QVector>
+
+// Hash of points by square cells (in meters), to find the points close to a position
+// without testing all of them. The points are identified by their insertion index.
+class SpatialHash
+{
+public:
+    SpatialHash(double cell_size = 1.0);
+
+    void clear(double cell_size);
+    bool isEmpty() const;
+    int size() const;
+
+    int insert(const QPointF &p);
+    const QPointF &point(int index) const;
+
+    void findInRadius(const QPointF &center, double radius, QVector<int> *indexes) const;
+    bool containsInRadius(const QPointF &center, double radius) const;
+
+private:
+    typedef QPair<int,int> Cell;
+
+    Cell cellOf(const QPointF &p) const;
+    bool cellsRange(const QPointF &center, double radius, Cell *first, Cell *last) const;
+
+    double m_cell_size;
+    QHash<Cell,QVector<int>> m_cells;
+    QVector<QPointF> m_points;
+};
+
+#endif // SPATIALHASH_H
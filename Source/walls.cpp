@@ -7,7 +7,7 @@
 
 
 Wall::Wall(QLineF line) {
-    m_line = line;
+    setLine(line);
 }
 
 QLineF Wall::getLine() {
@@ -16,6 +16,30 @@ QLineF Wall::getLine() {
 
 void Wall::setLine(QLineF line) {
     m_line = line;
+    updateRealGeometry();
+}
+
+/**
+ * @brief Wall::updateRealGeometry
+ *
+ * This function computes the geometry of the wall in meters, used by the ray-tracing.
+ * The simulation scale doesn't change, so it is only computed when the line is set.
+ */
+void Wall::updateRealGeometry() {
+    const qreal scale = SimulationScene::simulationScale();
+    m_real_line = QLineF(m_line.p1() / scale, m_line.p2() / scale);
+
+    const double length = m_real_line.length();
+
+    if (length > 0) {
+        m_direction = QPointF(m_real_line.dx() / length, m_real_line.dy() / length);
+    }
+    else {
+        m_direction = QPointF(0, 0);
+    }
+
+    m_normal = QPointF(-m_direction.y(), m_direction.x());
+    m_offset = m_normal.x() * m_real_line.x1() + m_normal.y() * m_real_line.y1();
 }
 
 /**
@@ -24,9 +48,38 @@ void Wall::setLine(QLineF line) {
  *
  * This function returns the real line of the wall (in meters)
  */
-QLineF Wall::getRealLine() const {
-    const qreal scale = SimulationScene::simulationScale();
-    return QLineF(m_line.p1() / scale, m_line.p2() / scale);
+const QLineF &Wall::getRealLine() const {
+    return m_real_line;
+}
+
+/**
+ * @brief Wall::getDirection
+ * @return
+ *
+ * Returns the unit vector of the wall, from the first to the second point of its line
+ */
+const QPointF &Wall::getDirection() const {
+    return m_direction;
+}
+
+/**
+ * @brief Wall::getNormal
+ * @return
+ *
+ * Returns the unit normal vector of the wall
+ */
+const QPointF &Wall::getNormal() const {
+    return m_normal;
+}
+
+/**
+ * @brief Wall::getLineOffset
+ * @return
+ *
+ * Returns the offset of the line equation of the wall: normal.p = offset (in meters)
+ */
+double Wall::getLineOffset() const {
+    return m_offset;
 }
 
 /**
@@ -38,14 +91,31 @@ QLineF Wall::getRealLine() const {
  * This angle is defined as 0 <= theta <= PI/2 (in radians)
  */
 double Wall::getNormalAngleTo(QLineF line) const {
-    double theta = fabs(M_PI_2 - m_line.angleTo(line) / 180.0 * M_PI);
+    const double length = line.length();
 
-    // If the angle is > PI/2 -> use the normal of the wall in the other direction
-    if(theta > M_PI_2) {
-       theta = fabs(theta - M_PI);
-    }
+    if (length == 0)
+        return 0;
+
+    // The sign of the cosine gives the side of the normal (the other side is the same angle)
+    const double cos_theta = fabs(m_normal.x() * line.dx() + m_normal.y() * line.dy()) / length;
+
+    return acos(min(cos_theta, 1.0));
+}
+
+/**
+ * @brief Wall::mirror
+ * @param source
+ * @return
+ *
+ * This function returns the image of the source point (in meters) after an axial
+ * symmetry through the line of the wall
+ */
+QPointF Wall::mirror(const QPointF &source) const {
+    // Signed distance of the source to the line of the wall
+    const double dist = m_normal.x() * source.x() + m_normal.y() * source.y() - m_offset;
 
-    return theta;
+    return QPointF(source.x() - 2.0 * dist * m_normal.x(),
+                   source.y() - 2.0 * dist * m_normal.y());
 }
 
 double Wall::getPermitivity() const {
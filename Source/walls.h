@@ -12,14 +12,28 @@ public:
     QLineF getLine();
     void setLine(QLineF line);
 
-    QLineF getRealLine() const;
+    const QLineF &getRealLine() const;
+    const QPointF &getDirection() const;
+    const QPointF &getNormal() const;
+    double getLineOffset() const;
+
     double getNormalAngleTo(QLineF line) const;
+    QPointF mirror(const QPointF &source) const;
 
     double getPermitivity() const;
 
 private:
+    void updateRealGeometry();
+
     QLineF m_line;
     double m_permitivity;
+
+    // Geometry of the wall in meters, computed when the line is set:
+    // unit direction (from p1 to p2), unit normal, and line equation normal.p = offset
+    QLineF m_real_line;
+    QPointF m_direction;
+    QPointF m_normal;
+    double m_offset;
 };
 
 #endif // WALL_H
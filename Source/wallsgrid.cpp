@@ -0,0 +1,324 @@
+#include "wallsgrid.h"
+#include "walls.h"
+#include "constants.h"
+#include "profiler.h"
+#include "segmentkernel.h"
+
+#include <qnumeric.h>
+
+// Minimum size of a grid cell
+#define GRID_MIN_CELL_SIZE  2.0     // Meters
+
+// Maximum number of cells in the grid
+#define GRID_MAX_CELLS      1000000
+
+// Margin added around the walls when placing them in the cells.
+// This ensures a wall lying on (or very close to) a cell boundary is placed
+// in all the neighbour cells, so the traversal never misses it.
+#define GRID_MARGIN         1e-6    // Meters
+
+
+WallsGrid::WallsGrid()
+{
+    clear();
+}
+
+/**
+ * @brief WallsGrid::clear
+ *
+ * This function removes all the walls from the grid
+ */
+void WallsGrid::clear() {
+    m_bounds = QRectF();
+    m_cell_size = GRID_MIN_CELL_SIZE;
+    m_cols = 0;
+    m_rows = 0;
+
+    m_cells_start.clear();
+    m_entries_wall.clear();
+    m_entries_x1.clear();
+    m_entries_y1.clear();
+    m_entries_bx.clear();
+    m_entries_by.clear();
+}
+
+bool WallsGrid::isEmpty() const {
+    return m_entries_wall.isEmpty();
+}
+
+/**
+ * @brief WallsGrid::build
+ * @param walls_list
+ *
+ * This function builds the grid over the given walls list.
+ * The size of the cells is chosen to have about one wall per cell.
+ */
+void WallsGrid::build(const QList<Wall*> &walls_list) {
+    clear();
+
+    if (walls_list.isEmpty())
+        return;
+
+    // Compute the bounding rect of all walls (in meters)
+    double min_x = qInf(), min_y = qInf();
+    double max_x = -qInf(), max_y = -qInf();
+
+    foreach (Wall *w, walls_list) {
+        const QLineF l = w->getRealLine();
+
+        min_x = min(min_x, min(l.x1(), l.x2()));
+        min_y = min(min_y, min(l.y1(), l.y2()));
+        max_x = max(max_x, max(l.x1(), l.x2()));
+        max_y = max(max_y, max(l.y1(), l.y2()));
+    }
+
+    m_bounds = QRectF(QPointF(min_x, min_y), QPointF(max_x, max_y))
+            .adjusted(-GRID_MARGIN, -GRID_MARGIN, GRID_MARGIN, GRID_MARGIN);
+
+    // About one wall per cell, but limit the total number of cells
+    m_cell_size = sqrt(m_bounds.width() * m_bounds.height() / walls_list.size());
+    m_cell_size = max(m_cell_size, GRID_MIN_CELL_SIZE);
+
+    while (ceil(m_bounds.width() / m_cell_size) * ceil(m_bounds.height() / m_cell_size) > GRID_MAX_CELLS) {
+        m_cell_size *= 2.0;
+    }
+
+    m_cols = max(1, (int) ceil(m_bounds.width()  / m_cell_size));
+    m_rows = max(1, (int) ceil(m_bounds.height() / m_cell_size));
+
+    // First pass: count the walls in each cell
+    QVector<int> cells_count(m_cols * m_rows, 0);
+
+    foreach (Wall *w, walls_list) {
+        const QLineF l = w->getRealLine();
+
+        const int cx1 = cellX(min(l.x1(), l.x2()) - GRID_MARGIN);
+        const int cx2 = cellX(max(l.x1(), l.x2()) + GRID_MARGIN);
+        const int cy1 = cellY(min(l.y1(), l.y2()) - GRID_MARGIN);
+        const int cy2 = cellY(max(l.y1(), l.y2()) + GRID_MARGIN);
+
+        for (int cy = cy1 ; cy <= cy2 ; cy++) {
+            for (int cx = cx1 ; cx <= cx2 ; cx++) {
+                cells_count[cy * m_cols + cx]++;
+            }
+        }
+    }
+
+    // Compute the start offset of each cell
+    m_cells_start.resize(m_cols * m_rows + 1);
+    m_cells_start[0] = 0;
+
+    for (int i = 0 ; i < cells_count.size() ; i++) {
+        m_cells_start[i+1] = m_cells_start[i] + cells_count[i];
+    }
+
+    // Second pass: fill the cells
+    const int entries_count = m_cells_start.last();
+
+    m_entries_wall.resize(entries_count);
+    m_entries_x1.resize(entries_count);
+    m_entries_y1.resize(entries_count);
+    m_entries_bx.resize(entries_count);
+    m_entries_by.resize(entries_count);
+
+    QVector<int> cells_fill = m_cells_start;
+
+    foreach (Wall *w, walls_list) {
+        const QLineF l = w->getRealLine();
+
+        const int cx1 = cellX(min(l.x1(), l.x2()) - GRID_MARGIN);
+        const int cx2 = cellX(max(l.x1(), l.x2()) + GRID_MARGIN);
+        const int cy1 = cellY(min(l.y1(), l.y2()) - GRID_MARGIN);
+        const int cy2 = cellY(max(l.y1(), l.y2()) + GRID_MARGIN);
+
+        for (int cy = cy1 ; cy <= cy2 ; cy++) {
+            for (int cx = cx1 ; cx <= cx2 ; cx++) {
+                const int entry = cells_fill[cy * m_cols + cx]++;
+
+                m_entries_wall[entry] = w;
+                m_entries_x1[entry] = l.x1();
+                m_entries_y1[entry] = l.y1();
+                m_entries_bx[entry] = l.x1() - l.x2();
+                m_entries_by[entry] = l.y1() - l.y2();
+            }
+        }
+    }
+}
+
+/**
+ * @brief WallsGrid::cellX
+ * @param x
+ * @return
+ *
+ * This function returns the column of the cell containing the abscissa x
+ * (bounded to the grid)
+ */
+int WallsGrid::cellX(double x) const {
+    const int cx = (int) floor((x - m_bounds.left()) / m_cell_size);
+    return qBound(0, cx, m_cols - 1);
+}
+
+/**
+ * @brief WallsGrid::cellY
+ * @param y
+ * @return
+ *
+ * This function returns the row of the cell containing the ordinate y
+ * (bounded to the grid)
+ */
+int WallsGrid::cellY(double y) const {
+    const int cy = (int) floor((y - m_bounds.top()) / m_cell_size);
+    return qBound(0, cy, m_rows - 1);
+}
+
+/**
+ * @brief WallsGrid::cellIntersects
+ *
+ * This function checks the ray against all the walls of one cell.
+ * The walls of the cell are tested in batch by the segment kernel (same
+ * results as QLineF::intersects()), with the values of the walls prepared
+ * when the grid is built.
+ */
+bool WallsGrid::cellIntersects(
+        int cx,
+        int cy,
+        const QLineF &ray,
+        const Wall *origin_wall,
+        const Wall *target_wall) const
+{
+    const int cell = cy * m_cols + cx;
+    const int end = m_cells_start[cell+1];
+
+    const WallsArrays walls = {
+        m_entries_x1.constData(),
+        m_entries_y1.constData(),
+        m_entries_bx.constData(),
+        m_entries_by.constData()
+    };
+
+    int from = m_cells_start[cell];
+
+    while (from < end) {
+        const int i = SegmentKernel::firstHit(ray, walls, from, end);
+
+        if (i < 0) {
+            PROFILE_COUNT(ProfileCounter::WallTests, end - from);
+            return false;
+        }
+
+        PROFILE_COUNT(ProfileCounter::WallTests, i - from + 1);
+
+        // Don't care about the origin or target wall (where this ray is reflected)
+        if (m_entries_wall[i] != origin_wall && m_entries_wall[i] != target_wall) {
+            return true;
+        }
+
+        from = i + 1;
+    }
+
+    return false;
+}
+
+/**
+ * @brief WallsGrid::intersects
+ *
+ * This function checks if the ray intersects a wall of the grid.
+ * Only the cells crossed by the ray are visited (grid traversal), and the walls
+ * of these cells are tested exactly as with a linear scan of all walls.
+ *
+ * @param ray         : The ray to check for clearance (in meters)
+ * @param origin_wall : The wall from which this ray come from (reflection), or nullptr
+ * @param target_wall : The wall to which this ray go to (reflection), or nullptr
+ * @return            : True if 'ray' intersects a wall of the grid
+ */
+bool WallsGrid::intersects(const QLineF &ray, const Wall *origin_wall, const Wall *target_wall) const {
+    if (isEmpty())
+        return false;
+
+    const double x0 = ray.x1();
+    const double y0 = ray.y1();
+    const double dx = ray.dx();
+    const double dy = ray.dy();
+
+    // Clip the ray to the bounds of the grid (Liang-Barsky)
+    double t_in = 0.0;
+    double t_out = 1.0;
+
+    const double p[4] = {-dx, dx, -dy, dy};
+    const double q[4] = {
+        x0 - m_bounds.left(),
+        m_bounds.right() - x0,
+        y0 - m_bounds.top(),
+        m_bounds.bottom() - y0
+    };
+
+    for (int i = 0 ; i < 4 ; i++) {
+        if (p[i] == 0) {
+            // Parallel to this boundary and outside of it
+            if (q[i] < 0)
+                return false;
+        }
+        else {
+            const double t = q[i] / p[i];
+
+            if (p[i] < 0) {
+                t_in = max(t_in, t);
+            }
+            else {
+                t_out = min(t_out, t);
+            }
+        }
+    }
+
+    // The ray doesn't cross the grid
+    if (t_in > t_out)
+        return false;
+
+    // First and last cells crossed by the ray
+    int cx = cellX(x0 + t_in * dx);
+    int cy = cellY(y0 + t_in * dy);
+    const int end_cx = cellX(x0 + t_out * dx);
+    const int end_cy = cellY(y0 + t_out * dy);
+
+    // Traversal parameters (Amanatides & Woo)
+    const int step_x = (dx > 0) - (dx < 0);
+    const int step_y = (dy > 0) - (dy < 0);
+
+    double t_max_x = qInf();
+    double t_max_y = qInf();
+    double t_delta_x = qInf();
+    double t_delta_y = qInf();
+
+    if (step_x != 0) {
+        const double next_x = m_bounds.left() + (cx + (step_x > 0 ? 1 : 0)) * m_cell_size;
+        t_max_x = (next_x - x0) / dx;
+        t_delta_x = m_cell_size / fabs(dx);
+    }
+    if (step_y != 0) {
+        const double next_y = m_bounds.top() + (cy + (step_y > 0 ? 1 : 0)) * m_cell_size;
+        t_max_y = (next_y - y0) / dy;
+        t_delta_y = m_cell_size / fabs(dy);
+    }
+
+    // The number of visited cells is bounded (protection against rounding errors)
+    const int max_steps = qAbs(end_cx - cx) + qAbs(end_cy - cy) + 1;
+
+    for (int i = 0 ; i < max_steps ; i++) {
+        if (cellIntersects(cx, cy, ray, origin_wall, target_wall)) {
+            return true;
+        }
+
+        // Move to the next cell crossed by the ray.
+        // An axis that already reached the last cell is not moved anymore.
+        if (cy == end_cy || (cx != end_cx && t_max_x < t_max_y)) {
+            cx += step_x;
+            t_max_x += t_delta_x;
+        }
+        else {
+            cy += step_y;
+            t_max_y += t_delta_y;
+        }
+    }
+
+    return false;
+}
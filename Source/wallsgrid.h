@@ -0,0 +1,53 @@
+#ifndef WALLSGRID_H
+#define WALLSGRID_H
+
+#include <QLineF>
+#include <QRectF>
+#include <QList>
+#include <QVector>
+
+class Wall;
+
+// Uniform grid over the walls of the scene (in meters), used to speed-up
+// the obstruction tests of the rays.
+class WallsGrid
+{
+public:
+    WallsGrid();
+
+    void build(const QList<Wall*> &walls_list);
+    void clear();
+
+    bool isEmpty() const;
+    bool intersects(const QLineF &ray, const Wall *origin_wall, const Wall *target_wall) const;
+
+private:
+    int cellX(double x) const;
+    int cellY(double y) const;
+    bool cellIntersects(
+            int cx,
+            int cy,
+            const QLineF &ray,
+            const Wall *origin_wall,
+            const Wall *target_wall) const;
+
+    QRectF m_bounds;
+    double m_cell_size;
+    int m_cols;
+    int m_rows;
+
+    // Compressed storage: the entries of the cell i are the indexes
+    // m_cells_start[i] to m_cells_start[i+1] - 1 of the entries arrays
+    QVector<int> m_cells_start;
+
+    // Entries of the cells, as a structure of arrays (contiguous values for the
+    // intersection tests): the wall, the first point of its real line (x1, y1),
+    // and the vector from its second point to its first point (bx, by)
+    QVector<const Wall*> m_entries_wall;
+    QVector<double> m_entries_x1;
+    QVector<double> m_entries_y1;
+    QVector<double> m_entries_bx;
+    QVector<double> m_entries_by;
+};
+
+#endif // WALLSGRID_H
@@ -0,0 +1,175 @@
+#include "workscheduler.h"
+#include "constants.h"
+
+// Number of chunks per worker (more chunks give a finer load balancing)
+#define CHUNKS_PER_WORKER   8
+
+// Maximum number of receivers in a chunk
+#define CHUNK_MAX_RECEIVERS 256
+
+
+WorkScheduler::WorkScheduler()
+{
+
+}
+
+WorkScheduler::~WorkScheduler()
+{
+    clear();
+}
+
+/**
+ * @brief WorkScheduler::clear
+ *
+ * This function removes all the receivers and the queues of the scheduler
+ */
+void WorkScheduler::clear() {
+    foreach (WorkerQueue *queue, m_queues) {
+        delete queue;
+    }
+
+    m_queues.clear();
+    m_receivers.clear();
+}
+
+int WorkScheduler::workersCount() const {
+    return m_queues.size();
+}
+
+int WorkScheduler::receiversCount() const {
+    return m_receivers.size();
+}
+
+/**
+ * @brief WorkScheduler::setup
+ * @param receivers
+ * @param costs
+ * @param workers_count
+ *
+ * This function splits the receivers into chunks of about the same estimated cost
+ * (costs[i] is the cost of receivers[i]), and distributes these chunks to the workers.
+ * The receivers are kept in their order, so the chunks of a worker are neighbours.
+ */
+void WorkScheduler::setup(const QList<Receiver*> &receivers, const QVector<double> &costs, int workers_count) {
+    clear();
+
+    m_receivers = receivers.toVector();
+
+    workers_count = max(1, workers_count);
+
+    for (int i = 0 ; i < workers_count ; i++) {
+        WorkerQueue *queue = new WorkerQueue;
+        queue->remaining_cost = 0;
+        m_queues.append(queue);
+    }
+
+    // Target cost of a chunk
+    double total_cost = 0;
+    foreach (double c, costs) {
+        total_cost += c;
+    }
+
+    const double chunk_cost = total_cost / (workers_count * CHUNKS_PER_WORKER);
+
+    // Split the receivers into chunks
+    QList<Chunk> chunks;
+    Chunk chunk = {0, 0, 0};
+
+    for (int i = 0 ; i < m_receivers.size() ; i++) {
+        chunk.end = i + 1;
+        chunk.cost += costs[i];
+
+        if (chunk.cost >= chunk_cost || chunk.end - chunk.begin >= CHUNK_MAX_RECEIVERS) {
+            chunks.append(chunk);
+            chunk = {i + 1, i + 1, 0};
+        }
+    }
+
+    if (chunk.end > chunk.begin) {
+        chunks.append(chunk);
+    }
+
+    // Give a contiguous sequence of chunks (of about the same total cost) to each worker
+    double assigned_cost = 0;
+
+    foreach (const Chunk &c, chunks) {
+        const int worker = min(workers_count - 1, (int) (assigned_cost / total_cost * workers_count));
+
+        m_queues[worker]->chunks.append(c);
+        m_queues[worker]->remaining_cost += c.cost;
+
+        assigned_cost += c.cost;
+    }
+}
+
+bool WorkScheduler::popFront(WorkerQueue *queue, Chunk *chunk) {
+    QMutexLocker locker(&queue->mutex);
+
+    if (queue->chunks.isEmpty())
+        return false;
+
+    *chunk = queue->chunks.takeFirst();
+    queue->remaining_cost -= chunk->cost;
+
+    return true;
+}
+
+bool WorkScheduler::popBack(WorkerQueue *queue, Chunk *chunk) {
+    QMutexLocker locker(&queue->mutex);
+
+    if (queue->chunks.isEmpty())
+        return false;
+
+    *chunk = queue->chunks.takeLast();
+    queue->remaining_cost -= chunk->cost;
+
+    return true;
+}
+
+/**
+ * @brief WorkScheduler::takeChunk
+ * @param worker
+ * @param chunk
+ * @return
+ *
+ * This function gives the next chunk of receivers to compute by the given worker.
+ * It returns false when there is no more work in all the queues.
+ */
+bool WorkScheduler::takeChunk(int worker, QList<Receiver*> *chunk) {
+    Chunk c;
+
+    // Take the next chunk of the own queue of the worker
+    bool found = popFront(m_queues[worker], &c);
+
+    // Else steal the last chunk of the most loaded queue
+    while (!found) {
+        WorkerQueue *victim = nullptr;
+        double victim_cost = 0;
+
+        for (int i = 0 ; i < m_queues.size() ; i++) {
+            // The remaining cost may change right after, it is only used as a hint
+            QMutexLocker locker(&m_queues[i]->mutex);
+
+            if (!m_queues[i]->chunks.isEmpty() && m_queues[i]->remaining_cost >= victim_cost) {
+                victim = m_queues[i];
+                victim_cost = m_queues[i]->remaining_cost;
+            }
+        }
+
+        // No more work
+        if (victim == nullptr)
+            return false;
+
+        // The victim queue may have been emptied in the meantime (then try again)
+        found = popBack(victim, &c);
+    }
+
+    chunk->clear();
+    chunk->reserve(c.end - c.begin);
+
+    for (int i = c.begin ; i < c.end ; i++) {
+        chunk->append(m_receivers[i]);
+    }
+
+    return true;
+}
@@ -0,0 +1,51 @@
+#ifndef WORKSCHEDULER_H
+#define WORKSCHEDULER_H
+
+#include <QList>
+#include <QMutex>
+#include <QVector>
+
+class Receiver;
+
+// Work-stealing scheduler of the receivers to compute.
+// The receivers are split into chunks of about the same estimated cost, and the chunks
+// are distributed to the queues of the workers. A worker takes the chunks from the front
+// of its own queue, and steals the chunks from the back of the most loaded queue
+// when its own queue is empty.
+class WorkScheduler
+{
+public:
+    WorkScheduler();
+    ~WorkScheduler();
+
+    void setup(const QList<Receiver*> &receivers, const QVector<double> &costs, int workers_count);
+    void clear();
+
+    int workersCount() const;
+    int receiversCount() const;
+
+    bool takeChunk(int worker, QList<Receiver*> *chunk);
+
+private:
+    // Range of receivers [begin, end[ and its estimated cost
+    struct Chunk {
+        int begin;
+        int end;
+        double cost;
+    };
+
+    // Queue of chunks of one worker (the remaining cost is used to choose a victim)
+    struct WorkerQueue {
+        QMutex mutex;
+        QList<Chunk> chunks;
+        double remaining_cost;
+    };
+
+    bool popFront(WorkerQueue *queue, Chunk *chunk);
+    bool popBack(WorkerQueue *queue, Chunk *chunk);
+
+    QVector<Receiver*> m_receivers;
+    QVector<WorkerQueue*> m_queues;
+};
+
+#endif // WORKSCHEDULER_H